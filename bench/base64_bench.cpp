@@ -0,0 +1,150 @@
+#include "bench.h"
+
+#include <Base64.h>
+
+#include <vector>
+
+#include "base64_stream.h"
+#include "payload_sink.h"
+
+// Payloads of 1, 10 and 100 KB through agdl/Base64, which needs the whole
+// input and the whole output in RAM at once, and through the streaming
+// codec. Encoding is fed 256 B at a time, as a payload being produced;
+// decoding PAYLOAD_CHUNK_SIZE characters at a time, as PubSubClient hands
+// the payload sink what comes off the socket. "pieces" is the buffer API
+// writing into one output buffer, "Print" the codec passing its output
+// on BASE64_CHUNK_SIZE at a time to a Print that only counts it. Peak
+// memory is what each has to hold at once: the buffers, and for the codec
+// one piece, its stack chunk and itself. Every result is checked against
+// the library's.
+static const size_t SIZES[] = {1024, 10240, 102400};
+static const size_t PRODUCED = 256;
+
+class CountingPrint : public Print
+{
+    public:
+    uint32_t count = 0;
+    uint32_t sum = 0;
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+        for (size_t i = 0; i < size; ++i)
+            sum = sum * 31 + buffer[i];
+        count += size;
+        return size;
+    }
+};
+
+static uint32_t checksum(const uint8_t *data, size_t size)
+{
+    CountingPrint c;
+    c.write(data, size);
+    return c.sum;
+}
+
+static double mbPerSecond(size_t bytes, double ns)
+{
+    return bytes * 1000.0 / ns;
+}
+
+BENCH(base64)
+{
+    printf("%-13s %11s %11s %11s   %s\n", "", "agdl", "pieces", "Print", "peak agdl / stream");
+    for (size_t size : SIZES)
+    {
+        std::vector<uint8_t> data(size);
+        uint32_t seed = size;
+        for (uint8_t &b : data)
+        {
+            seed = seed * 1103515245 + 12345;
+            b = seed >> 16;
+        }
+        size_t textLength = base64_enc_len(size);
+        std::vector<char> text(textLength + 1);
+        std::vector<char> streamed(textLength + 4);
+        std::vector<uint8_t> decoded(size + 3);
+        uint32_t iterations = max((size_t)20, 4000000 / size);
+        bool ok = true;
+
+        double agdlEncodeNs = benchNanos(iterations, [&](uint32_t) {
+            base64_encode(text.data(), (char *)data.data(), size);
+            benchKeep(text[0]);
+        });
+        Base64Encoder encoder;
+        double piecesEncodeNs = benchNanos(iterations, [&](uint32_t) {
+            size_t n = 0;
+            for (size_t i = 0; i < size; i += PRODUCED)
+                n += encoder.encode(data.data() + i, min(PRODUCED, size - i), streamed.data() + n);
+            n += encoder.finish(streamed.data() + n);
+            benchKeep(streamed[n - 1]);
+        });
+        ok = ok && memcmp(streamed.data(), text.data(), textLength) == 0;
+        CountingPrint encodedOut;
+        Base64Encoder printEncoder(&encodedOut);
+        double printEncodeNs = benchNanos(iterations, [&](uint32_t) {
+            encodedOut.count = 0;
+            encodedOut.sum = 0;
+            for (size_t i = 0; i < size; i += PRODUCED)
+                printEncoder.write(data.data() + i, min(PRODUCED, size - i));
+            printEncoder.finish();
+        });
+        ok = ok && encodedOut.count == textLength && encodedOut.sum == checksum((uint8_t *)text.data(), textLength);
+
+        double agdlDecodeNs = benchNanos(iterations, [&](uint32_t) {
+            base64_decode((char *)decoded.data(), text.data(), textLength);
+            benchKeep(decoded[0]);
+        });
+        ok = ok && memcmp(decoded.data(), data.data(), size) == 0;
+        Base64Decoder decoder;
+        double piecesDecodeNs = benchNanos(iterations, [&](uint32_t) {
+            size_t n = 0;
+            for (size_t i = 0; i < textLength; i += PAYLOAD_CHUNK_SIZE)
+                n += decoder.decode(text.data() + i, min((size_t)PAYLOAD_CHUNK_SIZE, textLength - i), decoded.data() + n);
+            n += decoder.finish(decoded.data() + n);
+            benchKeep(decoded[n - 1]);
+        });
+        ok = ok && memcmp(decoded.data(), data.data(), size) == 0 && !decoder.error();
+        CountingPrint decodedOut;
+        Base64Decoder printDecoder(&decodedOut);
+        double printDecodeNs = benchNanos(iterations, [&](uint32_t) {
+            decodedOut.count = 0;
+            decodedOut.sum = 0;
+            for (size_t i = 0; i < textLength; i += PAYLOAD_CHUNK_SIZE)
+                printDecoder.write((const uint8_t *)text.data() + i, min((size_t)PAYLOAD_CHUNK_SIZE, textLength - i));
+            ok = printDecoder.finish() && ok;
+        });
+        ok = ok && decodedOut.count == size && decodedOut.sum == checksum(data.data(), size);
+
+        size_t agdlPeak = size + textLength + 1;
+        size_t encodePeak = PRODUCED + sizeof(Base64Encoder) + Base64Encoder::encodedLength(BASE64_CHUNK_SIZE + 2);
+        size_t decodePeak = PAYLOAD_CHUNK_SIZE + sizeof(Base64Decoder) + BASE64_CHUNK_SIZE;
+        printf("%3u KB encode %6.0f MB/s %6.0f MB/s %6.0f MB/s   %6u B / %u B\n", (unsigned)(size / 1024),
+               mbPerSecond(size, agdlEncodeNs), mbPerSecond(size, piecesEncodeNs), mbPerSecond(size, printEncodeNs),
+               (unsigned)agdlPeak, (unsigned)encodePeak);
+        printf("%3u KB decode %6.0f MB/s %6.0f MB/s %6.0f MB/s   %6u B / %u B  %s\n", (unsigned)(size / 1024),
+               mbPerSecond(size, agdlDecodeNs), mbPerSecond(size, piecesDecodeNs), mbPerSecond(size, printDecodeNs),
+               (unsigned)agdlPeak, (unsigned)decodePeak, benchCheck(ok) ? "matches agdl" : "MISMATCH");
+    }
+
+    // a character at a time, line breaks and bad input
+    struct Case
+    {
+        const char *label, *text;
+    };
+    static const Case CASES[] = {{"TWFu", "TWFu"}, {"TWE=", "TWE="}, {"TQ==", "TQ=="}, {"TWE", "TWE"}, {"TQ", "TQ"},
+                                 {"T", "T"}, {"TW\\r\\nFu", "TW\r\nFu\r\n"}, {"TW=u", "TW=u"}, {"TW!u", "TW!u"}};
+    printf("  bytes out:");
+    for (const Case &c : CASES)
+    {
+        CountingPrint out;
+        Base64Decoder d(&out);
+        for (const char *p = c.text; *p; ++p)
+            d.write(*p);
+        if (d.finish())
+            printf(" %s %u", c.label, (unsigned)out.count);
+        else
+            printf(" %s error", c.label);
+    }
+    printf("\n");
+}
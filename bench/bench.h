@@ -0,0 +1,48 @@
+#pragma once
+
+// Host micro-benchmarks, built by [env:native_bench]. Each bench registers
+// itself with BENCH(name) and prints its own results, and passes what it
+// checks of them through benchCheck(): the program exits non-zero when a
+// check failed.
+//   pio run -e native_bench && .pio/build/native_bench/program [name...]
+
+#include <Arduino.h>
+
+#include <chrono>
+
+typedef void (*BenchFunction)();
+
+struct BenchEntry
+{
+    const char *name;
+    BenchFunction run;
+    BenchEntry *next;
+
+    BenchEntry(const char *benchName, BenchFunction fn);
+};
+
+#define BENCH(name)                                        \
+    static void bench_##name();                            \
+    static BenchEntry bench_entry_##name(#name, bench_##name); \
+    static void bench_##name()
+
+// records a failed check against the running bench, returns ok
+bool benchCheck(bool ok);
+
+// nanoseconds per call of op, averaged over iterations
+template <typename Op>
+double benchNanos(uint32_t iterations, Op op)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+        op(i);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / iterations;
+}
+
+// keeps the optimiser from discarding a benchmark's result
+template <typename T>
+inline void benchKeep(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
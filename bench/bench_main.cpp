@@ -0,0 +1,53 @@
+#include "bench.h"
+
+#include <HostSim.h>
+
+static BenchEntry *s_benches = nullptr;
+static uint32_t s_failedChecks = 0;
+
+BenchEntry::BenchEntry(const char *benchName, BenchFunction fn) : name(benchName), run(fn), next(s_benches)
+{
+    s_benches = this;
+}
+
+bool benchCheck(bool ok)
+{
+    if (!ok)
+        ++s_failedChecks;
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    // firmware debug output would drown the results
+    HostSim::setSerialEnabled(false);
+
+    int ran = 0, failed = 0;
+    for (BenchEntry *b = s_benches; b; b = b->next)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+            selected |= strcmp(argv[i], b->name) == 0;
+        if (!selected)
+            continue;
+        printf("--- %s\n", b->name);
+        uint32_t failedChecks = s_failedChecks;
+        b->run();
+        if (s_failedChecks != failedChecks)
+        {
+            printf("--- %s FAILED %lu checks\n", b->name, (unsigned long)(s_failedChecks - failedChecks));
+            ++failed;
+        }
+        fflush(stdout);
+        ++ran;
+    }
+    if (!ran)
+    {
+        fprintf(stderr, "no benchmark matched; available:");
+        for (BenchEntry *b = s_benches; b; b = b->next)
+            fprintf(stderr, " %s", b->name);
+        fprintf(stderr, "\n");
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+#include "bench.h"
+
+#include <TFT_eSPI.h>
+
+#include "hit_index.h"
+#include "keyboard.h"
+#include "select_box.h"
+
+// Per-sample cost of resolving a touch on the Wi-Fi screen: the linear
+// contains()/press() scan wifiSetup() used to do over 2 boxes and 42 keys,
+// against the row index plus press() on the widgets that changed.
+BENCH(hit_index)
+{
+    static TFT_eSPI tft;
+    static TFT_Keyboard keyboard;
+    static TFT_Select_Box boxes[2];
+    static String ssid, password;
+    tft.init();
+    tft.setRotation(1);
+    keyboard.init(&tft);
+    keyboard.draw(&keyboardQwerty, false, false);
+    boxes[0].init(&tft, 40, 20, 150, 20, TFT_WHITE, TFT_BLACK, TFT_WHITE, TFT_GREEN, &ssid, 1);
+    boxes[1].init(&tft, 281, 20, 150, 20, TFT_WHITE, TFT_BLACK, TFT_WHITE, TFT_GREEN, &password, 1);
+
+    TFT_Hit_Index index;
+    for (uint8_t i = 0; i < KEYBOARD_KEYS; ++i)
+    {
+        int16_t x, y;
+        uint16_t w, h;
+        keyboard.keyRect(i, x, y, w, h);
+        index.add(i, x, y, w, h);
+    }
+    index.add(KEYBOARD_KEYS, 40, 20, 150, 20);
+    index.add(KEYBOARD_KEYS + 1, 281, 20, 150, 20);
+
+    // a touch every few samples, held for a few samples, anywhere on the panel
+    const uint32_t SAMPLES = 4096;
+    static struct
+    {
+        bool touched;
+        int16_t x, y;
+    } trace[SAMPLES];
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < SAMPLES; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        bool start = ((seed >> 16) % 4) == 0;
+        if (i > 0 && trace[i - 1].touched && !start)
+        {
+            trace[i] = trace[i - 1];
+            trace[i].touched = ((seed >> 20) % 3) != 0;
+            continue;
+        }
+        trace[i].touched = start;
+        trace[i].x = (seed >> 8) % 480;
+        trace[i].y = (seed >> 3) % 320;
+    }
+
+    // both strategies must agree on what was pressed
+    uint32_t linearPresses = 0, indexPresses = 0;
+
+    const uint32_t ITERATIONS = 2000000;
+    double linear = benchNanos(ITERATIONS, [&](uint32_t n) {
+        const auto &t = trace[n % SAMPLES];
+        for (uint8_t i = 0; i < 2; ++i)
+            boxes[i].press(t.touched && boxes[i].contains(t.x, t.y));
+        for (uint8_t i = 0; i < 2; ++i)
+            linearPresses += boxes[i].justPressed();
+        for (uint8_t i = 0; i < KEYBOARD_KEYS; ++i)
+            keyboard.key(i).press(t.touched && keyboard.key(i).contains(t.x, t.y));
+        for (uint8_t i = 0; i < KEYBOARD_KEYS; ++i)
+            linearPresses += keyboard.key(i).justPressed();
+    });
+
+    double indexed = benchNanos(ITERATIONS, [&](uint32_t n) {
+        const auto &t = trace[n % SAMPLES];
+        uint8_t changed[3];
+        uint8_t count = index.update(t.touched, t.x, t.y, changed);
+        for (uint8_t c = 0; c < count; ++c)
+        {
+            uint8_t id = changed[c];
+            if (id >= KEYBOARD_KEYS)
+            {
+                boxes[id - KEYBOARD_KEYS].press(index.isDown(id));
+                indexPresses += boxes[id - KEYBOARD_KEYS].justPressed();
+            }
+            else
+            {
+                keyboard.key(id).press(index.isDown(id));
+                indexPresses += keyboard.key(id).justPressed();
+            }
+        }
+    });
+
+    benchKeep(linearPresses);
+    benchKeep(indexPresses);
+    printf("linear scan  %8.1f ns/sample (%u presses)\n", linear, linearPresses);
+    printf("hit index    %8.1f ns/sample (%u presses)\n", indexed, indexPresses);
+    printf("speedup      %8.1fx\n", linear / indexed);
+
+    double lookups = benchNanos(ITERATIONS, [&](uint32_t n) {
+        const auto &t = trace[n % SAMPLES];
+        benchKeep(index.find(t.x, t.y));
+    });
+    printf("find() alone %8.1f ns/lookup\n", lookups);
+}
@@ -0,0 +1,172 @@
+#include "bench.h"
+
+#include <HostSim.h>
+#include <TFT_eSPI.h>
+
+#include <map>
+#include <vector>
+
+#include "image_decoder.h"
+#include "payload_sink.h"
+
+// Three pictures the size of the drawing area, encoded as tools/png2mbi.py
+// does and fed to the decoder a PAYLOAD_CHUNK_SIZE piece at a time, as the
+// payload sink or the inbox spool hands them over: a photo with too many
+// colours for a palette, a drawing in the canvas colours, and a screenshot
+// of flat panels and text. Every pixel drawn is checked against the source.
+// Host time includes the simulated panel; panel time is what the pixels and
+// address windows cost on the bus.
+static const uint16_t W = 416;
+static const uint16_t H = 320;
+
+typedef std::vector<uint16_t> Picture;
+
+static Picture photo()
+{
+    Picture p(W * H);
+    uint32_t seed = 5;
+    for (uint16_t y = 0; y < H; ++y)
+        for (uint16_t x = 0; x < W; ++x)
+        {
+            seed = seed * 1103515245 + 12345;
+            uint8_t noise = (seed >> 16) & 7;
+            uint8_t r = (x * 255 / W + noise) & 0xFF, g = (y * 255 / H + noise) & 0xFF, b = ((x ^ y) + noise) & 0xFF;
+            p[y * W + x] = (r >> 3) << 11 | (g >> 2) << 5 | b >> 3;
+        }
+    return p;
+}
+
+static Picture drawing()
+{
+    static const uint16_t INK[] = {TFT_BLACK, TFT_RED, TFT_BLUE};
+    Picture p(W * H, TFT_CYAN);
+    for (uint16_t y = 0; y < H; ++y)
+        for (uint16_t x = 0; x < W; ++x)
+        {
+            // wavy strokes 3 px wide
+            int16_t wave = (int16_t)(y % 64) - (int16_t)((x * 7 / 5) % 64);
+            if (wave >= 0 && wave < 3 && (x / 50) % 3 != 2)
+                p[y * W + x] = INK[(y / 64) % 3];
+        }
+    return p;
+}
+
+static Picture screenshot()
+{
+    Picture p(W * H, TFT_DARKGREY);
+    for (uint16_t y = 0; y < H; ++y)
+        for (uint16_t x = 0; x < W; ++x)
+        {
+            if (y < 30)
+                p[y * W + x] = TFT_NAVY;
+            else if (x > 20 && x < W - 20 && y > 50 && y < H - 20)
+                p[y * W + x] = TFT_WHITE;
+            // lines of text-like speckle
+            if (y > 60 && y < H - 30 && (y - 60) % 20 < 10 && x > 30 && x < W - 30 && ((x * 31 + y * 17) % 7) < 2)
+                p[y * W + x] = TFT_BLACK;
+        }
+    return p;
+}
+
+// the packets png2mbi.py writes
+static void encodeRow(std::vector<uint8_t> &out, const uint16_t *row, uint16_t w, bool palette,
+                      std::map<uint16_t, uint8_t> &index)
+{
+    uint16_t minRun = palette ? 3 : 2;
+    auto put = [&](uint16_t c) {
+        if (palette)
+            out.push_back(index[c]);
+        else
+        {
+            out.push_back(c & 0xFF);
+            out.push_back(c >> 8);
+        }
+    };
+    auto runAt = [&](uint16_t i, uint16_t limit) {
+        uint16_t run = 1;
+        while (i + run < w && run < limit && row[i + run] == row[i])
+            ++run;
+        return run;
+    };
+    for (uint16_t i = 0; i < w;)
+    {
+        uint16_t run = runAt(i, 128);
+        if (run >= minRun)
+        {
+            out.push_back(127 + run);
+            put(row[i]);
+            i += run;
+            continue;
+        }
+        uint16_t start = i;
+        while (i < w && i - start < 128 && runAt(i, minRun) < minRun)
+            ++i;
+        out.push_back(i - start - 1);
+        for (uint16_t j = start; j < i; ++j)
+            put(row[j]);
+    }
+}
+
+static std::vector<uint8_t> encode(const Picture &p, bool &palette)
+{
+    std::map<uint16_t, uint8_t> index;
+    for (uint16_t c : p)
+        if (index.size() <= 256)
+            index.emplace(c, 0);
+    palette = index.size() <= 256;
+    std::vector<uint8_t> out = {IMAGE_MAGIC, IMAGE_VERSION, (uint8_t)palette,
+                                (uint8_t)(palette ? index.size() - 1 : 0), W & 0xFF, W >> 8, H & 0xFF, H >> 8};
+    if (palette)
+    {
+        uint8_t i = 0;
+        for (auto &entry : index)
+        {
+            entry.second = i++;
+            out.push_back(entry.first & 0xFF);
+            out.push_back(entry.first >> 8);
+        }
+    }
+    for (uint16_t y = 0; y < H; ++y)
+        encodeRow(out, &p[y * W], W, palette, index);
+    return out;
+}
+
+BENCH(image_decoder)
+{
+    static TFT_eSPI tft;
+    tft.init();
+    tft.setRotation(1);
+    static ImageDecoder decoder;
+
+    struct Sample
+    {
+        const char *name;
+        Picture picture;
+    };
+    Sample samples[] = {{"photo", photo()}, {"drawing", drawing()}, {"screenshot", screenshot()}};
+
+    printf("%ux%u pictures in %u B pieces, %u B of decoder against %u B for the picture\n", W, H,
+           PAYLOAD_CHUNK_SIZE, (unsigned)sizeof(ImageDecoder), (unsigned)(W * H * 2));
+    for (const Sample &s : samples)
+    {
+        bool palette;
+        std::vector<uint8_t> message = encode(s.picture, palette);
+
+        HostSim::resetStats();
+        auto start = std::chrono::steady_clock::now();
+        decoder.begin(&tft, 64, 0);
+        for (size_t i = 0; i < message.size(); i += PAYLOAD_CHUNK_SIZE)
+            decoder.write(message.data() + i, min(message.size() - i, (size_t)PAYLOAD_CHUNK_SIZE));
+        double hostUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        uint32_t panelUs = HostSim::spiMicros(HostSim::stats().total);
+
+        uint32_t wrong = 0;
+        for (uint16_t y = 0; y < H; ++y)
+            for (uint16_t x = 0; x < W; ++x)
+                wrong += HostSim::pixel(64 + x, y) != s.picture[y * W + x];
+
+        printf("  %-10s %-7s %6u B %5.1f%% of RGB565  host %6.1f Mpx/s  panel %5.2f Mpx/s  %s\n", s.name,
+               palette ? "palette" : "RGB565", (unsigned)message.size(), 100.0 * message.size() / (W * H * 2),
+               W * H / hostUs, (double)W * H / panelUs, benchCheck(decoder.done() && !wrong) ? "exact" : "WRONG");
+    }
+}
@@ -0,0 +1,122 @@
+#include "bench.h"
+
+#include <FS.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <HostSim.h>
+#include <TFT_eSPI.h>
+
+#include "keyboard.h"
+
+// Entering the Wi-Fi screen, Shift with its key held down, Sym, and on to
+// the numeric pad: every key rasterised straight to the panel, then with the
+// cached bitmaps, which send only the pixels that differ from what the panel
+// shows. Each step has to take the bitmap, send less, and leave the panel
+// identical. Last begin() has to remove a bitmap no current layout uses and
+// keep the rest.
+struct Step
+{
+    const char *label;
+    const KeyboardLayout *layout;
+    bool shift;
+    bool clear;
+};
+
+static const Step STEPS[] = {{"enter", &keyboardQwerty, false, true},
+                             {"Shift", &keyboardQwerty, true, false},
+                             {"Sym", &keyboardSymbols, false, false},
+                             {"to numeric", &keyboardNumeric, false, false},
+                             {"enter again", &keyboardQwerty, false, true}};
+static const uint8_t STEP_COUNT = sizeof(STEPS) / sizeof(STEPS[0]);
+
+struct StepCost
+{
+    uint32_t windows;
+    uint64_t bytes;
+    uint32_t hash;
+};
+
+BENCH(keyboard_cache)
+{
+    SPIFFS.begin();
+    static TFT_eSPI tft;
+    tft.init();
+    tft.setRotation(1);
+    static TFT_Keyboard keyboard;
+
+    StepCost cost[2][STEP_COUNT];
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        printf("%s:\n", pass ? "cached bitmaps" : "direct");
+        keyboard.useCache(pass == 1);
+        for (uint8_t i = 0; i < STEP_COUNT; ++i)
+        {
+            const Step &step = STEPS[i];
+            if (step.clear)
+            {
+                tft.fillScreen(KEYBOARD_BACKGROUND);
+                keyboard.init(&tft);
+            }
+            // as a touch on Shift does it
+            TFT_eSPI_Button &shiftKey = keyboard.key(TFT_Keyboard::Shift);
+            if (step.shift)
+            {
+                shiftKey.press(true);
+                keyboard.invalidateKey(TFT_Keyboard::Shift);
+            }
+            HostSim::resetStats();
+            keyboard.setLayout(step.layout, false, step.shift);
+            keyboard.update();
+            const HostSim::SpiCost &spi = HostSim::stats().total;
+            cost[pass][i] = {spi.windows, spi.bytes, HostSim::framebufferHash()};
+            printf("  %-24s %5u windows %7llu B  %6u us\n", step.label, spi.windows, (unsigned long long)spi.bytes,
+                   HostSim::spiMicros(spi));
+            if (step.shift)
+            {
+                shiftKey.press(false);
+                keyboard.invalidateKey(TFT_Keyboard::Shift);
+                keyboard.update();
+            }
+        }
+    }
+
+    printf("bitmap taken, cheaper, panel identical:\n");
+    for (uint8_t i = 0; i < STEP_COUNT; ++i)
+    {
+        const StepCost &direct = cost[0][i], &cached = cost[1][i];
+        bool taken = cached.windows != direct.windows;
+        bool cheaper = cached.bytes < direct.bytes;
+        bool identical = cached.hash == direct.hash;
+        printf("  %-24s %s %s %s  %5.1f%% of the bytes%s\n", STEPS[i].label, taken ? "yes" : "NO ",
+               cheaper ? "yes" : "NO ", identical ? "yes" : "NO ", 100.0 * cached.bytes / direct.bytes,
+               benchCheck(taken && cheaper && identical) ? "" : "  FAIL");
+    }
+
+    // a bitmap of a layout since dropped
+    static const KeyboardLayout *const layouts[] = {&keyboardQwerty, &keyboardSymbols, &keyboardNumeric};
+    File stale = SPIFFS.open("/kb0badcafe", "w");
+    stale.write((const uint8_t *)"old", 3);
+    stale.close();
+    keyboard.begin(&tft, layouts, sizeof(layouts) / sizeof(layouts[0]));
+    printf("begin(): stale bitmap %s\n", SPIFFS.exists("/kb0badcafe") ? "KEPT" : "removed");
+
+    DIR *dir = opendir(HostSim::spiffsDir());
+    while (struct dirent *entry = dir ? readdir(dir) : nullptr)
+    {
+        if (strncmp(entry->d_name, "kb", 2) != 0)
+            continue;
+        struct stat st;
+        String path = String(HostSim::spiffsDir()) + "/" + entry->d_name;
+        stat(path.c_str(), &st);
+        // w and h of the cache header, after magic, hash, x and y
+        File f = SPIFFS.open(String("/") + entry->d_name, "r");
+        uint16_t wh[2] = {};
+        if (f && f.seek(12) && f.read((uint8_t *)wh, sizeof(wh)) == sizeof(wh))
+            printf("/%s %6ld B for %ux%u px (%u B raw RGB565)\n", entry->d_name, (long)st.st_size, wh[0], wh[1],
+                   wh[0] * wh[1] * 2);
+        if (f)
+            f.close();
+    }
+    if (dir)
+        closedir(dir);
+}
@@ -0,0 +1,101 @@
+#include "bench.h"
+
+#include <HostSim.h>
+
+#include "logger.h"
+
+// The scheduler report of a debug build, a burst of lines at once, printed
+// straight to Serial and logged into the ring, at the monitor's 921600 baud
+// and at 115200. Serial.printf() holds the loop until the last byte is in the
+// UART FIFO; the logger returns once the lines are formatted and the loop
+// then drains them a FIFO at a time when it would otherwise sleep.
+static const uint8_t LINES = 16;
+static const char *const TASKS[] = {"wifi", "mqtt", "inbox", "screen"};
+
+#define REPORT_LINE "  %-10s runs %6lu  late avg %6lu us max %7lu us  run max %7lu us"
+
+struct BurstCost
+{
+    uint32_t callerUs;   // the loop held up by the burst itself
+    uint32_t maxDrainUs; // longest single drain()
+    uint32_t drains;
+    uint32_t outMs;      // until the last byte left
+    uint32_t bytes;
+};
+
+static void settle(uint32_t baud)
+{
+    Serial.begin(baud);
+    delay(100);
+}
+
+// until the last byte is on the wire
+static uint32_t sentMs(uint32_t start)
+{
+    while (Serial.availableForWrite() < (int)HostSim::UART_FIFO_BYTES)
+        delayMicroseconds(10);
+    return (micros() - start) / 1000;
+}
+
+static BurstCost direct(uint32_t baud)
+{
+    BurstCost cost = {};
+    settle(baud);
+    uint32_t start = micros();
+    for (uint8_t i = 0; i < LINES; ++i)
+        cost.bytes += Serial.printf(REPORT_LINE "\n", TASKS[i % 4], 1000UL + i, 12UL * i, 480UL * i, 2100UL + i);
+    cost.callerUs = micros() - start;
+    cost.outMs = sentMs(start);
+    return cost;
+}
+
+static BurstCost logged(uint32_t baud)
+{
+    static Logger log;
+    BurstCost cost = {};
+    settle(baud);
+    log.resetStats();
+    log.begin(Serial);
+    uint32_t start = micros();
+    for (uint8_t i = 0; i < LINES; ++i)
+        log.log(LOG_LEVEL_DEBUG, PSTR(REPORT_LINE), TASKS[i % 4], 1000UL + i, 12UL * i, 480UL * i, 2100UL + i);
+    cost.callerUs = micros() - start;
+    cost.bytes = log.stats().bytes;
+
+    // as Scheduler::run() does when nothing is due
+    bool more = true;
+    while (more)
+    {
+        uint32_t drainStart = micros();
+        more = log.drain();
+        cost.maxDrainUs = max(cost.maxDrainUs, (uint32_t)(micros() - drainStart));
+        ++cost.drains;
+        if (more)
+            delay(1);
+    }
+    cost.outMs = sentMs(start);
+    return cost;
+}
+
+BENCH(logger)
+{
+    static const uint32_t BAUDS[] = {921600, 115200};
+    HostSim::setSerialEnabled(false);
+
+    printf("%u report lines in one burst\n", LINES);
+    for (uint32_t baud : BAUDS)
+    {
+        BurstCost serial = direct(baud);
+        BurstCost ring = logged(baud);
+        printf("  %6lu baud  Serial.printf  %5lu us blocked, %4lu B out in %3lu ms\n", (unsigned long)baud,
+               (unsigned long)serial.callerUs, (unsigned long)serial.bytes, (unsigned long)serial.outMs);
+        printf("  %6lu baud  logger         %5lu us blocked, %4lu B out in %3lu ms, %3lu drains of max %lu us\n",
+               (unsigned long)baud, (unsigned long)ring.callerUs, (unsigned long)ring.bytes,
+               (unsigned long)ring.outMs, (unsigned long)ring.drains, (unsigned long)ring.maxDrainUs);
+    }
+    printf("  ring %u B, %u B of RAM\n", LOG_RING_SIZE, (unsigned)sizeof(Logger));
+
+    // the rest of the benches write to a Serial that costs nothing
+    Serial.begin(0);
+    HostSim::setSerialEnabled(true);
+}
@@ -0,0 +1,109 @@
+#include "bench.h"
+
+#include <HostSim.h>
+#include <PubSubClient.h>
+
+#include "message_ring.h"
+
+// A burst of 100 messages through the old OnMessage() (String += per char)
+// and through the message ring, reporting the simulated heap before and after.
+// Between messages the UI keeps a status line String alive, as any screen
+// that shows "n bytes from x" would, so the growing buffer has neighbours.
+static const uint32_t BURST = 100;
+static const uint32_t MAX_PAYLOAD = 4000;
+
+static void printHeap(const char *label)
+{
+    HostSim::HeapStats heap = HostSim::heapStats();
+    printf("  %-8s free %5u B  max block %5u B  blocks %3u  fragmentation %3u%%\n",
+           label, heap.free, heap.maxBlock, heap.usedBlocks, ESP.getHeapFragmentation());
+}
+
+static void makeBurst(std::vector<std::vector<uint8_t>> &burst)
+{
+    uint32_t seed = 2024;
+    for (uint32_t i = 0; i < BURST; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        std::vector<uint8_t> payload(16 + (seed >> 8) % MAX_PAYLOAD);
+        for (size_t b = 0; b < payload.size(); ++b)
+            payload[b] = 'a' + (b + i) % 26;
+        burst.push_back(payload);
+    }
+}
+
+BENCH(message_ring)
+{
+    // the 10 KB PubSubClient buffer MQTTSetup() used to ask for lives on the heap too
+    static PubSubClient client;
+    client.setBufferSize(10000);
+
+    std::vector<std::vector<uint8_t>> burst;
+    makeBurst(burst);
+
+    printf("String += per char:\n");
+    printHeap("before");
+    {
+        String displayMessage = "";
+        String status;
+        uint32_t failed = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < BURST; ++i)
+        {
+            const std::vector<uint8_t> &payload = burst[i];
+            displayMessage = "";
+            for (size_t b = 0; b < payload.size(); ++b)
+                displayMessage += (char)payload[b];
+            failed += displayMessage.length() != payload.size();
+            status = String(payload.size()) + " bytes from MessageBox/" + String(i);
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        printHeap("after");
+        printf("  %.1f us/message, %u messages lost to allocation failure\n", us / BURST, failed);
+    }
+
+    printf("message ring (%u slots x %u B, static):\n", MESSAGE_RING_SLOTS, MESSAGE_SLOT_SIZE);
+    static MessageRing inbox;
+    static char displayMessage[MESSAGE_SLOT_SIZE + 1];
+    printHeap("before");
+    {
+        String status;
+        uint32_t truncated = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < BURST; ++i)
+        {
+            inbox.push(burst[i].data(), burst[i].size());
+            // the UI drains every other loop, so the ring is exercised
+            if (i % 2 == 0)
+                continue;
+            while (const MessageSlot *message = inbox.peek())
+            {
+                memcpy(displayMessage, message->data, message->length + 1);
+                truncated += message->length != message->received;
+                inbox.pop();
+            }
+            status = String(burst[i].size()) + " bytes from MessageBox/" + String(i);
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        benchKeep(displayMessage);
+        printHeap("after");
+        printf("  %.1f us/message, %u dropped, %u truncated to the slot size\n", us / BURST, inbox.dropped(), truncated);
+    }
+
+    // payloads spooled to SPIFFS while the UI is busy keep a file each
+    while (inbox.peek())
+        inbox.pop();
+    const char *files[MESSAGE_RING_SLOTS - 1];
+    uint8_t distinct = 0;
+    for (uint8_t i = 0; i < MESSAGE_RING_SLOTS - 1; ++i)
+    {
+        files[i] = inbox.nextFile();
+        inbox.pushFile(files[i], 2000);
+        distinct += i == 0 || strcmp(files[i], files[i - 1]) != 0;
+    }
+    bool ok = benchCheck(distinct == MESSAGE_RING_SLOTS - 1 && !inbox.nextFile());
+    printf("  %u spooled payloads in %u files, %s to %s%s\n", MESSAGE_RING_SLOTS - 1, distinct, files[0],
+           files[MESSAGE_RING_SLOTS - 2], ok ? "" : "  FAIL");
+    while (inbox.peek())
+        inbox.pop();
+}
@@ -0,0 +1,249 @@
+#include "bench.h"
+
+#include <ESP8266WiFi.h>
+#include <FS.h>
+#include <HostSim.h>
+#include <PubSubClient.h>
+
+#include <memory>
+
+#include "mqtt_connection.h"
+#include "outbound_queue.h"
+#include "topic_router.h"
+
+// Replays 90 s of outbound traffic, a message every 200 ms of 40 to 900 B,
+// against the stand-in broker going away on a schedule. The device restarts
+// in the middle of one outage with half a record at the end of the spool, as
+// a reset during an append leaves it. Every message the broker saw is checked
+// against what was published: all of them, once, in order, intact. Run with
+// the default rate limits and with none, for how hard a reconnect hits the
+// link. Last a reset in the middle of compacting the spool has to keep
+// every message in it.
+static const char *SPOOL = "/outbox.bench";
+static const char *TOPIC = "MessageBox/out";
+static const uint32_t PUBLISH_MS = 200;
+static const uint32_t TRAFFIC_MS = 90000;
+static const uint32_t RUN_MS = 150000;
+static const uint32_t RESTART_MS = 62000;
+
+struct Outage
+{
+    uint32_t fromMs, toMs; // equal for a dropped connection
+};
+static const Outage OUTAGES[] = {{15000, 22000}, {40000, 40000}, {55000, 70000}, {80000, 83000}};
+
+struct ReplayResult
+{
+    uint32_t published, delivered, duplicates, reordered, corrupt, lost;
+    uint32_t maxSpoolBytes, peakMessages, peakBytes;
+    OutboundQueue::Stats stats;
+};
+
+static std::vector<uint8_t> payloadFor(uint32_t seq)
+{
+    std::vector<uint8_t> payload(40 + (seq * 137) % 860);
+    for (size_t i = 0; i < payload.size(); ++i)
+        payload[i] = (uint8_t)(seq * 7 + i);
+    memcpy(payload.data(), &seq, sizeof(seq));
+    return payload;
+}
+
+static ReplayResult replay(MqttConnection &connection, uint8_t batch, uint16_t messagesPerSecond,
+                           uint32_t bytesPerSecond)
+{
+    ReplayResult result = {};
+    SPIFFS.remove(SPOOL);
+    HostSim::setBrokerAvailable(true);
+    HostSim::brokerClearPublished();
+
+    std::unique_ptr<OutboundQueue> queue(new OutboundQueue(connection, SPOOL));
+    queue->setLimits(batch, messagesPerSecond, bytesPerSecond);
+    queue->begin();
+
+    std::vector<uint32_t> perSecondMessages(RUN_MS / 1000 + 1), perSecondBytes(RUN_MS / 1000 + 1);
+    size_t seen = 0;
+    uint32_t start = millis();
+    uint32_t nextPublishMs = 0;
+    uint32_t nextServiceMs = 0;
+    uint8_t outage = 0;
+    bool restarted = false;
+    for (uint32_t t = 0; t < RUN_MS; t = millis() - start)
+    {
+        if (outage < sizeof(OUTAGES) / sizeof(OUTAGES[0]))
+        {
+            const Outage &o = OUTAGES[outage];
+            if (t >= o.fromMs && HostSim::brokerAvailable())
+            {
+                HostSim::brokerDrop();
+                HostSim::setBrokerAvailable(o.fromMs == o.toMs);
+                if (o.fromMs == o.toMs)
+                    ++outage;
+            }
+            else if (t >= o.toMs && !HostSim::brokerAvailable())
+            {
+                HostSim::setBrokerAvailable(true);
+                ++outage;
+            }
+        }
+        if (!restarted && t >= RESTART_MS)
+        {
+            result.stats = queue->stats();
+            File f = SPIFFS.open(SPOOL, "a");
+            f.write((const uint8_t *)"MxQ\3\0\0", 6);
+            f.close();
+            queue.reset(new OutboundQueue(connection, SPOOL));
+            queue->setLimits(batch, messagesPerSecond, bytesPerSecond);
+            queue->begin();
+            restarted = true;
+        }
+
+        connection.loop();
+        if (t >= nextPublishMs && t < TRAFFIC_MS)
+        {
+            std::vector<uint8_t> payload = payloadFor(result.published++);
+            queue->publish(TOPIC, payload.data(), payload.size());
+            nextPublishMs += PUBLISH_MS;
+        }
+        if (t >= nextServiceMs)
+        {
+            queue->service();
+            nextServiceMs = t + 50;
+        }
+        result.maxSpoolBytes = max(result.maxSpoolBytes, queue->spoolBytes());
+
+        const std::vector<HostSim::MqttMessage> &published = HostSim::brokerPublished();
+        for (; seen < published.size(); ++seen)
+        {
+            if (published[seen].topic != TOPIC)
+                continue;
+            ++perSecondMessages[t / 1000];
+            perSecondBytes[t / 1000] += published[seen].payload.size();
+        }
+        delay(10);
+    }
+
+    // the queue's own counts across the restart
+    OutboundQueue::Stats after = queue->stats();
+    result.stats.sent += after.sent;
+    result.stats.spooled += after.spooled;
+    result.stats.replayed += after.replayed;
+    result.stats.dropped += after.dropped;
+    result.stats.limited += after.limited;
+
+    std::vector<uint8_t> delivered(result.published);
+    uint32_t last = 0;
+    for (const HostSim::MqttMessage &m : HostSim::brokerPublished())
+    {
+        if (m.topic != TOPIC)
+            continue;
+        uint32_t seq;
+        memcpy(&seq, m.payload.data(), sizeof(seq));
+        if (seq >= result.published || m.payload != payloadFor(seq))
+        {
+            ++result.corrupt;
+            continue;
+        }
+        if (delivered[seq]++)
+            ++result.duplicates;
+        else if (seq < last)
+            ++result.reordered;
+        last = max(last, seq);
+    }
+    for (uint8_t count : delivered)
+    {
+        if (count)
+            ++result.delivered;
+        else
+            ++result.lost;
+    }
+    for (size_t s = 0; s < perSecondMessages.size(); ++s)
+    {
+        result.peakMessages = max(result.peakMessages, perSecondMessages[s]);
+        result.peakBytes = max(result.peakBytes, perSecondBytes[s]);
+    }
+    SPIFFS.remove(SPOOL);
+    return result;
+}
+
+// three messages spooled offline, then the spool as a reset during its
+// compaction leaves it: gone with its copy whole, or beside half a copy
+static uint32_t pendingAfterReset(MqttConnection &connection, bool copyWhole, bool &tmpLeft)
+{
+    HostSim::setBrokerAvailable(false);
+    HostSim::brokerDrop();
+    connection.loop();
+    SPIFFS.remove(SPOOL);
+    {
+        OutboundQueue queue(connection, SPOOL);
+        queue.begin();
+        for (uint32_t seq = 0; seq < 3; ++seq)
+        {
+            std::vector<uint8_t> payload = payloadFor(seq);
+            queue.publish(TOPIC, payload.data(), payload.size());
+        }
+    }
+
+    char tmpPath[32];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", SPOOL);
+    if (copyWhole)
+    {
+        SPIFFS.rename(SPOOL, tmpPath);
+    }
+    else
+    {
+        File f = SPIFFS.open(tmpPath, "w");
+        f.write((const uint8_t *)"MxQ\3\0\0", 6);
+        f.close();
+    }
+    OutboundQueue queue(connection, SPOOL);
+    queue.begin();
+    tmpLeft = SPIFFS.exists(tmpPath);
+    uint32_t pending = queue.pending();
+    SPIFFS.remove(SPOOL);
+    SPIFFS.remove(tmpPath);
+    HostSim::setBrokerAvailable(true);
+    return pending;
+}
+
+static void print(const char *name, const ReplayResult &r)
+{
+    bool ok = benchCheck(r.delivered == r.published && !r.duplicates && !r.reordered && !r.corrupt);
+    printf("  %-18s %3lu/%3lu delivered  lost %lu  dropped %lu  dup %lu  reordered %lu  corrupt %lu%s\n", name,
+           (unsigned long)r.delivered, (unsigned long)r.published, (unsigned long)r.lost,
+           (unsigned long)r.stats.dropped, (unsigned long)r.duplicates, (unsigned long)r.reordered,
+           (unsigned long)r.corrupt, ok ? "" : "  FAIL");
+    printf("  %-18s sent %3lu  spooled %3lu  replayed %3lu  spool max %5lu B  peak %3lu msg/s %6lu B/s\n", "",
+           (unsigned long)r.stats.sent, (unsigned long)r.stats.spooled, (unsigned long)r.stats.replayed,
+           (unsigned long)r.maxSpoolBytes, (unsigned long)r.peakMessages, (unsigned long)r.peakBytes);
+}
+
+BENCH(outbox)
+{
+    SPIFFS.begin();
+    WiFi.begin("MessageBox", "password");
+    delay(HostSim::wifiAssociateMs());
+    static WiFiClientSecure net;
+    static PubSubClient client(net);
+    client.setBufferSize(256);
+    static MqttConnection connection(client);
+    static TopicRouter router;
+    router.add("MessageBox/bench-in", [](uint8_t, const char *, const uint8_t *, uint32_t) {}, 0);
+    connection.begin("bench", router, "ConnectedClients");
+
+    printf("message every %lu ms for %lu s, broker down 15-22 s, dropped at 40 s, down 55-70 s\n",
+           (unsigned long)PUBLISH_MS, (unsigned long)(TRAFFIC_MS / 1000));
+    printf("and 80-83 s, restart with a torn record at %lu s\n", (unsigned long)(RESTART_MS / 1000));
+    print("8 / 20/s / 8 KB/s", replay(connection, OUTBOX_BATCH, OUTBOX_MESSAGES_PER_SECOND, OUTBOX_BYTES_PER_SECOND));
+    print("no limits", replay(connection, 0, 0, 0));
+    printf("reset during compaction:\n");
+    const char *cases[] = {"before the rename", "during the copy"};
+    for (int copyWhole = 1; copyWhole >= 0; --copyWhole)
+    {
+        bool tmpLeft;
+        uint32_t pending = pendingAfterReset(connection, copyWhole, tmpLeft);
+        printf("  %-18s %lu/3 messages kept, copy %s%s\n", cases[!copyWhole], (unsigned long)pending,
+               tmpLeft ? "left" : "cleared", benchCheck(pending == 3 && !tmpLeft) ? "" : "  FAIL");
+    }
+    printf("  queue %u B of RAM, %u B of stack in service()\n", (unsigned)sizeof(OutboundQueue),
+           (unsigned)(sizeof(OutboxRecord) + MQTT_TOPIC_LEN + OUTBOX_CHUNK_SIZE));
+}
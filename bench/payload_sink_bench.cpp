@@ -0,0 +1,101 @@
+#include "bench.h"
+
+#include <ESP8266WiFi.h>
+#include <FS.h>
+#include <HostSim.h>
+#include <PubSubClient.h>
+
+#include "payload_sink.h"
+
+// Receives payloads of increasing size through the old 10 KB client buffer
+// and through a 256 B buffer streaming into PayloadSink, checking what
+// arrived intact and how much heap each setup keeps allocated.
+static const size_t SIZES[] = {200, 1000, 9000, 20000, 153600};
+static const char *TOPIC = "MessageBox/bench";
+
+static std::vector<uint8_t> s_received;
+static uint32_t s_callbacks;
+
+static void receive(PubSubClient &client, const std::vector<uint8_t> &payload)
+{
+    HostSim::brokerInject(TOPIC, payload.data(), payload.size());
+    client.loop();
+}
+
+BENCH(payload_sink)
+{
+    SPIFFS.begin();
+    WiFi.begin("MessageBox", "password");
+    delay(HostSim::wifiAssociateMs());
+    static WiFiClientSecure net;
+
+    std::vector<std::vector<uint8_t>> payloads;
+    for (size_t size : SIZES)
+    {
+        std::vector<uint8_t> payload(size);
+        for (size_t i = 0; i < size; ++i)
+            payload[i] = (uint8_t)(i * 31 + size);
+        payloads.push_back(payload);
+    }
+
+    {
+        uint32_t freeBefore = ESP.getFreeHeap();
+        PubSubClient client(net);
+        client.setBufferSize(10000);
+        client.setCallback([](char *, uint8_t *payload, unsigned int length) {
+            ++s_callbacks;
+            s_received.assign(payload, payload + length);
+        });
+        client.connect("bench");
+        client.subscribe(TOPIC);
+        printf("10000 B client buffer, heap held %u B:\n", freeBefore - ESP.getFreeHeap());
+        for (const auto &payload : payloads)
+        {
+            s_callbacks = 0;
+            receive(client, payload);
+            printf("  %6zu B  %s\n", payload.size(), !s_callbacks ? "dropped" : s_received == payload ? "ok" : "corrupt");
+        }
+        client.disconnect();
+    }
+
+    {
+        static PayloadSink sink("/bench.part");
+        uint32_t freeBefore = ESP.getFreeHeap();
+        PubSubClient client(net);
+        client.setBufferSize(256);
+        client.setStream(sink);
+        client.setCallback([](char *, uint8_t *, unsigned int) {
+            ++s_callbacks;
+            if (!sink.spilled())
+            {
+                s_received.assign(sink.data(), sink.data() + sink.size());
+                sink.discard();
+                return;
+            }
+            s_received.clear();
+            if (!sink.commit("/bench.bin"))
+                return;
+            File f = SPIFFS.open("/bench.bin", "r");
+            s_received.resize(f.size());
+            f.readBytes(s_received.data(), s_received.size());
+            f.close();
+        });
+        client.connect("bench");
+        client.subscribe(TOPIC);
+        printf("256 B client buffer + %u B sink chunk (static), heap held %u B:\n", PAYLOAD_CHUNK_SIZE,
+               freeBefore - ESP.getFreeHeap());
+        for (const auto &payload : payloads)
+        {
+            s_callbacks = 0;
+            auto start = std::chrono::steady_clock::now();
+            receive(client, payload);
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            benchCheck(s_callbacks && s_received == payload);
+            printf("  %6zu B  %-7s %s %8.1f us\n", payload.size(),
+                   !s_callbacks ? "dropped" : s_received == payload ? "ok" : "corrupt",
+                   payload.size() > PAYLOAD_CHUNK_SIZE ? "spooled" : "in RAM ", us);
+        }
+        client.disconnect();
+        SPIFFS.remove("/bench.bin");
+    }
+}
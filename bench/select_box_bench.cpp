@@ -0,0 +1,43 @@
+#include "bench.h"
+
+#include <HostSim.h>
+#include <TFT_eSPI.h>
+
+#include "select_box.h"
+
+// Panel traffic of one keystroke redraw of the SSID box, drawn straight to the
+// panel and through the sprite, and a check that both leave the same pixels.
+static void redraw(TFT_Select_Box &box, bool sprite, uint32_t &hash, HostSim::SpiCost &cost)
+{
+    box.useSprite(sprite);
+    HostSim::resetStats();
+    box.draw();
+    cost = HostSim::stats().total;
+    hash = HostSim::framebufferHash();
+}
+
+BENCH(select_box)
+{
+    static TFT_eSPI tft;
+    static String ssid = "MessageBox-5G";
+    tft.init();
+    tft.setRotation(1);
+    tft.fillScreen(TFT_BLACK);
+
+    TFT_Select_Box box;
+    box.init(&tft, 40, 20, 150, 20, TFT_WHITE, TFT_BLACK, TFT_WHITE, TFT_GREEN, &ssid, 1);
+    box.m_selected = true;
+
+    uint32_t directHash, spriteHash;
+    HostSim::SpiCost direct, sprite;
+    redraw(box, false, directHash, direct);
+    tft.fillScreen(TFT_BLACK);
+    redraw(box, true, spriteHash, sprite);
+
+    uint32_t heapBefore = ESP.getFreeHeap();
+    printf("direct  %3u windows %6llu B  %5u us\n", direct.windows, (unsigned long long)direct.bytes,
+           HostSim::spiMicros(direct));
+    printf("sprite  %3u windows %6llu B  %5u us  (%u B heap while drawing, %u B after)\n", sprite.windows,
+           (unsigned long long)sprite.bytes, HostSim::spiMicros(sprite), 150 * 20 * 2, heapBefore - ESP.getFreeHeap());
+    printf("pixels  %s\n", benchCheck(directHash == spriteHash) ? "identical" : "DIFFER");
+}
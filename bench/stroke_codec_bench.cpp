@@ -0,0 +1,144 @@
+#include "bench.h"
+
+#include <Base64.h>
+#include <math.h>
+#include <vector>
+
+#include "stroke_codec.h"
+
+// Size and speed of the stroke codec against Base64 of raw points (int16 x, y
+// per point behind a colour/width/count header per stroke), over a drawing
+// of handwriting-like strokes sampled the way the touch loop samples them:
+// a point every 20-40 ms, a few pixels apart, with sensor jitter.
+struct Stroke
+{
+    uint16_t colour;
+    uint8_t width;
+    std::vector<int16_t> points; // x, y pairs
+};
+
+static void recordDrawing(std::vector<Stroke> &strokes)
+{
+    uint32_t seed = 7;
+    auto rnd = [&seed](int32_t range) {
+        seed = seed * 1103515245 + 12345;
+        return (int32_t)((seed >> 16) % range);
+    };
+    for (int s = 0; s < 40; ++s)
+    {
+        Stroke stroke;
+        stroke.colour = (uint16_t)rnd(0x10000);
+        stroke.width = 1 + rnd(6);
+        float x = 40 + rnd(400), y = 40 + rnd(240);
+        float heading = rnd(628) / 100.0f, turn = (rnd(200) - 100) / 1000.0f;
+        int length = 20 + rnd(120);
+        for (int p = 0; p < length; ++p)
+        {
+            float step = 2 + rnd(5);
+            heading += turn + (rnd(100) - 50) / 500.0f;
+            x = fminf(fmaxf(x + step * cosf(heading), 0), 479);
+            y = fminf(fmaxf(y + step * sinf(heading), 0), 319);
+            stroke.points.push_back((int16_t)x + rnd(3) - 1);
+            stroke.points.push_back((int16_t)y + rnd(3) - 1);
+        }
+        strokes.push_back(stroke);
+    }
+}
+
+static uint32_t encodeRaw(const std::vector<Stroke> &strokes, uint8_t *out)
+{
+    uint32_t n = 0;
+    for (const Stroke &s : strokes)
+    {
+        uint16_t count = s.points.size() / 2;
+        memcpy(out + n, &s.colour, 2);
+        out[n + 2] = s.width;
+        memcpy(out + n + 3, &count, 2);
+        memcpy(out + n + 5, s.points.data(), s.points.size() * 2);
+        n += 5 + s.points.size() * 2;
+    }
+    return n;
+}
+
+BENCH(stroke_codec)
+{
+    std::vector<Stroke> strokes;
+    recordDrawing(strokes);
+    size_t points = 0;
+    for (const Stroke &s : strokes)
+        points += s.points.size() / 2;
+
+    static uint8_t raw[64 * 1024], packed[64 * 1024];
+    static char base64[96 * 1024], unbase64[64 * 1024];
+    uint32_t rawLength = encodeRaw(strokes, raw);
+    int base64Length = base64_encode(base64, (char *)raw, rawLength);
+
+    uint32_t packedLength = 0;
+    auto encode = [&](uint32_t) {
+        StrokeEncoder encoder(packed, sizeof(packed));
+        for (const Stroke &s : strokes)
+        {
+            encoder.beginStroke(s.colour, s.width, s.points[0], s.points[1]);
+            for (size_t p = 2; p < s.points.size(); p += 2)
+                encoder.addPoint(s.points[p], s.points[p + 1]);
+            encoder.endStroke();
+        }
+        packedLength = encoder.length();
+    };
+    encode(0);
+
+    // round trip has to give back every point that was not a repeat
+    size_t decodedPoints = 0;
+    bool match = true;
+    auto decode = [&](bool verify) {
+        StrokeDecoder decoder(packed, packedLength);
+        uint16_t colour;
+        uint8_t width;
+        int16_t x, y;
+        size_t s = 0;
+        while (decoder.nextStroke(colour, width, x, y))
+        {
+            if (!verify)
+            {
+                while (decoder.nextPoint(x, y))
+                    benchKeep(x + y);
+                continue;
+            }
+            const Stroke &expect = strokes[s++];
+            match &= colour == expect.colour && width == expect.width;
+            size_t p = 0;
+            do
+            {
+                // the encoder drops repeated samples
+                while (p + 2 < expect.points.size() && expect.points[p] == x && expect.points[p + 1] == y &&
+                       expect.points[p + 2] == x && expect.points[p + 3] == y)
+                    p += 2;
+                match &= p < expect.points.size() && expect.points[p] == x && expect.points[p + 1] == y;
+                p += 2;
+                ++decodedPoints;
+            } while (decoder.nextPoint(x, y));
+        }
+        if (verify)
+            match &= !decoder.error() && s == strokes.size();
+    };
+    decode(true);
+
+    const uint32_t ITERATIONS = 2000;
+    double packedEncode = benchNanos(ITERATIONS, encode) / 1000;
+    double packedDecode = benchNanos(ITERATIONS, [&](uint32_t) { decode(false); }) / 1000;
+    double rawEncode = benchNanos(ITERATIONS, [&](uint32_t) {
+        uint32_t n = encodeRaw(strokes, raw);
+        benchKeep(base64_encode(base64, (char *)raw, n));
+    }) / 1000;
+    double rawDecode = benchNanos(ITERATIONS, [&](uint32_t) {
+        benchKeep(base64_decode(unbase64, base64, base64Length));
+    }) / 1000;
+
+    printf("%zu strokes, %zu points (%zu decoded, round trip %s)\n", strokes.size(), points, decodedPoints,
+           benchCheck(match) ? "ok" : "MISMATCH");
+    printf("base64 raw    %6d B  %5.2f B/point  encode %7.1f us  decode %7.1f us\n", base64Length,
+           (double)base64Length / points, rawEncode, rawDecode);
+    printf("stroke codec  %6u B  %5.2f B/point  encode %7.1f us  decode %7.1f us\n", packedLength,
+           (double)packedLength / points, packedEncode, packedDecode);
+    printf("size ratio    %6.1fx smaller\n", (double)base64Length / packedLength);
+}
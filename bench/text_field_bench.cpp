@@ -0,0 +1,98 @@
+#include "bench.h"
+
+#include <HostSim.h>
+#include <TFT_eSPI.h>
+
+#include "select_box.h"
+#include "text_field.h"
+
+// Panel traffic per keystroke typing a long SSID, then deleting it again: the
+// select box over a String, redrawn whole after every edit, against the text
+// field drawing only the glyphs that changed, plain and masked.
+static const char TYPED[] = "MessageBox-Upstairs-5G-Extender-2";
+
+struct KeystrokeCost
+{
+    uint64_t bytes;
+    uint32_t windows;
+    uint32_t maxBytes;
+    uint32_t strokes;
+};
+
+static void account(KeystrokeCost &cost)
+{
+    const HostSim::SpiCost &total = HostSim::stats().total;
+    cost.bytes += total.bytes;
+    cost.windows += total.windows;
+    cost.maxBytes = max(cost.maxBytes, (uint32_t)total.bytes);
+    ++cost.strokes;
+}
+
+static void print(const char *name, const KeystrokeCost &cost)
+{
+    printf("  %-14s %6llu B  %4.1f windows avg  %5lu B max  per keystroke\n", name,
+           (unsigned long long)(cost.bytes / cost.strokes), (double)cost.windows / cost.strokes,
+           (unsigned long)cost.maxBytes);
+}
+
+BENCH(text_field)
+{
+    static TFT_eSPI tft;
+    tft.init();
+    tft.setRotation(1);
+    tft.fillScreen(TFT_BLACK);
+    tft.setTextFont(2);
+
+    KeystrokeCost box = {};
+    {
+        static String label;
+        TFT_Select_Box select;
+        select.init(&tft, 40, 20, 150, 20, TFT_WHITE, TFT_BLACK, TFT_WHITE, TFT_GREEN, &label, 1);
+        select.useSprite(false);
+        select.draw();
+        for (const char *c = TYPED; *c; ++c)
+        {
+            HostSim::resetStats();
+            label += *c;
+            select.draw();
+            account(box);
+        }
+        while (label.length())
+        {
+            HostSim::resetStats();
+            label = label.substring(0, label.length() - 1);
+            select.draw();
+            account(box);
+        }
+    }
+
+    KeystrokeCost fields[2] = {};
+    for (uint8_t masked = 0; masked < 2; ++masked)
+    {
+        TFT_Text_Field field;
+        field.init(&tft, 40, 20, 150, 20, TFT_WHITE, TFT_BLACK, TFT_WHITE, TFT_GREEN, 1);
+        field.setMasked(masked);
+        field.draw();
+        for (const char *c = TYPED; *c; ++c)
+        {
+            HostSim::resetStats();
+            field.append(*c);
+            field.update();
+            account(fields[masked]);
+        }
+        while (field.length())
+        {
+            HostSim::resetStats();
+            field.erase();
+            field.update();
+            account(fields[masked]);
+        }
+    }
+
+    printf("%u characters typed then deleted in a 150 px field\n", (unsigned)strlen(TYPED));
+    print("select box", box);
+    print("text field", fields[0]);
+    print("masked field", fields[1]);
+    printf("  text field holds %u characters inline, %u B, no heap\n", TEXT_FIELD_CAPACITY,
+           (unsigned)sizeof(TFT_Text_Field));
+}
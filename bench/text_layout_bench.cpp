@@ -0,0 +1,192 @@
+#include "bench.h"
+
+#include <HostSim.h>
+#include <TFT_eSPI.h>
+
+#include "text_view.h"
+
+// Paging through a 10,000 byte message in a view of the message screen's
+// size. Wrapping it as it is drawn, as a screen without a layout would,
+// means measuring every word from the top of the message down to the page
+// shown, with a textWidth() per word and per glyph of a word too long for a
+// line. The layout measures the font once and the message once, after which
+// a page is found by index. Both break every line in the same place.
+static const uint16_t MESSAGE_BYTES = 10000;
+static const int16_t VIEW_W = 470;
+static const int16_t VIEW_H = 300;
+static const uint8_t FONT = 2;
+
+struct Measured
+{
+    uint32_t calls;
+    uint32_t glyphs;
+};
+
+static uint16_t buildMessage(char *text)
+{
+    static const char *const WORDS[] = {"the", "message", "box", "is", "a", "small", "screen", "that", "shows",
+                                        "what", "arrives", "over", "MQTT,", "wrapped", "to", "fit;", "Wi-Fi",
+                                        "and", "keyboard", "layouts", "live", "in", "flash."};
+    uint32_t seed = 1;
+    uint16_t n = 0;
+    while (n < MESSAGE_BYTES - 100)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint32_t pick = (seed >> 16) % 400;
+        const char *word = WORDS[pick % (sizeof(WORDS) / sizeof(WORDS[0]))];
+        if (pick == 0)
+            word = "https://example.com/a/link/far/too/long/to/fit/on/one/line/of/the/message/screen/at/all/"
+                   "so/it/breaks/inside";
+        n += snprintf(text + n, MESSAGE_BYTES - n, "%s", word);
+        text[n++] = pick < 6 ? '\n' : ' ';
+    }
+    while (n < MESSAGE_BYTES)
+        text[n++] = '.';
+    text[n] = 0;
+    return n;
+}
+
+static int16_t measure(TFT_eSPI &tft, const char *text, uint16_t length, Measured &m)
+{
+    char word[65];
+    int16_t w = 0;
+    while (length)
+    {
+        uint16_t n = min(length, (uint16_t)(sizeof(word) - 1));
+        memcpy(word, text, n);
+        word[n] = 0;
+        w += tft.textWidth(word, FONT);
+        ++m.calls;
+        m.glyphs += n;
+        text += n;
+        length -= n;
+    }
+    return w;
+}
+
+// greedy wrapping word by word with textWidth(), until lines are known
+static uint16_t naiveWrap(TFT_eSPI &tft, const char *text, uint16_t length, uint16_t *starts, uint16_t lines,
+                          Measured &m)
+{
+    uint16_t count = 0;
+    uint16_t i = 0;
+    while (i < length && count < lines)
+    {
+        uint16_t start = i;
+        starts[count++] = start;
+        uint16_t next = length;
+        int32_t x = 0;
+        while (i < length)
+        {
+            if (text[i] == '\n')
+            {
+                next = i + 1;
+                break;
+            }
+            if (text[i] == ' ')
+            {
+                x += measure(tft, " ", 1, m);
+                ++i;
+                continue;
+            }
+            uint16_t end = i;
+            while (end < length && text[end] != ' ' && text[end] != '\n')
+                ++end;
+            int16_t w = measure(tft, text + i, end - i, m);
+            if (x + w <= VIEW_W)
+            {
+                x += w;
+                i = end;
+                continue;
+            }
+            if (i > start)
+            {
+                next = i;
+                break;
+            }
+            // too long for any line, glyph by glyph
+            for (next = i; next < end; ++next)
+            {
+                x += measure(tft, text + next, 1, m);
+                if (x > VIEW_W && next > i)
+                    break;
+            }
+            if (next == end)
+            {
+                i = end;
+                continue;
+            }
+            break;
+        }
+        i = next;
+    }
+    starts[count] = i;
+    return count;
+}
+
+BENCH(text_layout)
+{
+    static TFT_eSPI tft;
+    tft.init();
+    tft.setRotation(1);
+    static char text[MESSAGE_BYTES + 1];
+    uint16_t length = buildMessage(text);
+
+    static TFT_Text_View view;
+    view.init(&tft, 5, 10, VIEW_W, VIEW_H, TFT_WHITE, TFT_BLACK, FONT);
+    view.setText(text, length);
+    const TextLayout &layout = view.layout();
+    uint16_t lines = layout.lines();
+    uint16_t page = view.visibleLines();
+    uint16_t pages = (lines + page - 1) / page;
+
+    static uint16_t starts[TEXT_LAYOUT_MAX_LINES + 1];
+    Measured once = {};
+    uint16_t naiveLines = naiveWrap(tft, text, length, starts, TEXT_LAYOUT_MAX_LINES, once);
+    uint16_t differ = naiveLines != lines;
+    for (uint16_t i = 0; i < min(naiveLines, lines); ++i)
+        differ += layout.line(i) != text + starts[i];
+
+    // every page in turn, wrapped up to its last line each time
+    Measured naive = {};
+    double naiveNs = benchNanos(pages, [&](uint32_t p) {
+        uint16_t n = naiveWrap(tft, text, length, starts, min((uint32_t)lines, (p + 1) * page), naive);
+        benchKeep(starts[n - 1]);
+    });
+    double lookupNs = benchNanos(pages * 100, [&](uint32_t i) {
+        uint16_t first = (i % pages) * page;
+        uint32_t sum = 0;
+        for (uint16_t l = first; l < min(lines, (uint16_t)(first + page)); ++l)
+            sum += layout.lineLength(l);
+        benchKeep(sum);
+    });
+
+    TextLayout fresh;
+    double fontNs = benchNanos(1, [&](uint32_t) { fresh.setFont(&tft, FONT); });
+    double layoutNs = benchNanos(100, [&](uint32_t) { benchKeep(fresh.layout(text, length, VIEW_W)); });
+
+    printf("%u B message, %u lines of %d px, %u to a page, %u pages, breaks %s\n", length, lines, VIEW_W, page,
+           pages, benchCheck(!differ) ? "identical" : "DIFFER");
+    printf("  wrap on draw    %7.0f textWidth() calls %8.0f glyphs measured %9.0f ns  per page\n",
+           (double)naive.calls / pages, (double)naive.glyphs / pages, naiveNs);
+    printf("  layout          %7u textWidth() calls %8u glyphs measured %9.0f ns  once per font\n",
+           TEXT_LAYOUT_GLYPHS, TEXT_LAYOUT_GLYPHS, fontNs);
+    printf("                  %7u textWidth() calls %8u glyphs added up %9.0f ns  once per message\n", 0,
+           length, layoutNs);
+    printf("                  %7u textWidth() calls %8u glyphs measured %9.0f ns  per page\n", 0, 0, lookupNs);
+
+    // scrolling a line repaints the view from the offsets alone
+    static TFT_Screen screen;
+    screen.init(&tft, TFT_BLACK);
+    screen.add(&view);
+    screen.render();
+    view.scrollTo(lines / 2);
+    screen.render();
+    HostSim::resetStats();
+    uint32_t start = micros();
+    view.scrollBy(1);
+    screen.render();
+    printf("  scroll a line   %lu B to the panel, %lu us, %u B of offsets and %u B of advances in RAM\n",
+           (unsigned long)HostSim::stats().total.bytes, (unsigned long)(micros() - start),
+           (unsigned)(sizeof(uint16_t) * (TEXT_LAYOUT_MAX_LINES + 1)), TEXT_LAYOUT_GLYPHS);
+}
@@ -0,0 +1,89 @@
+#include "bench.h"
+
+#include <HostSim.h>
+#include <TFT_eSPI.h>
+#include <math.h>
+
+#include "tile_canvas.h"
+
+// Memory and repaint cost of a drawing filling the canvas area: a scribble of
+// strokes at the default pen width, then a full invalidate() + flush(). Last
+// the whole area is inked, far past the pool: every stroke still has to
+// reach the panel.
+BENCH(tile_canvas)
+{
+    static const uint16_t palette[CANVAS_COLOURS] = {TFT_CYAN, TFT_BLACK, TFT_RED, TFT_BLUE};
+    static TFT_eSPI tft;
+    static TFT_Tile_Canvas canvas;
+    tft.init();
+    tft.setRotation(1);
+    canvas.init(64, 0, 416, 320, palette);
+    canvas.spillTo(&tft);
+    canvas.flush(&tft);
+
+    // five lines of joined-up handwriting across the whole width, 3 px pen
+    uint32_t seed = 99;
+    for (int line = 0; line < 5; ++line)
+    {
+        float baseline = 40 + line * 60;
+        int16_t px = 72, py = baseline;
+        for (int word = 0; word < 6; ++word)
+        {
+            seed = seed * 1103515245 + 12345;
+            int letters = 3 + (seed >> 16) % 5;
+            float x = px;
+            for (int p = 0; p < letters * 10 && x < 470; ++p)
+            {
+                // loops of a letter: forward with a circular wobble, some ascenders
+                float t = p * 0.63f;
+                float height = ((seed >> (p % 16)) & 3) == 0 ? 22 : 10;
+                x += 1.2f;
+                int16_t nx = x + 4 * cosf(t), ny = baseline - height * (0.5f + 0.5f * sinf(t));
+                canvas.drawLine(px, py, nx, ny, 1 + line % 3, 3);
+                px = nx;
+                py = ny;
+            }
+            px += 14; // gap between words, pen lifted
+            py = baseline;
+        }
+    }
+
+    uint32_t tiles = (416 / CANVAS_TILE_SIZE) * (320 / CANVAS_TILE_SIZE);
+    printf("canvas 416x320, %u bpp, %ux%u tiles: %u of %u tiles hold ink (pool %u)%s\n", CANVAS_BPP,
+           CANVAS_TILE_SIZE, CANVAS_TILE_SIZE, canvas.tilesUsed(), tiles, CANVAS_POOL_TILES,
+           canvas.overflowed() ? ", pool overflowed" : "");
+    printf("memory       %6zu B   (RGB565 would be %u B)\n", sizeof(TFT_Tile_Canvas), 416 * 320 * 2);
+
+    HostSim::resetStats();
+    canvas.flush(&tft);
+    const HostSim::SpiCost &incremental = HostSim::stats().total;
+    printf("first flush  %6u windows %8llu B  %6u us\n", incremental.windows,
+           (unsigned long long)incremental.bytes, HostSim::spiMicros(incremental));
+
+    HostSim::resetStats();
+    canvas.invalidate();
+    uint16_t sent = canvas.flush(&tft);
+    const HostSim::SpiCost &repaint = HostSim::stats().total;
+    printf("repaint      %6u windows %8llu B  %6u us  (%u tiles, one pass)\n", repaint.windows,
+           (unsigned long long)repaint.bytes, HostSim::spiMicros(repaint), sent);
+
+    double ns = benchNanos(200, [&](uint32_t) {
+        canvas.invalidate();
+        canvas.flush(&tft);
+    });
+    printf("repaint CPU  %8.1f us on the host\n", ns / 1000);
+
+    canvas.clear();
+    canvas.flush(&tft);
+    HostSim::resetStats();
+    for (int16_t y = 0; y < 320; y += 4)
+        canvas.drawLine(64, y, 479, y, 1, 3);
+    canvas.flush(&tft);
+    uint32_t missing = 0;
+    for (int16_t y = 0; y < 320; y += 4)
+        for (int16_t x = 64; x < 480; ++x)
+            missing += HostSim::pixel(x, y) != palette[1];
+    printf("inked area   %6u of %u tiles kept, the rest spilled: %u B, %lu ink pixels missing%s\n",
+           canvas.tilesUsed(), tiles, (unsigned)HostSim::stats().total.bytes, (unsigned long)missing,
+           benchCheck(!missing) ? "" : " FAIL");
+}
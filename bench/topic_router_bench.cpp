@@ -0,0 +1,153 @@
+#include "bench.h"
+
+#include <ESP8266WiFi.h>
+#include <HostSim.h>
+#include <PubSubClient.h>
+
+#include "mqtt_connection.h"
+#include "topic_router.h"
+
+// A box with five partners and two group channels besides its own, the
+// full eight routes. Dispatch by the router against the two ways of doing
+// it without one: building each partner's topic as a String to compare,
+// and strcmp() down a list, for the first topic, the last and one nothing
+// is routed to. Then the broker restarts: every subscription has to be
+// made again before messages flow, and each topic must reach its partner.
+// Last a subscribe fails with the session still up: the connection has to
+// end it and come back by itself.
+static const char *const PARTNERS[] = {"c2fbca29-ddf3-4e86-bfac-f366bbeb3eb1", "5d1e8c7a-0b3f-4f2e-9a61-7c4d2e8b9f10",
+                                       "a97b2c14-6e3d-48f1-b0c5-d2e1f3a4b5c6", "0f1e2d3c-4b5a-6978-8796-a5b4c3d2e1f0",
+                                       "e3d4c5b6-a798-4f01-9e2d-3c4b5a697887", "7a8b9c0d-1e2f-4a3b-8c4d-5e6f7a8b9c0d",
+                                       "group/family", "group/book-club"};
+static const uint8_t ROUTES = sizeof(PARTNERS) / sizeof(PARTNERS[0]);
+
+static char s_topics[ROUTES][MQTT_TOPIC_LEN];
+static uint32_t s_hits[ROUTES];
+static uint8_t s_lastPartner;
+
+static void onMessage(uint8_t partner, const char *topic, const uint8_t *payload, uint32_t length)
+{
+    ++s_hits[partner];
+    s_lastPartner = partner;
+}
+
+static int8_t byString(const char *topic)
+{
+    String t(topic);
+    for (uint8_t i = 0; i < ROUTES; ++i)
+        if (t == "MessageBox/" + String(PARTNERS[i]))
+            return i;
+    return -1;
+}
+
+static int8_t byStrcmp(const char *topic)
+{
+    for (uint8_t i = 0; i < ROUTES; ++i)
+        if (strcmp(topic, s_topics[i]) == 0)
+            return i;
+    return -1;
+}
+
+BENCH(topic_router)
+{
+    static TopicRouter router;
+    for (uint8_t i = 0; i < ROUTES; ++i)
+    {
+        snprintf(s_topics[i], MQTT_TOPIC_LEN, "MessageBox/%s", PARTNERS[i]);
+        router.add(s_topics[i], onMessage, i);
+    }
+    static const char UNROUTED[] = "MessageBox/ffffffff-ffff-4fff-bfff-ffffffffffff";
+    struct Probe
+    {
+        const char *name, *topic;
+    };
+    const Probe probes[] = {{"first", s_topics[0]}, {"last", s_topics[ROUTES - 1]}, {"unrouted", UNROUTED}};
+
+    printf("%u routes in %u slots, %u B\n", ROUTES, TOPIC_ROUTER_SLOTS, (unsigned)sizeof(TopicRouter));
+    for (const Probe &p : probes)
+    {
+        // the handler call included, as dispatch() makes it
+        double stringNs = benchNanos(20000, [&](uint32_t) {
+            int8_t i = byString(p.topic);
+            if (i >= 0)
+                onMessage(i, p.topic, nullptr, 0);
+        });
+        double strcmpNs = benchNanos(200000, [&](uint32_t) {
+            int8_t i = byStrcmp(p.topic);
+            if (i >= 0)
+                onMessage(i, p.topic, nullptr, 0);
+        });
+        double routerNs = benchNanos(200000, [&](uint32_t) { benchKeep(router.dispatch(p.topic, nullptr, 0)); });
+        printf("  %-9s String %7.0f ns   strcmp %5.0f ns   router %5.0f ns\n", p.name, stringNs, strcmpNs, routerNs);
+    }
+    printf("  max probes %u, %lu unrouted\n", router.stats().maxProbes, (unsigned long)router.stats().unrouted);
+
+    // a broker restart, with every route to subscribe again
+    WiFi.begin("MessageBox", "password");
+    delay(HostSim::wifiAssociateMs());
+    static WiFiClientSecure net;
+    static PubSubClient client(net);
+    client.setCallback([](char *topic, uint8_t *payload, unsigned int length) {
+        router.dispatch(topic, payload, length);
+    });
+    static MqttConnection connection(client);
+    connection.begin("router-bench", router, "ConnectedClients");
+    while (!connection.isOnline())
+    {
+        connection.loop();
+        delay(10);
+    }
+    HostSim::brokerDrop();
+    connection.loop();
+    uint32_t subscribeSteps = 0;
+    uint32_t start = millis();
+    while (!connection.isOnline())
+    {
+        subscribeSteps += connection.state() == MqttConnection::Subscribing;
+        connection.loop();
+        delay(10);
+    }
+    uint32_t reconnectMs = millis() - start;
+
+    // one at a time, each has to land on its own partner
+    memset(s_hits, 0, sizeof(s_hits));
+    uint32_t misrouted = 0;
+    for (uint8_t i = 0; i < ROUTES; ++i)
+    {
+        HostSim::brokerInject(s_topics[i], (const uint8_t *)"hi", 2);
+        connection.loop();
+        misrouted += s_lastPartner != i;
+    }
+    uint8_t reached = 0;
+    for (uint8_t i = 0; i < ROUTES; ++i)
+        reached += s_hits[i] == 1;
+    printf("  reconnect %lu ms, %u topics subscribed in %lu loop() step, %u/%u partners reached, %lu misrouted\n",
+           (unsigned long)reconnectMs, ROUTES, (unsigned long)subscribeSteps, reached, ROUTES,
+           (unsigned long)misrouted);
+
+    // the first subscribe of the next session is refused
+    HostSim::brokerDrop();
+    connection.loop();
+    HostSim::brokerFailSubscribes(1);
+    uint32_t attempts = connection.stats().attempts;
+    start = millis();
+    while (!connection.isOnline() && millis() - start < 2 * MQTT_BACKOFF_MAX_MS)
+    {
+        connection.loop();
+        delay(10);
+    }
+    HostSim::brokerFailSubscribes(0);
+    reached = 0;
+    for (uint8_t i = 0; i < ROUTES; ++i)
+    {
+        s_lastPartner = ROUTES;
+        HostSim::brokerInject(s_topics[i], (const uint8_t *)"hi", 2);
+        connection.loop();
+        reached += s_lastPartner == i;
+    }
+    bool recovered = benchCheck(connection.isOnline() && reached == ROUTES);
+    printf("  subscribe refused: %s after %lu ms and %lu connects, %u/%u partners reached\n",
+           recovered ? "back online" : "FAIL, still offline", (unsigned long)(millis() - start),
+           (unsigned long)(connection.stats().attempts - attempts), reached, ROUTES);
+    HostSim::brokerDrop();
+}
@@ -0,0 +1,200 @@
+#include "bench.h"
+
+#include <HostSim.h>
+#include <TFT_eSPI.h>
+
+#include "scheduler.h"
+#include "touch_input.h"
+
+// Replays recorded controller traces through TouchInput's filter and checks
+// the events that come out, then runs scripted taps through the pen IRQ and
+// sampler against the old getTouch()-then-delay(25) loop. The sampler runs
+// as main.cpp runs it, a scheduler task beside a screen task, and getTouch()
+// blocks as long as the library's does, so how late it makes the screen is
+// part of the result.
+
+struct TraceSample
+{
+    uint16_t ms;
+    int16_t x, y;
+    bool down;
+};
+
+struct Trace
+{
+    const char *name;
+    const TraceSample *samples;
+    uint8_t count;
+    const char *expected;
+};
+
+// samples 5 ms apart as the sampler takes them, misses included
+static const TraceSample TAP[] = {
+    {0, 120, 80, true}, {5, 121, 80, true}, {10, 120, 81, true}, {15, 0, 0, false}, {20, 0, 0, false}, {25, 0, 0, false}};
+// light pressure: the controller loses the pen for one sample mid-press
+static const TraceSample DROPOUT[] = {
+    {0, 300, 200, true}, {5, 300, 200, true}, {10, 0, 0, false}, {15, 301, 200, true}, {20, 300, 201, true},
+    {25, 0, 0, false}, {30, 0, 0, false}, {35, 0, 0, false}};
+// held still with +-1 px of noise
+static const TraceSample HOLD[] = {
+    {0, 50, 50, true}, {5, 51, 50, true}, {10, 50, 49, true}, {15, 49, 51, true}, {20, 51, 51, true},
+    {25, 50, 50, true}, {30, 0, 0, false}, {35, 0, 0, false}, {40, 0, 0, false}};
+// a short stroke to the right with some wobble
+static const TraceSample DRAG[] = {
+    {0, 100, 100, true}, {5, 103, 101, true}, {10, 104, 100, true}, {15, 108, 101, true}, {20, 112, 103, true},
+    {25, 0, 0, false}, {30, 0, 0, false}, {35, 0, 0, false}};
+// two taps with one miss short of a release between them
+static const TraceSample DOUBLE_TAP[] = {
+    {0, 200, 150, true}, {5, 0, 0, false}, {10, 0, 0, false}, {15, 0, 0, false}, {20, 202, 151, true},
+    {25, 0, 0, false}, {30, 0, 0, false}, {35, 0, 0, false}};
+
+static const Trace TRACES[] = {
+    {"tap", TAP, sizeof(TAP) / sizeof(TAP[0]), "P120,80@0 R120,80@15"},
+    {"dropout", DROPOUT, sizeof(DROPOUT) / sizeof(DROPOUT[0]), "P300,200@0 R300,200@25"},
+    {"hold", HOLD, sizeof(HOLD) / sizeof(HOLD[0]), "P50,50@0 R50,50@30"},
+    {"drag", DRAG, sizeof(DRAG) / sizeof(DRAG[0]), "P100,100@0 M103,101@5 M108,101@15 M112,103@20 R112,103@25"},
+    {"double_tap", DOUBLE_TAP, sizeof(DOUBLE_TAP) / sizeof(DOUBLE_TAP[0]), "P200,150@0 R200,150@5 P202,151@20 R202,151@25"},
+};
+
+static void replay(const Trace &trace)
+{
+    TouchInput input;
+
+    char events[160] = "";
+    size_t used = 0;
+    TouchEvent event;
+    for (uint8_t i = 0; i < trace.count; ++i)
+    {
+        const TraceSample &s = trace.samples[i];
+        input.feed({(uint32_t)s.ms * 1000, s.x, s.y, s.down});
+        while (input.read(event) && used < sizeof(events))
+        {
+            static const char TYPES[] = "PMR";
+            used += snprintf(events + used, sizeof(events) - used, "%s%c%d,%d@%lu", used ? " " : "",
+                             TYPES[event.type], event.x, event.y, (unsigned long)(event.us / 1000));
+        }
+    }
+    bool ok = benchCheck(strcmp(events, trace.expected) == 0);
+    printf("  %-10s %s  %s\n", trace.name, ok ? "ok  " : "FAIL", events);
+    if (!ok)
+        printf("  %-10s      expected %s\n", "", trace.expected);
+}
+
+struct TapResult
+{
+    uint32_t caught;
+    uint32_t reads;
+    uint32_t screenLateUs;
+};
+
+static const uint32_t TAPS = 200;
+static const uint32_t TAP_SPACING_MS = 150;
+
+// taps of 6..40 ms at random phase against the loop
+static uint32_t scriptTaps(uint32_t seed)
+{
+    HostSim::clearTouches();
+    uint32_t start = millis() + 100;
+    for (uint32_t i = 0; i < TAPS; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint32_t offset = (seed >> 16) % 60;
+        uint32_t duration = 6 + (seed >> 8) % 35;
+        HostSim::addTouch(start + i * TAP_SPACING_MS + offset, 240, 160, duration);
+    }
+    return start + TAPS * TAP_SPACING_MS + 100;
+}
+
+// what wifiSetup() did: one getTouch() per loop(), then delay(25)
+static TapResult pollLoop(TFT_eSPI &tft, uint32_t until)
+{
+    TapResult result = {0, 0, 0};
+    bool wasDown = false;
+    while (millis() < until)
+    {
+        uint16_t x, y;
+        bool down = tft.getTouch(&x, &y);
+        ++result.reads;
+        if (down && !wasDown)
+            ++result.caught;
+        wasDown = down;
+        delay(25);
+        delay(1); // the rest of loop()
+    }
+    return result;
+}
+
+static TouchInput *s_input;
+static uint32_t s_caught;
+
+static void sampleTask()
+{
+    s_input->sample();
+}
+
+// a frame every 26 ms that draws for 5
+static void screenTask()
+{
+    TouchEvent event;
+    while (s_input->read(event))
+    {
+        if (event.type == TouchEvent::Press)
+            ++s_caught;
+    }
+    delay(5);
+}
+
+static TapResult touchInputLoop(TFT_eSPI &tft, int8_t irqPin, uint32_t until)
+{
+    TouchInput input;
+    input.begin(&tft, irqPin);
+    s_input = &input;
+    s_caught = 0;
+    Scheduler scheduler;
+    scheduler.every("touch", TOUCH_SAMPLE_MS, sampleTask);
+    int8_t screen = scheduler.every("screen", 26, screenTask);
+    while (millis() < until)
+        scheduler.run();
+    TapResult result = {s_caught, input.reads(), scheduler.stats(screen).maxLateUs};
+    input.end();
+    return result;
+}
+
+BENCH(touch_input)
+{
+    printf("recorded traces through the filter\n");
+    for (const Trace &trace : TRACES)
+        replay(trace);
+
+    static TFT_eSPI tft;
+    tft.init();
+
+    uint32_t until = scriptTaps(7);
+    TapResult poll = pollLoop(tft, until);
+    until = scriptTaps(7);
+    TapResult polled = touchInputLoop(tft, -1, until);
+    until = scriptTaps(7);
+    TapResult irq = touchInputLoop(tft, HostSim::PEN_IRQ_PIN, until);
+    HostSim::clearTouches();
+
+    uint32_t seconds = (TAPS * TAP_SPACING_MS + 200) / 1000;
+    printf("%lu taps of 6-40 ms over %lu s, loop() every 26 ms\n",
+                  (unsigned long)TAPS, (unsigned long)seconds);
+    printf("  getTouch + delay(25)   caught %3lu   controller reads %6lu\n",
+                  (unsigned long)poll.caught, (unsigned long)poll.reads);
+    printf("  sampler, polling       caught %3lu   controller reads %6lu   screen up to %2lu ms late\n",
+                  (unsigned long)polled.caught, (unsigned long)polled.reads,
+                  (unsigned long)(polled.screenLateUs / 1000));
+    printf("  sampler, pen IRQ       caught %3lu   controller reads %6lu   screen up to %2lu ms late\n",
+                  (unsigned long)irq.caught, (unsigned long)irq.reads, (unsigned long)(irq.screenLateUs / 1000));
+
+    // filter cost per sample on the consumer side
+    TouchInput input;
+    double ns = benchNanos(1000000, [&input](uint32_t i) {
+        input.feed({i * 5000, (int16_t)(100 + (i & 31)), (int16_t)(100 + ((i >> 5) & 31)), (i & 63) < 56});
+        TouchEvent event;
+        while (input.read(event))
+            benchKeep(event);
+    });
+    printf("  filter %.1f ns/sample\n", ns);
+}
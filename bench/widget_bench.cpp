@@ -0,0 +1,174 @@
+#include "bench.h"
+
+#include <HostSim.h>
+#include <TFT_eSPI.h>
+
+#include "keyboard.h"
+#include "label.h"
+#include "text_field.h"
+#include "widget.h"
+
+// One frame's worth of queued input on the Wi-Fi screen, as after a loop()
+// that blocked: Shift, then three letters, each tap pressed and released.
+// Drawn straight from the input handlers, and through the widget tree with
+// and without a frame budget. Then a status line changing under each
+// approach: the whole screen repainted, as a screen without the tree would
+// on any change, against the damaged rectangle alone.
+static const uint8_t TAPS[] = {TFT_Keyboard::Shift, 26, 27, 28}; // Shift, a, s, d
+
+static TFT_eSPI s_tft;
+static TFT_Screen s_screen;
+static TFT_Keyboard s_keyboard;
+static TFT_Text_Field s_field;
+static TFT_Label s_status;
+static bool s_shift;
+static uint32_t s_draws;
+
+static void reset()
+{
+    s_shift = false;
+    s_screen.init(&s_tft, TFT_BLACK);
+    s_field.init(&s_tft, 40, 20, 150, 20, TFT_WHITE, TFT_BLACK, TFT_WHITE, TFT_GREEN, 1);
+    s_field.clear();
+    s_field.setSelected(true);
+    s_status.init(&s_tft, 0, 130, s_tft.width(), 8, TFT_WHITE, TFT_BLACK, 1, TC_DATUM);
+    s_status.setText("Connecting to MessageBox retries: 0");
+    s_keyboard.init(&s_tft);
+    s_keyboard.setLayout(&keyboardQwerty, false, false);
+    s_screen.add(&s_field);
+    s_screen.add(&s_status);
+    s_screen.add(&s_keyboard);
+    s_screen.render();
+}
+
+// the same state changes either way, direct draws straight away
+static void tap(uint8_t i, bool direct)
+{
+    TFT_eSPI_Button &key = s_keyboard.key(i);
+    for (uint8_t down = 1; down < 3; ++down)
+    {
+        key.press(down == 1);
+        s_keyboard.invalidateKey(i);
+        if (direct)
+        {
+            key.drawButton(key.isPressed());
+            ++s_draws;
+        }
+        if (down != 1)
+            continue;
+
+        bool layout = i == TFT_Keyboard::Shift || s_shift;
+        if (i == TFT_Keyboard::Shift)
+            s_shift = true;
+        else
+        {
+            char label[KEYBOARD_LABEL_LEN];
+            TFT_Keyboard::keyLabel(&keyboardQwerty, i, false, s_shift, label);
+            s_field.append(label);
+            s_shift = false;
+            if (direct)
+            {
+                s_field.update();
+                ++s_draws;
+            }
+        }
+        if (layout)
+        {
+            s_keyboard.setLayout(&keyboardQwerty, false, s_shift);
+            if (direct)
+            {
+                s_keyboard.draw(&keyboardQwerty, false, s_shift);
+                ++s_draws;
+            }
+        }
+    }
+}
+
+struct FrameCost
+{
+    uint32_t frames;
+    uint32_t calls;
+    uint32_t maxFrameUs;
+    uint64_t bytes;
+    uint32_t hash;
+};
+
+static FrameCost run(bool direct, uint32_t budgetUs)
+{
+    reset();
+    HostSim::resetStats();
+    s_screen.resetStats();
+    s_draws = 0;
+
+    for (uint8_t i : TAPS)
+        tap(i, direct);
+
+    FrameCost cost = {1, 0, 0, 0, 0};
+    if (direct)
+    {
+        cost.calls = s_draws;
+        cost.maxFrameUs = HostSim::spiMicros(HostSim::stats().total);
+        // the widgets were drawn already, forget that they changed
+        s_screen.render();
+    }
+    else
+    {
+        cost.frames = 0;
+        while (s_screen.pending())
+        {
+            cost.calls += s_screen.render(budgetUs);
+            ++cost.frames;
+        }
+        cost.maxFrameUs = s_screen.stats().maxFrameUs;
+    }
+    cost.bytes = HostSim::stats().total.bytes;
+    cost.hash = HostSim::framebufferHash();
+    return cost;
+}
+
+static void status(const char *text, bool whole, uint64_t &bytes, uint32_t &pixels)
+{
+    HostSim::resetStats();
+    s_screen.resetStats();
+    s_status.setText(text);
+    if (whole)
+        s_screen.invalidate();
+    s_screen.render();
+    bytes = HostSim::stats().total.bytes;
+    pixels = s_screen.stats().pixels;
+}
+
+BENCH(widget)
+{
+    s_tft.init();
+    s_tft.setRotation(1);
+    s_keyboard.useCache(false);
+
+    FrameCost direct = run(true, WIDGET_NO_BUDGET);
+    FrameCost tree = run(false, WIDGET_NO_BUDGET);
+    FrameCost budgeted = run(false, 4000);
+
+    printf("Shift + 3 letters in one frame\n");
+    printf("  direct          %2lu draws  %6llu B  %5lu us in 1 frame\n", (unsigned long)direct.calls,
+           (unsigned long long)direct.bytes, (unsigned long)direct.maxFrameUs);
+    printf("  widget tree     %2lu draws  %6llu B  %5lu us in 1 frame\n", (unsigned long)tree.calls,
+           (unsigned long long)tree.bytes, (unsigned long)tree.maxFrameUs);
+    printf("  tree, 4 ms      %2lu draws  %6llu B  %5lu us max over %lu frames\n", (unsigned long)budgeted.calls,
+           (unsigned long long)budgeted.bytes, (unsigned long)budgeted.maxFrameUs, (unsigned long)budgeted.frames);
+    printf("  pixels          %s\n",
+           benchCheck(direct.hash == tree.hash && tree.hash == budgeted.hash) ? "identical" : "DIFFER");
+
+    uint64_t bytes[2];
+    uint32_t pixels[2];
+    uint32_t hash[2];
+    for (uint8_t whole = 0; whole < 2; ++whole)
+    {
+        reset();
+        status("Connecting to MessageBox retries: 1", whole, bytes[whole], pixels[whole]);
+        hash[whole] = HostSim::framebufferHash();
+    }
+    printf("status line changed\n");
+    printf("  whole screen    %7lu px repainted  %6llu B\n", (unsigned long)pixels[1], (unsigned long long)bytes[1]);
+    printf("  damaged only    %7lu px repainted  %6llu B\n", (unsigned long)pixels[0], (unsigned long long)bytes[0]);
+    printf("  pixels          %s\n", benchCheck(hash[0] == hash[1]) ? "identical" : "DIFFER");
+}
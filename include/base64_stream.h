@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Arduino.h>
+
+// input bytes per write to the output Print, 64 characters
+#define BASE64_CHUNK_SIZE 48
+
+/**
+ * Base64 (RFC 4648, standard alphabet, padded) a piece at a time. State
+ * carries over between calls, so a payload can be encoded as it is
+ * produced, or decoded as it comes off the network, without either side
+ * of it in RAM as a whole.
+ *
+ * encode() and decode() work buffer to buffer. Given a Print, write()
+ * passes the result on in BASE64_CHUNK_SIZE pieces from the stack, so a
+ * codec can stand between a producer and PubSubClient::write(), or between
+ * the client and a PayloadSink or ImageDecoder. finish() ends the payload
+ * and makes the codec ready for the next.
+ **/
+class Base64Encoder : public Print
+{
+    public:
+    Base64Encoder(Print *out = nullptr);
+
+    // characters out for length bytes in, whatever came before
+    static size_t encodedLength(size_t length) { return (length + 2) / 3 * 4; }
+
+    // out needs encodedLength(length) characters, returns how many it got
+    size_t encode(const uint8_t *in, size_t length, char *out);
+    // the last group with its padding, up to 4 characters
+    size_t finish(char *out);
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    bool finish();
+
+    private:
+    Print *m_out;
+    uint8_t m_group[3];
+    uint8_t m_pending;
+};
+
+class Base64Decoder : public Print
+{
+    public:
+    Base64Decoder(Print *out = nullptr);
+
+    // bytes out for length characters in, whatever came before
+    static size_t decodedLength(size_t length) { return (length + 3) / 4 * 3; }
+
+    // line breaks and spaces are skipped, out needs decodedLength(length)
+    // bytes, returns how many it got
+    size_t decode(const char *in, size_t length, uint8_t *out);
+    // what an unpadded payload left, up to 2 bytes
+    size_t finish(uint8_t *out);
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    // false if anything was not Base64
+    bool finish();
+
+    // a character outside the alphabet or after the padding, or a lone
+    // character at the end; kept after finish() until the next payload
+    bool error() const { return m_error; }
+
+    private:
+    Print *m_out;
+    uint32_t m_bits;
+    uint8_t m_count; // sextets in m_bits
+    bool m_padded;
+    bool m_error;
+    bool m_finished;
+
+    uint8_t *tail(uint8_t *out);
+};
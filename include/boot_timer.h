@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION "dev" // set with -D FIRMWARE_VERSION=\"x.y\" in build_flags
+#endif
+
+/**
+ * Boot milestones, recorded as micros() since power-on in a static table.
+ * Each phase is stamped the first time it completes only, so reconnects later
+ * on do not disturb the boot figures. print() gives the table with the time
+ * each phase took; format() packs it into one line for publishing.
+ **/
+class BootTimer
+{
+    public:
+    enum Phase
+    {
+        SetupStart,
+        ConfigLoad,
+        DisplayInit,
+        TouchCalibrate,
+        SetupDelay,
+        TlsSetup,
+        MqttSetup,
+        SetupDone,
+        WifiConnected,
+        MqttOnline,
+        FirstMessage,
+        PhaseCount
+    };
+
+    static void mark(Phase phase);
+    static uint32_t at(Phase phase) { return s_marks[phase]; }
+    static bool reached(Phase phase) { return s_marks[phase] != 0; }
+
+    static void print(Print &out);
+    // "fw=<version> <phase>=<us> ... total=<us>", the time each reached phase
+    // took and the time of the last one
+    static size_t format(char *buffer, size_t size);
+
+    private:
+    static uint32_t s_marks[PhaseCount];
+
+    static uint32_t took(uint8_t phase);
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define CONFIG_FILE "/config.bin"
+#define CONFIG_TMP_FILE "/config.tmp"
+#define CONFIG_MAGIC 0x424D // "MB"
+#define CONFIG_VERSION 1
+#define CONFIG_SSID_LEN 33     // 32 + NUL
+#define CONFIG_PASSWORD_LEN 65 // 64 + NUL
+
+// files written by earlier firmware, migrated on first boot
+#define LEGACY_CALIBRATION_FILE "/TouchCalData"
+#define LEGACY_WIFI_FILE "/WifiData"
+
+struct ConfigRecord
+{
+    uint16_t magic;
+    uint8_t version;
+    uint8_t flags;
+    uint16_t touchCal[5];
+    char ssid[CONFIG_SSID_LEN];
+    char password[CONFIG_PASSWORD_LEN];
+    uint32_t crc; // CRC-32 of everything above
+};
+
+/**
+ * All persistent settings in one binary record. begin() mounts SPIFFS, the
+ * only place that does, and loads the record with a single read. save()
+ * writes a temporary file and renames it over the record, so a reset part
+ * way through leaves either the old or the new record; begin() finishes an
+ * interrupted rename and rejects anything whose magic, version or CRC does
+ * not match.
+ **/
+class ConfigStore
+{
+    public:
+    enum Flags
+    {
+        HasCalibration = 1,
+        HasWifi = 2
+    };
+
+    ConfigStore(void);
+
+    bool begin();
+    bool save();
+
+    bool hasCalibration() { return m_record.flags & HasCalibration; }
+    const uint16_t *calibration() { return m_record.touchCal; }
+    void setCalibration(const uint16_t calData[5]);
+    void clearCalibration() { m_record.flags &= ~HasCalibration; }
+
+    bool hasWifi() { return m_record.flags & HasWifi; }
+    const char *ssid() { return m_record.ssid; }
+    const char *password() { return m_record.password; }
+    void setWifi(const char *ssid, const char *password);
+    void clearWifi() { m_record.flags &= ~HasWifi; }
+
+    private:
+    ConfigRecord m_record;
+
+    void reset();
+    bool load(const char *path);
+    bool migrate();
+};
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <Arduino.h>
+
+// CRC-32 (IEEE) of data. Pass the previous result as crc to continue over a
+// record read in pieces.
+uint32_t crc32(const uint8_t *data, size_t length, uint32_t crc = 0);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+#define HIT_INDEX_MAX_WIDGETS 48
+#define HIT_INDEX_MAX_ROWS 8
+#define HIT_NONE 0xFF
+
+/**
+ * Touch hit-test index. Widgets that share a top edge and height form a row
+ * (keyboard rows, the SSID/password boxes), rows are kept sorted by y and
+ * each row by x, so a touch resolves to a single widget with a scan over a
+ * handful of rows and a binary search in one of them.
+ *
+ * update() also tracks which widgets need their press state refreshed, so a
+ * screen only calls press() on the at most three widgets touched in the last
+ * three samples instead of on every widget every frame.
+ **/
+class TFT_Hit_Index
+{
+    private:
+    struct Row
+    {
+        int16_t y, h;
+        uint8_t first, count;
+    };
+    struct Cell
+    {
+        int16_t x, w;
+        uint8_t id;
+    };
+
+    Row m_rows[HIT_INDEX_MAX_ROWS];
+    Cell m_cells[HIT_INDEX_MAX_WIDGETS];
+    uint8_t m_rowCount, m_cellCount;
+    uint8_t m_hits[3]; // widget under the touch now, one and two samples ago
+
+    public:
+    TFT_Hit_Index(void);
+
+    void clear();
+    bool add(uint8_t id, int16_t x, int16_t y, int16_t w, int16_t h);
+    uint8_t find(int16_t x, int16_t y) const;
+
+    // feed one touch sample, fills changed with the widgets whose press()
+    // has to be called this frame and returns how many there are
+    uint8_t update(bool touched, int16_t x, int16_t y, uint8_t changed[3]);
+    bool isDown(uint8_t id) const { return id != HIT_NONE && m_hits[0] == id; }
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <TFT_eSPI.h>
+
+#define IMAGE_MAGIC 0x49 // 'I'
+#define IMAGE_VERSION 1
+#define IMAGE_HEADER_SIZE 8
+// the panel's long side, the scanline buffer is this many pixels
+#define IMAGE_MAX_WIDTH 480
+
+#define IMAGE_RGB565 0
+#define IMAGE_PALETTE 1
+
+/**
+ * Picture messages, decoded as their bytes come in and drawn a row at a
+ * time, so an image never has to fit in memory. tools/png2mbi.py makes them.
+ *
+ *   message: magic, version, encoding, palette size - 1 (0 for RGB565),
+ *            width, height (2 bytes little endian each),
+ *            palette (RGB565, 2 bytes little endian each), then rows
+ *   row:     packets, none running past the end of the row
+ *   packet:  control c, then c + 1 pixels for c < 128, or one pixel to
+ *            repeat c - 127 times
+ *   pixel:   RGB565, 2 bytes little endian, or a palette index, 1 byte
+ *
+ * write() takes the message in pieces of any size, as they come off the
+ * network or a file. Each row is pushed to the panel through its own
+ * address window as it completes, so the bus is free between rows for the
+ * touch controller. Working memory is one scanline and the palette. Rows
+ * and columns past the edge of the panel are decoded and not drawn.
+ **/
+class ImageDecoder : public Print
+{
+    public:
+    ImageDecoder(void);
+
+    // the next image goes with its top left corner at x, y
+    void begin(TFT_eSPI *gfx, int16_t x, int16_t y);
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    // stops taking bytes once the image is complete or found to be bad
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+    bool done() const { return m_state == Done; }
+    bool error() const { return m_state == Failed; }
+    uint16_t width() const { return m_width; }
+    uint16_t height() const { return m_height; }
+    uint16_t rows() const { return m_y; }
+
+    static bool isImage(const uint8_t *data, uint32_t length)
+    {
+        return length >= IMAGE_HEADER_SIZE && data[0] == IMAGE_MAGIC && data[1] == IMAGE_VERSION;
+    }
+
+    private:
+    enum State : uint8_t
+    {
+        Header,
+        Palette,
+        Control,
+        Literal,
+        Repeat,
+        Done,
+        Failed
+    };
+
+    TFT_eSPI *m_tft;
+    int16_t m_left, m_top;
+    State m_state;
+    uint8_t m_header[IMAGE_HEADER_SIZE];
+    uint16_t m_got;     // header or palette bytes so far
+    bool m_palettized;
+    uint16_t m_colours;
+    uint16_t m_width, m_height;
+    uint16_t m_x, m_y;  // next pixel
+    uint8_t m_count;    // pixels left in the packet
+    bool m_half;        // the low byte of an RGB565 pixel is in m_low
+    uint8_t m_low;
+    uint16_t m_palette[256];
+    uint16_t m_line[IMAGE_MAX_WIDTH];
+
+    bool readHeader();
+    bool pixel(const uint8_t *&data, const uint8_t *end, uint16_t &colour);
+    void endPacket();
+    void pushRow();
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <FS.h>
+
+#include "widget.h"
+#include "keyboard_layout.h"
+
+#define KEYBOARD_BACKGROUND TFT_BLACK
+// what repainting a key sends beyond its own area, in pixels: the windows
+// of its rounded corners, outline and label (keyboard_cache bench)
+#define KEYBOARD_KEY_OVERHEAD_PX 320
+// what opening a window costs, in pixels, so a gap in a changed row shorter
+// than this is sent again rather than skipped
+#define KEYBOARD_SPAN_PX 4
+// runs buffered for one window of a bitmap update
+#define KEYBOARD_SPAN_SEGMENTS 32
+// rows of the keyboard rendered at a time when building a cached bitmap
+#define KEYBOARD_STRIP_ROWS 8
+
+/**
+ * On-screen keyboard. Remembers the label each key currently shows on the
+ * panel so that a Shift/Caps/Sym change only repaints the keys whose glyph
+ * actually changed, instead of all 42. Labels and key positions come from a
+ * KeyboardLayout in flash; a layout with other key positions clears the
+ * keyboard before it is drawn.
+ *
+ * Each layout (the set of labels) is also rendered once, a strip at a time
+ * through a sprite, into a run-length coded bitmap of the whole keyboard
+ * region in SPIFFS, named after a hash of the labels and geometry. A layout
+ * change then walks the bitmap on the panel and the new one together and
+ * sends only the pixels that differ, row by row in one pass, so the new
+ * keyboard appears in one frame and a Shift flip costs little more than the
+ * glyphs that change. From a cleared region the old bitmap is plain
+ * background. begin() removes the bitmaps of layouts the keyboard is no
+ * longer given.
+ *
+ * As a widget the keyboard draws the layout last given to setLayout(), and
+ * the keys whose press state changed, in update(); a paint() repaints the
+ * keys under its clip. The keys stay inside the keyboard rather than being
+ * widgets of their own so a layout change can still be one bitmap.
+ **/
+class TFT_Keyboard : public TFT_Widget
+{
+    private:
+    TFT_eSPI_Button m_keys[KEYBOARD_KEYS];
+    char m_shown[KEYBOARD_KEYS][KEYBOARD_LABEL_LEN];
+    bool m_drawn;
+    bool m_useCache;
+
+    const KeyboardLayout *m_layout;
+    KeyboardGeometry m_geometry;
+    // where the keys on the panel are, m_geometry once drawn
+    KeyboardGeometry m_drawnGeometry;
+    bool m_capsLock, m_shiftPressed;
+    // keys to repaint whatever their label, and keys whose press state changed
+    uint64_t m_staleKeys, m_pressedKeys;
+
+    void useLayout(const KeyboardLayout *layout);
+    void initKey(uint8_t i, TFT_eSPI *gfx, char *label, int16_t dx, int16_t dy);
+    // from is what the panel shows, nullptr for background
+    bool blit(char labels[KEYBOARD_KEYS][KEYBOARD_LABEL_LEN], char from[KEYBOARD_KEYS][KEYBOARD_LABEL_LEN]);
+    bool openCache(char labels[KEYBOARD_KEYS][KEYBOARD_LABEL_LEN], File &f, struct KeyboardCacheHeader &header);
+    bool renderCache(char labels[KEYBOARD_KEYS][KEYBOARD_LABEL_LEN], const char *path);
+
+    public:
+    enum ControlKey
+    {
+        OK = 0,
+        Clear,
+        Del,
+        Shift,
+        Caps,
+        Sym,
+        FirstCharKey
+    };
+
+    TFT_Keyboard(void);
+
+    void init(TFT_eSPI *gfx);
+    // init(), and removes cached bitmaps of anything but these layouts
+    void begin(TFT_eSPI *gfx, const KeyboardLayout *const layouts[], uint8_t count);
+
+    // allow draw() to use the bitmaps cached in SPIFFS, on by default
+    void useCache(bool enabled) { m_useCache = enabled; }
+
+    // paint the keys whose label differs from what is on the panel,
+    // returns how many keys were repainted
+    uint8_t draw(const KeyboardLayout *layout, bool capsLock, bool shiftPressed);
+
+    // the layout update() draws
+    void setLayout(const KeyboardLayout *layout, bool capsLock, bool shiftPressed);
+    const KeyboardLayout *layout() { return m_layout; }
+    // Shift and Caps act on the current layout
+    bool hasLetters() { return m_layout && (pgm_read_byte(&m_layout->flags) & KEYBOARD_LETTERS); }
+    // key i is in the current layout and not a gap
+    bool hasKey(uint8_t i);
+    // key i was pressed or released
+    void invalidateKey(uint8_t i);
+
+    void paint(const TFT_Rect &clip) override;
+    void update() override;
+
+    // empty for a gap
+    static void keyLabel(const KeyboardLayout *layout, uint8_t i,
+                         bool capsLock, bool shiftPressed, char label[KEYBOARD_LABEL_LEN]);
+    static void geometry(const KeyboardLayout *layout, KeyboardGeometry &geometry);
+
+    // panel rectangle of key i
+    static void keyRect(const KeyboardGeometry &geometry, uint8_t i, int16_t &x, int16_t &y, uint16_t &w, uint16_t &h);
+    // bounding box of all keys, the area a cached bitmap covers
+    static void region(const KeyboardGeometry &geometry, int16_t &x, int16_t &y, uint16_t &w, uint16_t &h);
+    // the same in the current layout
+    void keyRect(uint8_t i, int16_t &x, int16_t &y, uint16_t &w, uint16_t &h) { keyRect(m_geometry, i, x, y, w, h); }
+    void region(int16_t &x, int16_t &y, uint16_t &w, uint16_t &h) { region(m_geometry, x, y, w, h); }
+
+    TFT_eSPI_Button &key(uint8_t i) { return m_keys[i]; }
+    const char *shownLabel(uint8_t i) { return m_shown[i]; }
+};
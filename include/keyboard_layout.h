@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+
+// keys in the largest layout, the first six are always the control keys
+#define KEYBOARD_KEYS 42
+#define KEYBOARD_LABEL_LEN 6
+#define KEYBOARD_MAX_ROWS 5
+// Shift and Caps change the case of this layout's keys
+#define KEYBOARD_LETTERS 0x01
+
+// letters layout the firmware starts with, -D KEYBOARD_LANGUAGE=keyboardAzerty
+#ifndef KEYBOARD_LANGUAGE
+#define KEYBOARD_LANGUAGE keyboardQwerty
+#endif
+
+struct KeyboardRow
+{
+    uint8_t keys;
+    int16_t x;     // left edge of the first key
+    uint8_t pitch; // left edge of one key to the next
+    uint8_t w;
+};
+
+// where the keys of a layout go, rows are numbered from the top
+struct KeyboardGeometry
+{
+    uint8_t rows;
+    int16_t y; // top of the first row
+    uint8_t rowPitch;
+    uint8_t h;
+    KeyboardRow row[KEYBOARD_MAX_ROWS];
+};
+
+/**
+ * A keyboard as constant data in flash: its geometry, and the label of each
+ * key in order, row by row. A key with an empty label is a gap, neither
+ * drawn nor touchable. Every layout starts with the same row of control
+ * keys, OK, Clear, Del, Shift, Caps and Sym, in the same place, so a press
+ * that switches layouts lands on the same key in the new one.
+ *
+ * Flash on the ESP8266 is read a word at a time, read layouts with
+ * memcpy_P() and friends, never through the pointer.
+ **/
+struct KeyboardLayout
+{
+    char name[8];
+    uint8_t flags;
+    KeyboardGeometry geometry;
+    char labels[KEYBOARD_KEYS][KEYBOARD_LABEL_LEN];
+};
+
+extern const KeyboardLayout keyboardQwerty;
+extern const KeyboardLayout keyboardAzerty;
+extern const KeyboardLayout keyboardQwertz;
+extern const KeyboardLayout keyboardSymbols;
+extern const KeyboardLayout keyboardNumeric;
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "widget.h"
+
+// room for "Connecting to <32-character SSID> retries: 255"
+#define LABEL_CAPACITY 63
+
+/**
+ * A line of text over its own background. The text is copied into the
+ * label, and only a different text invalidates it. datum places the text
+ * within the bounds the way TFT_eSPI places a string about a point, TL_DATUM
+ * at the top left corner, TC_DATUM centred along the top edge, and so on.
+ **/
+class TFT_Label : public TFT_Widget
+{
+    private:
+    char m_text[LABEL_CAPACITY + 1];
+    uint16_t m_textcolor, m_fillcolor;
+    uint8_t m_font, m_datum;
+
+    public:
+    TFT_Label(void);
+
+    void init(TFT_eSPI *gfx, int16_t x, int16_t y, int16_t w, int16_t h,
+              uint16_t textcolor, uint16_t fill, uint8_t font, uint8_t datum = TL_DATUM);
+
+    void setText(const char *text);
+    const char *text() const { return m_text; }
+
+    void paint(const TFT_Rect &clip) override;
+};
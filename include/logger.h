@@ -0,0 +1,134 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// threshold of modules that do not set their own, -D LOG_LEVEL_DEFAULT=4 in
+// build_flags for a debug build
+#ifndef LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_DEFAULT LOG_LEVEL_INFO
+#endif
+
+// power of two
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 2048
+#endif
+// one record, longer text is cut
+#define LOG_RECORD_MAX 128
+
+// binary records start with this, a byte text never has
+#define LOG_SYNC 0xA5
+
+/**
+ * Logging that does not hold up the loop. log() formats a record into a RAM
+ * ring and returns; drain() moves queued bytes to the UART only as far as
+ * its transmit FIFO has room, and is run from the scheduler's idle slot, so
+ * a burst of messages costs the formatting and never the line time of the
+ * baud rate. When the ring is full records are dropped, counted, and the
+ * count logged once there is room again.
+ *
+ * A module sets its name, and optionally its own threshold, before the
+ * include:
+ *
+ *   #define LOG_MODULE "mqtt"
+ *   #define LOG_LEVEL LOG_LEVEL_DEBUG
+ *   #include "logger.h"
+ *
+ *   LOG_INFO("retry in %lu ms", wait);
+ *
+ * Messages above the threshold compile to nothing, format strings included.
+ * Formats live in flash. Logger is a Print too, so anything that prints a
+ * report (BootTimer, Scheduler) can print into it, a line per record.
+ *
+ * Built with -D LOG_BINARY records are not formatted on the device at all:
+ * each is LOG_SYNC, its length, the level, micros(), where the format string
+ * sits relative to logAnchor, and the raw arguments, strings copied. That is
+ * a fraction of the text over the UART; tools/log_decode.py turns the stream
+ * back into text with the firmware ELF.
+ **/
+class Logger : public Print
+{
+    public:
+    struct Stats
+    {
+        uint32_t records;
+        uint32_t dropped;
+        uint32_t bytes;      // queued, of text or records
+        uint16_t maxQueued;  // ring high-water mark
+    };
+
+    Logger(void);
+
+    // records logged before begin() wait in the ring
+    void begin(HardwareSerial &out) { m_out = &out; }
+
+    void log(uint8_t level, PGM_P format, ...);
+    void vlog(uint8_t level, PGM_P format, va_list args);
+
+    bool pending() const { return m_head != m_tail; }
+    uint16_t queued() const { return (m_head - m_tail) & (LOG_RING_SIZE - 1); }
+    // writes what fits in the UART FIFO right now, true while more is queued
+    bool drain();
+    // waits until all of it has gone, for before a restart
+    void flush() override;
+
+    // Print: every line becomes an info record
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    const Stats &stats() { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+
+    private:
+    HardwareSerial *m_out;
+    uint8_t m_ring[LOG_RING_SIZE];
+    uint16_t m_head, m_tail;
+    uint32_t m_missed; // dropped since the last record that fitted
+    char m_line[LOG_RECORD_MAX];
+    uint8_t m_lineLength;
+    Stats m_stats;
+
+    size_t encode(uint8_t *record, uint8_t level, PGM_P format, va_list args);
+    size_t encodef(uint8_t *record, uint8_t level, PGM_P format, ...);
+    bool push(const uint8_t *record, size_t length);
+};
+
+extern Logger logger;
+// binary records give their format as an offset from here
+extern const char logAnchor[];
+
+#ifndef LOG_MODULE
+#define LOG_MODULE "main"
+#endif
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEFAULT
+#endif
+
+#define LOG_RECORD(level, format, ...) logger.log(level, PSTR(LOG_MODULE ": " format), ##__VA_ARGS__)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(format, ...) LOG_RECORD(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(format, ...) ((void)0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(format, ...) LOG_RECORD(LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#else
+#define LOG_WARN(format, ...) ((void)0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(format, ...) LOG_RECORD(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...) ((void)0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(format, ...) LOG_RECORD(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...) ((void)0)
+#endif
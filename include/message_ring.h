@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+#define MESSAGE_RING_SLOTS 4
+#define MESSAGE_SLOT_SIZE 1024
+// where a payload too large for a slot is kept, one file a slot
+#define MESSAGE_FILE_FORMAT "/inbox%u.bin"
+#define MESSAGE_FILE_LEN 16
+
+struct MessageSlot
+{
+    uint16_t length;   // bytes held in data
+    uint32_t received; // bytes the broker sent, larger than length if truncated
+    const char *file;  // set when the payload was spooled to SPIFFS instead
+    char data[MESSAGE_SLOT_SIZE + 1]; // always NUL terminated
+};
+
+/**
+ * Fixed-capacity single-producer/single-consumer queue of inbound messages.
+ * The MQTT callback push()es each payload with one memcpy into a slot that
+ * was allocated up front; the UI peek()s and pop()s when it is ready to draw.
+ * Neither side allocates, and the producer never touches rendering state.
+ *
+ * When every slot is full the new message is dropped and counted rather than
+ * overwriting a slot the consumer may be reading. A payload spooled to SPIFFS
+ * goes to the file nextFile() names, which belongs to the slot it will take,
+ * so it stays until that slot is popped.
+ **/
+class MessageRing
+{
+    public:
+    MessageRing(void);
+
+    // producer side only
+    bool push(const uint8_t *payload, uint32_t length);
+    bool pushFile(const char *path, uint32_t length);
+    const char *nextFile(); // nullptr when full
+
+    // consumer side only
+    const MessageSlot *peek();
+    void pop();
+
+    uint32_t dropped() { return m_dropped; }
+
+    private:
+    MessageSlot m_slots[MESSAGE_RING_SLOTS];
+    char m_files[MESSAGE_RING_SLOTS][MESSAGE_FILE_LEN];
+    std::atomic<uint8_t> m_head; // next slot to write, owned by the producer
+    std::atomic<uint8_t> m_tail; // next slot to read, owned by the consumer
+    uint32_t m_dropped;
+
+    MessageSlot *claim();
+    void publish();
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <ESP8266WiFi.h>
+#include <PubSubClient.h>
+
+#define MQTT_BACKOFF_MIN_MS 1000
+#define MQTT_BACKOFF_MAX_MS 60000
+#define MQTT_CLIENT_ID_LEN 40
+#define MQTT_TOPIC_LEN 64
+
+class TopicRouter;
+
+/**
+ * Keeps the broker connection up without blocking the loop. Each call to
+ * loop() does at most one step: wait out the backoff, connect, subscribe
+ * every topic the router has, announce, or service the client. Failed
+ * connects back off exponentially up to MQTT_BACKOFF_MAX_MS with random
+ * jitter; Wi-Fi coming back skips whatever backoff is left.
+ **/
+class MqttConnection
+{
+    public:
+    enum State
+    {
+        Offline, // no Wi-Fi
+        Waiting,
+        Connecting,
+        Subscribing,
+        Announcing,
+        Online
+    };
+
+    struct Stats
+    {
+        uint32_t attempts;
+        uint32_t failures;
+        uint32_t disconnectedMs; // total, not counting the current outage
+        uint32_t lastHandshakeUs;
+        uint32_t maxHandshakeUs;
+        uint64_t totalHandshakeUs;
+    };
+
+    typedef void (*OnlineCallback)(void);
+
+    MqttConnection(PubSubClient &client);
+
+    // called each time the connection is up, subscribed and announced
+    void onOnline(OnlineCallback callback) { m_onOnline = callback; }
+
+    void begin(const char *clientId, TopicRouter &router, const char *announceTopic);
+    void loop();
+
+    PubSubClient &client() { return m_client; }
+    State state() { return m_state; }
+    bool isOnline() { return m_state == Online; }
+    const Stats &stats() { return m_stats; }
+    uint32_t currentOutageMs();
+
+    private:
+    PubSubClient &m_client;
+    State m_state;
+    char m_clientId[MQTT_CLIENT_ID_LEN];
+    TopicRouter *m_router;
+    char m_announceTopic[MQTT_TOPIC_LEN];
+    uint32_t m_backoffMs;
+    uint32_t m_nextAttemptMs;
+    uint32_t m_disconnectedSinceMs;
+    Stats m_stats;
+    OnlineCallback m_onOnline;
+
+    void connect();
+    void lost();
+    void retryLater();
+    void setState(State state);
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "mqtt_connection.h"
+
+// the spool refuses messages beyond this, SPIFFS is shared with the inbox
+#define OUTBOX_MAX_BYTES 65536
+// payload bytes read from the spool per client write
+#define OUTBOX_CHUNK_SIZE 128
+// defaults, see setLimits()
+#define OUTBOX_BATCH 8
+#define OUTBOX_MESSAGES_PER_SECOND 20
+#define OUTBOX_BYTES_PER_SECOND 8192
+
+#define OUTBOX_MESSAGE 'M'
+#define OUTBOX_SENT 'S'
+
+struct OutboxRecord
+{
+    uint8_t type;
+    uint8_t topicLength;
+    uint16_t reserved;
+    // payload bytes for a message, the offset everything before has been
+    // sent up to for a sent mark
+    uint32_t length;
+    uint32_t crc; // CRC-32 of topic and payload, or of length
+};
+
+/**
+ * Messages for the broker that survive the link, or the device, going down.
+ * publish() sends straight away while the connection is online and nothing
+ * older is waiting; otherwise the message is appended to a spool file on
+ * SPIFFS and publish() returns without touching the network.
+ *
+ * The spool is append-only: message records, and after every batch that
+ * went out a sent mark giving the offset of the first message still owed.
+ * Nothing is rewritten in place, and once everything has gone the file is
+ * removed. begin() reads it back after a restart from the last mark; a
+ * record cut short by a reset fails its CRC and is dropped along with
+ * anything behind it. Delivery is at least once: a restart between sending
+ * a batch and marking it repeats that batch.
+ *
+ * service() replays the spool oldest first, a batch per call, streaming
+ * each payload from the file in OUTBOX_CHUNK_SIZE pieces so memory use does
+ * not depend on message size. Messages and bytes per second are token
+ * buckets holding up to a second's worth, shared with direct sends, so a
+ * reconnect does not flood the link.
+ **/
+class OutboundQueue
+{
+    public:
+    struct Stats
+    {
+        uint32_t sent;     // straight away
+        uint32_t spooled;
+        uint32_t replayed; // from the spool
+        uint32_t dropped;  // the spool was full or would not take it
+        uint32_t limited;  // service() calls the rate limits cut short
+        uint32_t maxSpoolBytes;
+    };
+
+    OutboundQueue(MqttConnection &connection, const char *spoolPath);
+
+    // picks up what an earlier run left unsent, SPIFFS must be mounted
+    bool begin();
+
+    // 0 for no limit
+    void setLimits(uint8_t batch, uint16_t messagesPerSecond, uint32_t bytesPerSecond);
+
+    // false if the message could neither be sent nor spooled
+    bool publish(const char *topic, const uint8_t *payload, uint32_t length);
+    bool publish(const char *topic, const char *payload)
+    {
+        return publish(topic, (const uint8_t *)payload, strlen(payload));
+    }
+
+    // replays a batch while online
+    void service();
+
+    uint32_t pending() { return m_pending; }
+    uint32_t spoolBytes() { return m_end; }
+    const Stats &stats() { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+
+    private:
+    MqttConnection &m_connection;
+    const char *m_spoolPath;
+    uint32_t m_cursor;  // first record not yet sent
+    uint32_t m_end;     // end of the last whole record
+    uint32_t m_pending; // messages from m_cursor on
+    uint8_t m_batch;
+    uint16_t m_messagesPerSecond;
+    uint32_t m_bytesPerSecond;
+    // thousandths of a message and of a byte
+    int32_t m_messageCredit;
+    int32_t m_byteCredit;
+    uint32_t m_refilledMs;
+    Stats m_stats;
+
+    void refill();
+    bool take(uint32_t bytes);
+    bool send(const char *topic, const uint8_t *payload, uint32_t length);
+    bool spool(const char *topic, const uint8_t *payload, uint32_t length);
+    bool readRecord(File &f, OutboxRecord &record, char *topic);
+    bool checkPayload(File &f, const OutboxRecord &record, const char *topic);
+    bool markSent();
+    bool compact();
+};
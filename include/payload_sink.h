@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+#define PAYLOAD_CHUNK_SIZE 1024
+
+/**
+ * Stream handed to PubSubClient::setStream(). The client writes every byte
+ * of a publish payload here as it comes off the socket, so payloads far
+ * larger than the client buffer are received without a matching allocation.
+ *
+ * Payloads that fit in one chunk stay in RAM. The first time a chunk fills
+ * it is written out to a spool file on SPIFFS, and so on for every chunk
+ * after it. Once the MQTT callback has run, commit() moves the spooled
+ * payload to its final path or discard() throws it away.
+ **/
+class PayloadSink : public Stream
+{
+    public:
+    PayloadSink(const char *spoolPath);
+
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+    // bytes received for the current payload
+    uint32_t size() { return m_size; }
+    // true once the payload outgrew the chunk and went to SPIFFS
+    bool spilled() { return m_spilled; }
+    // the payload, only while !spilled()
+    const uint8_t *data() { return m_chunk; }
+    // false if SPIFFS refused a write, the spooled payload is then incomplete
+    bool ok() { return !m_failed; }
+
+    bool commit(const char *path);
+    void discard();
+
+    private:
+    const char *m_spoolPath;
+    File m_spool;
+    uint8_t m_chunk[PAYLOAD_CHUNK_SIZE];
+    uint16_t m_used;
+    uint32_t m_size;
+    bool m_spilled;
+    bool m_failed;
+
+    void flushChunk();
+    void reset();
+};
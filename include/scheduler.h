@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define SCHEDULER_MAX_TASKS 8
+#define SCHEDULER_IDLE 0xFFFFFFFF
+
+/**
+ * Cooperative scheduler for loop(). A periodic task is due every periodMs
+ * from its last deadline, not from when it last ran, so a late run does not
+ * push the rest of the schedule back. A deadline task only runs once per
+ * runIn(), which is how event-driven work (an inbound message) gets onto the
+ * loop without polling for it.
+ *
+ * run() runs the due tasks earliest deadline first, each at most once, then
+ * sleeps until the next deadline. Sleeping is delay(), so the Wi-Fi stack and
+ * Ticker callbacks get the time. For every task it keeps how late it started
+ * and how long it took, which is what to look at when the UI stutters.
+ *
+ * The idle function runs once a pass, after the due tasks, for work that
+ * should only ever take time nothing else wants (draining the log). While
+ * it says it has more to do, run() sleeps no longer than a millisecond.
+ **/
+class Scheduler
+{
+    public:
+    typedef void (*TaskFunction)(void);
+    // true while there is more to do
+    typedef bool (*IdleFunction)(void);
+
+    struct TaskStats
+    {
+        uint32_t runs;
+        uint32_t maxLateUs;
+        uint64_t totalLateUs;
+        uint32_t maxRunUs;
+    };
+
+    Scheduler(void);
+
+    // both return the task id, or -1 if there is no room
+    int8_t every(const char *name, uint32_t periodMs, TaskFunction task);
+    int8_t deadline(const char *name, TaskFunction task);
+
+    // due again delayMs from now, 0 for as soon as possible
+    void runIn(uint8_t id, uint32_t delayMs);
+    void cancel(uint8_t id);
+
+    void onIdle(IdleFunction idle) { m_idle = idle; }
+
+    void run();
+
+    const TaskStats &stats(uint8_t id) { return m_tasks[id].stats; }
+    uint64_t idleUs() { return m_idleUs; }
+    void printStats(Print &out);
+    void resetStats();
+
+    private:
+    struct Task
+    {
+        const char *name;
+        TaskFunction function;
+        uint32_t periodUs; // 0 for a deadline task
+        uint32_t dueUs;
+        bool armed;
+        TaskStats stats;
+    };
+
+    Task m_tasks[SCHEDULER_MAX_TASKS];
+    uint8_t m_count;
+    IdleFunction m_idle;
+    uint64_t m_idleUs;
+    uint32_t m_statsSinceMs;
+
+    int8_t add(const char *name, uint32_t periodUs, TaskFunction task);
+    int8_t nextDue(uint32_t now, uint16_t ranMask);
+    uint32_t untilNext(uint32_t now);
+};
@@ -1,12 +1,25 @@
-#include <TFT_eSPI.h>
+#pragma once
 
-class TFT_Select_Box
+#include "widget.h"
+
+// heap a box may borrow for its sprite while drawing, 16 bits per pixel
+#define SELECT_BOX_SPRITE_BUDGET 8192
+
+/**
+ * Text box that can be selected for input. draw() composes the fill, outline
+ * and label in a TFT_eSprite and pushes it as one window, so the field never
+ * shows half-drawn. Boxes over SELECT_BOX_SPRITE_BUDGET, or drawn when the
+ * heap cannot supply the sprite, are drawn straight to the panel instead.
+ **/
+class TFT_Select_Box : public TFT_Widget
 {
     private:
-    int16_t m_x, m_y, m_w, m_h, m_outlinecolor, m_fillcolor, m_textcolor, m_selectcolor;
+    int16_t m_outlinecolor, m_fillcolor, m_textcolor, m_selectcolor;
     uint8_t m_textsize, m_textdatum;
-    TFT_eSPI *m_tft;
-    bool m_laststate, m_currstate;
+    bool m_useSprite;
+
+    bool drawSprite();
+    void drawDirect();
 
     public:
     bool m_selected;
@@ -19,20 +32,8 @@ class TFT_Select_Box
               String *label, uint8_t textsize);
 
     void draw();
+    void paint(const TFT_Rect &clip) override { draw(); }
+    void useSprite(bool enabled) { m_useSprite = enabled; }
 
-    void press(bool p)
-    {
-        m_laststate = m_currstate;
-        m_currstate = p;
-    }
-    bool contains(int16_t x, int16_t y)
-    {
-        return ((x >= m_x) && (x < (m_x + m_w)) &&
-                (y >= m_y) && (y < (m_y + m_h)));
-    }
-
-    bool isPressed() { return m_currstate; }
     bool isSelected() { return m_selected; }
-    bool justPressed() { return (m_currstate && !m_laststate); }
-    bool justReleased() { return (!m_currstate && m_laststate); }
-};
\ No newline at end of file
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+
+#define STROKE_MAGIC 0x53 // 'S'
+#define STROKE_VERSION 1
+
+/**
+ * Binary encoding of a drawing as strokes, for MQTT payloads.
+ *
+ *   message: magic, version, stroke*
+ *   stroke:  colour (RGB565, 2 bytes little endian), width (1 byte),
+ *            x, y (varint), then (dx, dy)* as zig-zag varints,
+ *            ending with the pair (0, 0)
+ *
+ * Touch samples a few pixels apart give deltas well under 64, so most points
+ * take two bytes. Repeated points are skipped, which is what frees (0, 0) to
+ * end a stroke.
+ **/
+class StrokeEncoder
+{
+    public:
+    StrokeEncoder(uint8_t *buffer, uint32_t capacity);
+
+    bool beginStroke(uint16_t colour, uint8_t width, int16_t x, int16_t y);
+    bool addPoint(int16_t x, int16_t y);
+    bool endStroke();
+
+    uint32_t length() { return m_length; }
+    // true if anything failed to fit; the buffer is then unusable
+    bool overflowed() { return m_overflow; }
+
+    private:
+    uint8_t *m_buffer;
+    uint32_t m_capacity, m_length;
+    int16_t m_x, m_y;
+    bool m_inStroke, m_overflow;
+
+    void put(uint8_t b);
+    void putVarint(uint32_t value);
+};
+
+class StrokeDecoder
+{
+    public:
+    StrokeDecoder(const uint8_t *data, uint32_t length);
+
+    // starts the next stroke, false at the end of the message or on error
+    bool nextStroke(uint16_t &colour, uint8_t &width, int16_t &x, int16_t &y);
+    // next point of the current stroke, false at its end or on error
+    bool nextPoint(int16_t &x, int16_t &y);
+
+    bool error() { return m_error; }
+
+    private:
+    const uint8_t *m_data;
+    uint32_t m_length, m_pos;
+    int16_t m_x, m_y;
+    bool m_inStroke, m_error;
+
+    bool get(uint8_t &b);
+    bool getVarint(uint32_t &value);
+};
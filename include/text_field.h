@@ -0,0 +1,78 @@
+#pragma once
+
+#include "widget.h"
+
+// longest WPA2 passphrase
+#define TEXT_FIELD_CAPACITY 63
+#define TEXT_FIELD_PAD 3
+#define TEXT_FIELD_MASK '*'
+
+/**
+ * Single line text input over an inline buffer, nothing on the heap. The
+ * x-advance of every glyph is measured once, when it is typed, so the field
+ * knows where each character sits without re-measuring the string.
+ *
+ * Edits only mark the field damaged from the first changed character on;
+ * update() then clears the cells that are no longer used and draws the new
+ * glyphs, so typing a character costs one glyph and deleting one costs one
+ * cell. Text wider than the field scrolls by half a field at a time, which
+ * needs one full repaint and keeps the following keystrokes incremental.
+ * A masked field draws every character as TEXT_FIELD_MASK through the same
+ * path. Edits mark the widget changed(), a screen calls update() for it.
+ **/
+class TFT_Text_Field : public TFT_Widget
+{
+    private:
+    uint16_t m_outlinecolor, m_fillcolor, m_textcolor, m_selectcolor;
+    uint8_t m_textsize, m_font;
+    bool m_masked, m_selected;
+
+    char m_text[TEXT_FIELD_CAPACITY + 1];
+    uint8_t m_advance[TEXT_FIELD_CAPACITY];
+    uint8_t m_maskAdvance;
+    uint8_t m_length;
+    uint8_t m_first; // first visible character
+
+    // what the panel shows
+    uint8_t m_drawnFirst;
+    int16_t m_drawnRight;
+    bool m_drawnSelected;
+    bool m_drawn;
+    uint8_t m_damagedFrom; // first character that changed since update()
+
+    void prepareText();
+    uint8_t measure(char c);
+    uint8_t advance(uint8_t i) { return m_masked ? m_maskAdvance : m_advance[i]; }
+    int16_t textTop();
+    int16_t textLeft() { return m_bounds.x + TEXT_FIELD_PAD; }
+    int16_t textRight() { return m_bounds.x + m_bounds.w - TEXT_FIELD_PAD; }
+    int16_t glyphX(uint8_t i);
+    void damage(uint8_t from);
+    bool scroll();
+    void drawGlyphs(uint8_t from);
+
+    public:
+    TFT_Text_Field(void);
+
+    // keeps whatever text the field already holds
+    void init(TFT_eSPI *gfx, int16_t x, int16_t y, int16_t w, int16_t h,
+              uint16_t outline, uint16_t fill, uint16_t textcolor, uint16_t selectcolor,
+              uint8_t textsize, uint8_t font = 2);
+
+    // false when the field is full
+    bool append(char c);
+    bool append(const char *text);
+    void erase();
+    void clear();
+    void setText(const char *text);
+    const char *text() const { return m_text; }
+    uint8_t length() const { return m_length; }
+
+    void setMasked(bool masked);
+    void setSelected(bool selected);
+    bool isSelected() { return m_selected; }
+
+    void draw();
+    void paint(const TFT_Rect &clip) override { draw(); }
+    void update() override;
+};
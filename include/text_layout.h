@@ -0,0 +1,60 @@
+#pragma once
+
+#include <TFT_eSPI.h>
+
+// 10,000 bytes of message in a 416 px view at ~60 characters a line, with
+// room for short lines
+#define TEXT_LAYOUT_MAX_LINES 512
+#define TEXT_LAYOUT_FIRST_GLYPH ' '
+#define TEXT_LAYOUT_LAST_GLYPH '~'
+#define TEXT_LAYOUT_GLYPHS (TEXT_LAYOUT_LAST_GLYPH - TEXT_LAYOUT_FIRST_GLYPH + 1)
+
+/**
+ * Line breaks for a block of text, worked out once. setFont() measures the
+ * x-advance of every printable ASCII glyph with textWidth() a single time
+ * and keeps them in a table, so laying out a message is one pass over its
+ * bytes adding up table entries, however slow textWidth() is for the font.
+ * Other bytes take no room, the built-in fonts do not draw them.
+ *
+ * Lines break at the last space that fits, at '\n', and inside a word only
+ * when the word alone is wider than the line. Spaces at a break hang off
+ * the end of the line rather than start the next. What is kept is the
+ * offset each line starts at, two bytes a line, so any line is found by
+ * index without measuring anything again. The text itself is not copied
+ * and has to stay as it was while the layout is used.
+ **/
+class TextLayout
+{
+    public:
+    TextLayout(void);
+
+    // a no-op for the font and size already measured
+    void setFont(TFT_eSPI *gfx, uint8_t font, uint8_t textsize = 1);
+    uint8_t advance(char c) const
+    {
+        uint8_t i = (uint8_t)c - TEXT_LAYOUT_FIRST_GLYPH;
+        return i < TEXT_LAYOUT_GLYPHS ? m_advance[i] : 0;
+    }
+    int16_t lineHeight() const { return m_lineHeight; }
+
+    // returns the number of lines
+    uint16_t layout(const char *text, uint16_t length, int16_t width);
+
+    uint16_t lines() const { return m_lines; }
+    // true when the text had more lines than TEXT_LAYOUT_MAX_LINES
+    bool truncated() const { return m_truncated; }
+    const char *line(uint16_t i) const { return m_text + m_starts[i]; }
+    // without the spaces it broke at and its newline
+    uint16_t lineLength(uint16_t i) const;
+
+    private:
+    TFT_eSPI *m_tft;
+    uint8_t m_font, m_textsize;
+    int16_t m_lineHeight;
+    uint8_t m_advance[TEXT_LAYOUT_GLYPHS];
+
+    const char *m_text;
+    uint16_t m_starts[TEXT_LAYOUT_MAX_LINES + 1]; // and where the text ends
+    uint16_t m_lines;
+    bool m_truncated;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "text_layout.h"
+#include "widget.h"
+
+/**
+ * A block of text wrapped to the width of its bounds, scrolled a line at a
+ * time. setText() lays the text out once; painting and scrolling look lines
+ * up in the layout by index and never measure text. Only whole lines are
+ * drawn, the strip under the last one is fill. The text is not copied and
+ * has to stay as it was until the next setText().
+ **/
+class TFT_Text_View : public TFT_Widget
+{
+    private:
+    TextLayout m_layout;
+    uint16_t m_textcolor, m_fillcolor;
+    uint8_t m_font, m_textsize;
+    uint16_t m_first;
+
+    public:
+    TFT_Text_View(void);
+
+    void init(TFT_eSPI *gfx, int16_t x, int16_t y, int16_t w, int16_t h,
+              uint16_t textcolor, uint16_t fill, uint8_t font, uint8_t textsize = 1);
+
+    void setText(const char *text, uint16_t length);
+    void setText(const char *text) { setText(text, strlen(text)); }
+
+    // clamped so the last page is full
+    void scrollTo(uint16_t line);
+    void scrollBy(int16_t lines) { scrollTo(max(0, (int16_t)m_first + lines)); }
+    uint16_t firstLine() const { return m_first; }
+    uint16_t visibleLines() const;
+    uint16_t lines() const { return m_layout.lines(); }
+    const TextLayout &layout() const { return m_layout; }
+
+    void paint(const TFT_Rect &clip) override;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <TFT_eSPI.h>
+
+#define CANVAS_TILE_SIZE 16
+#define CANVAS_BPP 2 // 2 or 4
+#define CANVAS_COLOURS (1 << CANVAS_BPP)
+#define CANVAS_TILE_BYTES (CANVAS_TILE_SIZE * CANVAS_TILE_SIZE * CANVAS_BPP / 8)
+#define CANVAS_MAX_TILES ((480 / CANVAS_TILE_SIZE) * (320 / CANVAS_TILE_SIZE))
+// ink storage for a quarter of the 416x320 drawing area's tiles, 8 KB at
+// 2 bpp; DRAM has to leave the TLS handshake its heap
+#define CANVAS_POOL_TILES ((416 / CANVAS_TILE_SIZE) * (320 / CANVAS_TILE_SIZE) / 4)
+#define CANVAS_POOL_BYTES (CANVAS_POOL_TILES * CANVAS_TILE_BYTES)
+#define CANVAS_NO_TILE 0xFFFF
+
+/**
+ * Drawing surface kept as palette-indexed tiles instead of RGB565 pixels.
+ * Tiles that hold only the background colour (palette index 0) take no
+ * storage; the first stroke through a tile takes one from a fixed pool. The
+ * pool holds 130 of the 520 tiles of the drawing area, a few lines of
+ * handwriting, and the whole canvas stays under 10 KB at 2 bits per pixel.
+ * Once it runs out, ink in tiles it cannot supply goes straight to the panel
+ * given to spillTo(): shown, but gone at the next full repaint.
+ * overflowed() says when that has happened.
+ *
+ * Drawing only marks tiles dirty. flush() sends each dirty tile to the panel
+ * as one address window and one pushColors() burst, so a repaint after
+ * invalidate() is a single pass over the tiles.
+ **/
+class TFT_Tile_Canvas
+{
+    public:
+    TFT_Tile_Canvas(void);
+
+    // w and h must be multiples of CANVAS_TILE_SIZE
+    void init(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t palette[CANVAS_COLOURS]);
+    void clear();
+    void invalidate();
+    // where ink the pool has no room for is drawn instead, nullptr to drop it
+    void spillTo(TFT_eSPI *tft) { m_spill = tft; }
+
+    bool contains(int16_t x, int16_t y);
+    void setPixel(int16_t x, int16_t y, uint8_t index);
+    uint8_t getPixel(int16_t x, int16_t y);
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t index, uint8_t width);
+
+    // sends up to maxTiles dirty tiles, returns how many were sent
+    uint16_t flush(TFT_eSPI *tft, uint16_t maxTiles = 0xFFFF);
+
+    uint16_t tilesUsed() { return m_used; }
+    // a stroke needed a tile after the pool ran out, and was spilled or cut short
+    bool overflowed() { return m_overflow; }
+
+    private:
+    int16_t m_x, m_y;
+    uint8_t m_cols, m_rows;
+    uint16_t m_palette[CANVAS_COLOURS];
+    uint16_t m_map[CANVAS_MAX_TILES];
+    uint8_t m_dirty[(CANVAS_MAX_TILES + 7) / 8];
+    uint8_t m_pool[CANVAS_POOL_TILES][CANVAS_TILE_BYTES];
+    uint16_t m_used;
+    bool m_overflow;
+    TFT_eSPI *m_spill;
+
+    void stamp(int16_t x, int16_t y, uint8_t index, uint8_t width);
+    void markDirty(uint16_t tile) { m_dirty[tile >> 3] |= 1 << (tile & 7); }
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+
+#include "mqtt_connection.h"
+
+// the box's own channel, partners and group channels
+#define TOPIC_ROUTER_MAX_ROUTES 8
+// a power of two, four times the routes so probe runs stay short
+#define TOPIC_ROUTER_SLOTS 32
+#define TOPIC_ROUTER_EMPTY 0xFF
+
+// partner is the id the route was added with, payload and length are as
+// PubSubClient passes them
+typedef void (*TopicHandler)(uint8_t partner, const char *topic, const uint8_t *payload, uint32_t length);
+
+/**
+ * Which handler, and for which partner, each subscribed topic goes to.
+ * Topics are hashed (FNV-1a) into an open-addressed table when they are
+ * added, so dispatch() costs one pass over the incoming topic to hash it,
+ * a probe or two, and one memcmp() to confirm the match, however many
+ * routes there are. Only exact topics can be routed, not '+' or '#'
+ * filters.
+ *
+ * After a reconnect the broker has forgotten the subscriptions (clean
+ * session); subscribeAll() sends them all again in a single pass.
+ **/
+class TopicRouter
+{
+    public:
+    struct Stats
+    {
+        uint32_t routed;
+        uint32_t unrouted;
+        uint32_t probes; // slots looked at past the first
+        uint8_t maxProbes;
+    };
+
+    TopicRouter(void);
+
+    // false when full, for a wildcard or too long a topic, or one already routed
+    bool add(const char *topic, TopicHandler handler, uint8_t partner, uint8_t qos = 0);
+    // the broker is not told, unsubscribe as well while online
+    bool remove(const char *topic);
+    uint8_t routes() const { return m_count; }
+    const char *topic(uint8_t route) const { return m_routes[route].topic; }
+
+    // false at the first subscribe the client refuses
+    bool subscribeAll(PubSubClient &client);
+    // false if nothing is routed to topic
+    bool dispatch(const char *topic, const uint8_t *payload, uint32_t length);
+
+    const Stats &stats() { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+
+    private:
+    struct Route
+    {
+        uint32_t hash;
+        TopicHandler handler;
+        uint8_t length;
+        uint8_t partner;
+        uint8_t qos;
+        char topic[MQTT_TOPIC_LEN];
+    };
+
+    Route m_routes[TOPIC_ROUTER_MAX_ROUTES];
+    uint8_t m_count;
+    // route index per slot
+    uint8_t m_slots[TOPIC_ROUTER_SLOTS];
+    Stats m_stats;
+
+    static uint32_t hash(const char *topic, size_t &length);
+    uint8_t find(const char *topic, uint32_t hash, size_t length, uint8_t *probes);
+    void rebuild();
+};
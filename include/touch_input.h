@@ -0,0 +1,100 @@
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include <atomic>
+
+#ifndef TOUCH_IRQ_PIN
+#define TOUCH_IRQ_PIN D2 // XPT2046 T_IRQ, -1 to poll the controller instead
+#endif
+#define TOUCH_SAMPLE_MS 5
+#define TOUCH_RING_SLOTS 32
+#define TOUCH_RELEASE_SAMPLES 3 // misses in a row before the pen counts as lifted
+#define TOUCH_MOVE_MIN 2        // pixels a held pen has to move to report a Move
+
+struct TouchSample
+{
+    uint32_t us;
+    int16_t x, y;
+    bool down;
+};
+
+struct TouchEvent
+{
+    enum Type : uint8_t
+    {
+        Press,
+        Move,
+        Release
+    };
+
+    Type type;
+    int16_t x, y;
+    uint32_t us;
+};
+
+/**
+ * Touch input sampled apart from the screens. The pen IRQ only flags that the
+ * pen went down and notes when; a scheduler task then calls sample() every
+ * TOUCH_SAMPLE_MS, which reads the controller for as long as the pen stays
+ * down and queues timestamped samples in a single-producer/single-consumer
+ * ring, so the screens see every sample since their last frame and the
+ * shared SPI bus is left alone while nobody touches the screen. Without an
+ * IRQ pin every call reads the controller.
+ *
+ * read() filters the queued samples into Press/Move/Release events: a release
+ * needs TOUCH_RELEASE_SAMPLES misses in a row, which rides out the controller
+ * dropping a sample under light pressure, and moves smaller than
+ * TOUCH_MOVE_MIN are dropped as jitter.
+ *
+ * sample() has to run in loop context: getTouch() debounces the controller
+ * with delay(), which panics from a Ticker or an interrupt, and takes a few
+ * milliseconds doing it.
+ **/
+class TouchInput
+{
+    public:
+    TouchInput(void);
+
+    void begin(TFT_eSPI *tft, int8_t irqPin = TOUCH_IRQ_PIN);
+    void end();
+
+    // producer side, from loop(): read the controller if the pen is, or may
+    // be, down
+    void sample();
+    // producer side: queue one sample, from sample() or a recorded trace
+    bool feed(const TouchSample &sample);
+
+    // consumer side: the next filtered event, false when there is none
+    bool read(TouchEvent &event);
+    bool isDown() { return m_down; }
+    int16_t x() { return m_x; }
+    int16_t y() { return m_y; }
+
+    uint32_t dropped() { return m_dropped; }
+    uint32_t reads() { return m_reads; } // controller reads, idle ones included
+
+    private:
+    TFT_eSPI *m_tft;
+    int8_t m_irqPin;
+    volatile bool m_penIrq;
+    volatile uint32_t m_penIrqUs;
+    uint8_t m_sampling; // misses left before the sampler goes quiet again
+    uint32_t m_reads;
+
+    TouchSample m_ring[TOUCH_RING_SLOTS];
+    std::atomic<uint8_t> m_head; // next slot to write, owned by the producer
+    std::atomic<uint8_t> m_tail; // next slot to read, owned by the consumer
+    uint32_t m_dropped;
+
+    // filter state, consumer side
+    bool m_down;
+    int16_t m_x, m_y;
+    uint8_t m_misses;
+    uint32_t m_liftUs;
+
+    static TouchInput *s_instance;
+    static void IRAM_ATTR onPenIrq();
+
+    bool pop(TouchSample &sample);
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <TFT_eSPI.h>
+
+// damaged rectangles a screen keeps apart, beyond that the closest are merged
+#define WIDGET_MAX_DAMAGE 8
+#define WIDGET_NO_BUDGET 0xFFFFFFFF
+
+struct TFT_Rect
+{
+    int16_t x, y, w, h;
+
+    bool empty() const { return w <= 0 || h <= 0; }
+    uint32_t area() const { return empty() ? 0 : (uint32_t)w * h; }
+    bool contains(int16_t px, int16_t py) const
+    {
+        return px >= x && px < x + w && py >= y && py < y + h;
+    }
+    bool intersects(const TFT_Rect &r) const
+    {
+        return !empty() && !r.empty() && r.x < x + w && x < r.x + r.w && r.y < y + h && y < r.y + r.h;
+    }
+    bool covers(const TFT_Rect &r) const
+    {
+        return r.empty() || (!empty() && r.x >= x && r.y >= y && r.x + r.w <= x + w && r.y + r.h <= y + h);
+    }
+    TFT_Rect intersect(const TFT_Rect &r) const;
+    TFT_Rect unite(const TFT_Rect &r) const;
+};
+
+/**
+ * Base of everything drawn on a screen: bounds on the panel, press state
+ * for touch handling, and a place in a tree of widgets. Children are drawn
+ * after, so on top of, their parent and earlier siblings.
+ *
+ * Widgets never draw when they change. invalidate() asks for the whole
+ * widget to be painted again, changed() for update(), which widgets that
+ * can draw a change in place (a text field, the keyboard) override to do
+ * less than a full paint. The TFT_Screen at the root of the tree does the
+ * drawing, once per frame.
+ **/
+class TFT_Widget
+{
+    friend class TFT_Screen;
+
+    protected:
+    TFT_eSPI *m_tft;
+    TFT_Rect m_bounds;
+    // paint() covers every pixel of its clip, nothing behind needs drawing
+    bool m_opaque;
+
+    public:
+    TFT_Widget(void);
+    virtual ~TFT_Widget() {}
+
+    // a child already in a tree stays where it is
+    void add(TFT_Widget *child);
+    TFT_Widget *parent() { return m_parent; }
+
+    void setBounds(int16_t x, int16_t y, int16_t w, int16_t h);
+    const TFT_Rect &bounds() const { return m_bounds; }
+    bool contains(int16_t x, int16_t y) const { return m_visible && m_bounds.contains(x, y); }
+
+    void setVisible(bool visible);
+    bool isVisible() const { return m_visible; }
+
+    void invalidate() { m_dirty = true; }
+    void changed() { m_changed = true; }
+    bool isDirty() const { return m_dirty || m_changed; }
+
+    // draw the part of the widget inside clip, which lies within bounds()
+    virtual void paint(const TFT_Rect &clip) {}
+    // draw what changed() since the last paint
+    virtual void update() { paint(m_bounds); }
+
+    void press(bool p)
+    {
+        m_laststate = m_currstate;
+        m_currstate = p;
+    }
+    bool isPressed() { return m_currstate; }
+    bool justPressed() { return (m_currstate && !m_laststate); }
+    bool justReleased() { return (!m_currstate && m_laststate); }
+
+    private:
+    TFT_Widget *m_parent, *m_firstChild, *m_next;
+    bool m_visible;
+    bool m_dirty, m_changed;
+    bool m_laststate, m_currstate;
+    // panel area a move or hide left behind, repainted by what is underneath
+    TFT_Rect m_exposed;
+};
+
+/**
+ * Root of a widget tree, covering the panel with a background colour.
+ *
+ * render() first gathers the bounds of every invalidated widget, and the
+ * areas uncovered by moved or hidden ones, into a few damaged rectangles,
+ * merging any that overlap. Every visible widget that intersects one is
+ * painted, clipped to it, back to front; a rectangle that an opaque widget
+ * damaged itself skips the widgets behind it. Widgets that only changed()
+ * are then update()d. Widgets a frame did not reach, once it has used its
+ * budget of microseconds, stay damaged for the next; the first is always
+ * drawn so a frame cannot stall.
+ **/
+class TFT_Screen : public TFT_Widget
+{
+    public:
+    struct Stats
+    {
+        uint32_t frames;   // renders that drew something
+        uint32_t painted;  // paint() calls
+        uint32_t updated;  // update() calls
+        uint32_t merged;   // damaged rectangles merged into another
+        uint32_t deferred; // rectangles and updates left for the next frame
+        uint32_t pixels;   // area of the damaged rectangles drawn
+        uint32_t lastFrameUs;
+        uint32_t maxFrameUs;
+    };
+
+    TFT_Screen(void);
+
+    // the whole panel, painted in full on the next render()
+    void init(TFT_eSPI *gfx, uint16_t background);
+
+    bool pending();
+    // returns how many widgets were drawn
+    uint8_t render(uint32_t budgetUs = WIDGET_NO_BUDGET);
+
+    const Stats &stats() { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+
+    void paint(const TFT_Rect &clip) override;
+
+    private:
+    struct Damage
+    {
+        TFT_Rect rect;
+        // the opaque widget that damaged the rectangle on its own, if any
+        TFT_Widget *cover;
+    };
+
+    uint16_t m_background;
+    Damage m_damage[WIDGET_MAX_DAMAGE];
+    uint8_t m_damageCount;
+    bool m_coverReached;
+    Stats m_stats;
+
+    void collect(TFT_Widget *widget);
+    void addDamage(TFT_Rect rect, TFT_Widget *cover);
+    void removeDamage(uint8_t i);
+    uint8_t paintTree(TFT_Widget *widget, const Damage &damage);
+    bool pendingIn(TFT_Widget *widget);
+    void updateTree(TFT_Widget *widget, uint32_t start, uint32_t budgetUs, uint8_t &drawn);
+};
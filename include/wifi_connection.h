@@ -0,0 +1,57 @@
+#pragma once
+
+#include <ESP8266WiFi.h>
+
+#define WIFI_CONNECT_RETRIES 15
+#define WIFI_RETRY_INTERVAL_MS 1000
+
+/**
+ * Non-blocking Wi-Fi station connect. begin() only starts the association;
+ * tick() is called from loop() and reports progress once per retry interval
+ * and the outcome once, through callbacks, so the UI keeps running and a
+ * connect can be cancelled part way through.
+ **/
+class WifiConnection
+{
+    public:
+    enum State
+    {
+        Idle,
+        Connecting,
+        Connected,
+        Failed,
+        Cancelled
+    };
+
+    typedef void (*ProgressCallback)(const String &ssid, uint8_t retries);
+    typedef void (*ResultCallback)(State state, wl_status_t status);
+
+    WifiConnection(void);
+
+    void onProgress(ProgressCallback callback) { m_onProgress = callback; }
+    void onResult(ResultCallback callback) { m_onResult = callback; }
+
+    void begin(const String &ssid, const String &password);
+    void cancel();
+    void tick();
+
+    State state() { return m_state; }
+    bool isConnecting() { return m_state == Connecting; }
+    uint8_t retries() { return m_retries; }
+
+    // time from power-on to the first successful association, 0 until then
+    uint32_t bootToConnectedMs() { return m_bootToConnectedMs; }
+    // time the last successful begin() took to associate
+    uint32_t lastConnectMs() { return m_lastConnectMs; }
+
+    private:
+    State m_state;
+    String m_ssid;
+    uint8_t m_retries;
+    uint32_t m_beginMs, m_lastRetryMs;
+    uint32_t m_bootToConnectedMs, m_lastConnectMs;
+    ProgressCallback m_onProgress;
+    ResultCallback m_onResult;
+
+    void finish(State state, wl_status_t status);
+};
@@ -0,0 +1,135 @@
+#include "Arduino.h"
+#include "HostSim.h"
+
+#include <chrono>
+#include <random>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static std::mt19937 s_random(0x4D42);
+
+unsigned long millis()
+{
+    return (unsigned long)(HostSim::nowMicros() / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)HostSim::nowMicros();
+}
+
+void delay(unsigned long ms)
+{
+    HostSim::advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    HostSim::advance(us);
+}
+
+void yield()
+{
+    // runs whatever timers are due, as the SDK does on the device
+    HostSim::advance(0);
+}
+
+long random(long howbig)
+{
+    if (howbig <= 0)
+        return 0;
+    return (long)(s_random() % (unsigned long)howbig);
+}
+
+long random(long howsmall, long howbig)
+{
+    if (howsmall >= howbig)
+        return howsmall;
+    return howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+    if (seed)
+        s_random.seed(seed);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    (void)pin;
+    (void)mode;
+}
+
+int digitalRead(uint8_t pin)
+{
+    return HostSim::pinLevel(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    (void)pin;
+    (void)val;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode)
+{
+    HostSim::attachPinInterrupt(pin, isr, mode);
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    HostSim::attachPinInterrupt(pin, nullptr, 0);
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+    HostSim::uartBegin(baud);
+}
+
+int HardwareSerial::availableForWrite()
+{
+    return HostSim::uartAvailable();
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    HostSim::uartWrite(1);
+    if (HostSim::serialEnabled())
+        fputc(c, stdout);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    HostSim::uartWrite(size);
+    if (HostSim::serialEnabled())
+        fwrite(buffer, 1, size, stdout);
+    return size;
+}
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
+
+uint32_t EspClass::getFreeHeap()
+{
+    return HostSim::heapStats().free;
+}
+
+uint8_t EspClass::getHeapFragmentation()
+{
+    return HostSim::heapStats().fragmentation;
+}
+
+uint32_t EspClass::getMaxFreeBlockSize()
+{
+    return HostSim::heapStats().maxBlock;
+}
+
+void EspClass::restart()
+{
+    fflush(stdout);
+    exit(0);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+// Host stand-in for the ESP8266 Arduino core. Time is virtual: delay() advances
+// the clock without sleeping so blocking firmware loops run instantly.
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <algorithm>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+
+using std::max;
+using std::min;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x00
+#define INPUT_PULLUP 0x02
+#define OUTPUT 0x01
+
+#define CHANGE 3
+#define FALLING 2
+#define RISING 1
+
+#define D0 16
+#define D1 5
+#define D2 4
+#define D3 0
+#define D4 2
+#define D5 14
+#define D6 12
+#define D7 13
+#define D8 15
+
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define F(s) ((const __FlashStringHelper *)(s))
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr) (*(void *const *)(addr))
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncpy_P strncpy
+#define vsnprintf_P vsnprintf
+#define snprintf_P snprintf
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+#define digitalPinToInterrupt(p) (p)
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t pin);
+inline void interrupts() {}
+inline void noInterrupts() {}
+
+class HardwareSerial : public Stream
+{
+    public:
+    // from begin() on, writes take the line time of the baud rate, see
+    // HostSim::uartWrite()
+    void begin(unsigned long baud);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    int availableForWrite();
+    void flush() override;
+};
+
+extern HardwareSerial Serial;
+
+class EspClass
+{
+    public:
+    uint32_t getFreeHeap();
+    uint8_t getHeapFragmentation();
+    uint32_t getMaxFreeBlockSize();
+    uint32_t getChipId() { return 0x00C0FFEE; }
+    void restart();
+};
+
+extern EspClass ESP;
+
+void setup();
+void loop();
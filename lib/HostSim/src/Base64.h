@@ -0,0 +1,11 @@
+#pragma once
+
+// Host copy of agdl/Base64 (Adam Rudd), same whole-buffer API and algorithm.
+// Only bench/base64_bench.cpp uses it, as the reference base64_stream.h is
+// measured and checked against; that codec is there for payload paths yet
+// to come, nothing in the firmware calls either.
+
+int base64_encode(char *output, char *input, int inputLen);
+int base64_decode(char *output, char *input, int inputLen);
+int base64_enc_len(int inputLen);
+int base64_dec_len(char *input, int inputLen);
@@ -0,0 +1,70 @@
+#include "ESP8266WiFi.h"
+#include "HostSim.h"
+
+ESP8266WiFiClass WiFi;
+
+// what a BearSSL handshake to the broker costs on the ESP8266 at 80 MHz
+static const unsigned long TLS_HANDSHAKE_MS = 1800;
+
+bool ESP8266WiFiClass::mode(WiFiMode_t m)
+{
+    (void)m;
+    return true;
+}
+
+bool ESP8266WiFiClass::setAutoConnect(bool autoConnect)
+{
+    (void)autoConnect;
+    return true;
+}
+
+bool ESP8266WiFiClass::setAutoReconnect(bool autoReconnect)
+{
+    (void)autoReconnect;
+    return true;
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char *ssid, const char *passphrase)
+{
+    m_ssid = ssid ? ssid : "";
+    m_password = passphrase ? passphrase : "";
+    m_beginMs = millis();
+    m_begun = true;
+    return WL_DISCONNECTED;
+}
+
+wl_status_t ESP8266WiFiClass::begin(const String &ssid, const String &passphrase)
+{
+    return begin(ssid.c_str(), passphrase.c_str());
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifioff)
+{
+    (void)wifioff;
+    m_begun = false;
+    return true;
+}
+
+wl_status_t ESP8266WiFiClass::status()
+{
+    if (!m_begun)
+        return WL_IDLE_STATUS;
+    if (millis() - m_beginMs < HostSim::wifiAssociateMs())
+        return WL_DISCONNECTED;
+    if (HostSim::wifiNetworkMatches(m_ssid.c_str(), m_password.c_str()))
+        return WL_CONNECTED;
+    if (HostSim::wifiNetworkMatches(m_ssid.c_str(), nullptr))
+        return WL_WRONG_PASSWORD;
+    return WL_NO_SSID_AVAIL;
+}
+
+int WiFiClientSecure::connect(const char *host, uint16_t port)
+{
+    (void)host;
+    (void)port;
+    if (WiFi.status() != WL_CONNECTED)
+        return 0;
+    delay(TLS_HANDSHAKE_MS);
+    m_connected = HostSim::brokerAvailable();
+    return m_connected;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+// Host stand-in for the ESP8266 WiFi station and BearSSL client. Association
+// succeeds after HostSim::wifiAssociateMs() when the credentials match the
+// simulated network; a TLS connect costs a simulated handshake time.
+
+#include "Arduino.h"
+
+typedef enum
+{
+    WL_NO_SHIELD = 255,
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_WRONG_PASSWORD = 6,
+    WL_DISCONNECTED = 7
+} wl_status_t;
+
+typedef enum
+{
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} WiFiMode_t;
+
+class ESP8266WiFiClass
+{
+    private:
+    String m_ssid;
+    String m_password;
+    unsigned long m_beginMs = 0;
+    bool m_begun = false;
+
+    public:
+    bool mode(WiFiMode_t m);
+    bool setAutoConnect(bool autoConnect);
+    bool setAutoReconnect(bool autoReconnect);
+    wl_status_t begin(const char *ssid, const char *passphrase = nullptr);
+    wl_status_t begin(const String &ssid, const String &passphrase = emptyString);
+    bool disconnect(bool wifioff = false);
+    wl_status_t status();
+    bool isConnected() { return status() == WL_CONNECTED; }
+    String SSID() const { return m_ssid; }
+    int32_t RSSI() { return isConnected() ? -55 : 31; }
+};
+
+extern ESP8266WiFiClass WiFi;
+
+class X509List
+{
+    public:
+    X509List(const char *pem) { (void)pem; }
+};
+
+class WiFiClientSecure : public Client
+{
+    private:
+    bool m_connected = false;
+
+    public:
+    int connect(const char *host, uint16_t port) override;
+    uint8_t connected() override { return m_connected; }
+    void stop() override { m_connected = false; }
+    size_t write(uint8_t c) override { return m_connected ? 1 : 0; }
+    size_t write(const uint8_t *buf, size_t size) override { return m_connected ? size : 0; }
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int read(uint8_t *buf, size_t size) override { (void)buf; (void)size; return -1; }
+    int peek() override { return -1; }
+
+    void setTrustAnchors(const X509List *ta) { (void)ta; }
+    bool setFingerprint(const char *fpStr) { (void)fpStr; return true; }
+    void allowSelfSignedCerts() {}
+    void setInsecure() {}
+    void setBufferSizes(int recv, int xmit) { (void)recv; (void)xmit; }
+};
+
+typedef WiFiClientSecure BearSSL_WiFiClientSecure;
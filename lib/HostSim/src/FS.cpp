@@ -0,0 +1,194 @@
+#include "FS.h"
+#include "HostSim.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+fs::FS SPIFFS;
+
+namespace fs
+{
+    File::File(FILE *file, const char *name) : m_file(file, fclose), m_name(name)
+    {
+    }
+
+    size_t File::write(uint8_t c)
+    {
+        return write(&c, 1);
+    }
+
+    size_t File::write(const uint8_t *buf, size_t size)
+    {
+        if (!m_file)
+            return 0;
+        return fwrite(buf, 1, size, m_file.get());
+    }
+
+    int File::available()
+    {
+        if (!m_file)
+            return 0;
+        return (int)(size() - position());
+    }
+
+    int File::read()
+    {
+        if (!m_file)
+            return -1;
+        int c = fgetc(m_file.get());
+        return c == EOF ? -1 : c;
+    }
+
+    int File::peek()
+    {
+        if (!m_file)
+            return -1;
+        int c = fgetc(m_file.get());
+        if (c == EOF)
+            return -1;
+        ungetc(c, m_file.get());
+        return c;
+    }
+
+    size_t File::read(uint8_t *buf, size_t size)
+    {
+        if (!m_file)
+            return 0;
+        return fread(buf, 1, size, m_file.get());
+    }
+
+    void File::flush()
+    {
+        if (m_file)
+            fflush(m_file.get());
+    }
+
+    bool File::seek(uint32_t pos, SeekMode mode)
+    {
+        if (!m_file)
+            return false;
+        int whence = mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END);
+        return fseek(m_file.get(), pos, whence) == 0;
+    }
+
+    size_t File::position() const
+    {
+        if (!m_file)
+            return 0;
+        return (size_t)ftell(m_file.get());
+    }
+
+    size_t File::size() const
+    {
+        if (!m_file)
+            return 0;
+        long here = ftell(m_file.get());
+        fseek(m_file.get(), 0, SEEK_END);
+        long end = ftell(m_file.get());
+        fseek(m_file.get(), here, SEEK_SET);
+        return (size_t)end;
+    }
+
+    void File::close()
+    {
+        m_file.reset();
+    }
+
+    String FS::hostPath(const char *path)
+    {
+        String out = HostSim::spiffsDir();
+        if (!path || path[0] != '/')
+            out += '/';
+        out += path;
+        return out;
+    }
+
+    bool FS::begin()
+    {
+        mkdir(HostSim::spiffsDir(), 0755);
+        struct stat st;
+        m_mounted = stat(HostSim::spiffsDir(), &st) == 0 && S_ISDIR(st.st_mode);
+        return m_mounted;
+    }
+
+    bool FS::format()
+    {
+        DIR *dir = opendir(HostSim::spiffsDir());
+        if (!dir)
+            return begin();
+        while (struct dirent *entry = readdir(dir))
+        {
+            if (entry->d_name[0] == '.')
+                continue;
+            ::remove(hostPath(entry->d_name).c_str());
+        }
+        closedir(dir);
+        return true;
+    }
+
+    bool FS::info(FSInfo &info)
+    {
+        info.totalBytes = 1024 * 1024;
+        info.usedBytes = 0;
+        info.blockSize = 8192;
+        info.pageSize = 256;
+        info.maxOpenFiles = 5;
+        info.maxPathLength = 32;
+        return m_mounted;
+    }
+
+    File FS::open(const char *path, const char *mode)
+    {
+        if (!m_mounted)
+            return File();
+        const char *hostMode = "rb";
+        if (mode[0] == 'w')
+            hostMode = mode[1] == '+' ? "w+b" : "wb";
+        else if (mode[0] == 'a')
+            hostMode = mode[1] == '+' ? "a+b" : "ab";
+        else if (mode[1] == '+')
+            hostMode = "r+b";
+        FILE *f = fopen(hostPath(path).c_str(), hostMode);
+        if (!f)
+            return File();
+        return File(f, path);
+    }
+
+    bool FS::exists(const char *path)
+    {
+        struct stat st;
+        return m_mounted && stat(hostPath(path).c_str(), &st) == 0;
+    }
+
+    bool FS::remove(const char *path)
+    {
+        return m_mounted && ::remove(hostPath(path).c_str()) == 0;
+    }
+
+    bool FS::rename(const char *pathFrom, const char *pathTo)
+    {
+        // SPIFFS refuses to rename over an existing file
+        if (!m_mounted || exists(pathTo))
+            return false;
+        return ::rename(hostPath(pathFrom).c_str(), hostPath(pathTo).c_str()) == 0;
+    }
+
+    Dir FS::openDir(const char *path)
+    {
+        std::vector<String> names;
+        DIR *dir = m_mounted ? opendir(HostSim::spiffsDir()) : nullptr;
+        if (!dir)
+            return Dir();
+        size_t prefix = strlen(path);
+        while (struct dirent *entry = readdir(dir))
+        {
+            if (entry->d_name[0] == '.')
+                continue;
+            String name = String("/") + entry->d_name;
+            if (strncmp(name.c_str(), path, prefix) == 0)
+                names.push_back(name);
+        }
+        closedir(dir);
+        return Dir(names);
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+// Host stand-in for the ESP8266 SPIFFS filesystem. Files live flat in the
+// directory named by HostSim::spiffsDir(), one host file per SPIFFS path.
+
+#include <memory>
+#include <vector>
+
+#include "Arduino.h"
+
+namespace fs
+{
+    enum SeekMode
+    {
+        SeekSet = 0,
+        SeekCur = 1,
+        SeekEnd = 2
+    };
+
+    class File : public Stream
+    {
+        private:
+        std::shared_ptr<FILE> m_file;
+        String m_name;
+
+        public:
+        File() {}
+        File(FILE *file, const char *name);
+
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t *buf, size_t size) override;
+        using Print::write;
+        int available() override;
+        int read() override;
+        int peek() override;
+        size_t read(uint8_t *buf, size_t size);
+        using Stream::read;
+        void flush() override;
+
+        bool seek(uint32_t pos, SeekMode mode = SeekSet);
+        size_t position() const;
+        size_t size() const;
+        void close();
+        const char *name() const { return m_name.c_str(); }
+        operator bool() const { return (bool)m_file; }
+    };
+
+    // the files whose path starts with the one openDir() was given, listed
+    // when it was opened
+    class Dir
+    {
+        private:
+        std::vector<String> m_names;
+        size_t m_next = 0;
+
+        public:
+        Dir() {}
+        explicit Dir(const std::vector<String> &names) : m_names(names) {}
+
+        bool next() { return m_next++ < m_names.size(); }
+        String fileName() const { return m_next && m_next <= m_names.size() ? m_names[m_next - 1] : String(); }
+    };
+
+    struct FSInfo
+    {
+        size_t totalBytes;
+        size_t usedBytes;
+        size_t blockSize;
+        size_t pageSize;
+        size_t maxOpenFiles;
+        size_t maxPathLength;
+    };
+
+    class FS
+    {
+        private:
+        bool m_mounted = false;
+        String hostPath(const char *path);
+
+        public:
+        bool begin();
+        void end() { m_mounted = false; }
+        bool format();
+        bool info(FSInfo &info);
+        File open(const char *path, const char *mode);
+        File open(const String &path, const char *mode) { return open(path.c_str(), mode); }
+        bool exists(const char *path);
+        bool exists(const String &path) { return exists(path.c_str()); }
+        bool remove(const char *path);
+        bool remove(const String &path) { return remove(path.c_str()); }
+        bool rename(const char *pathFrom, const char *pathTo);
+        bool rename(const String &pathFrom, const String &pathTo) { return rename(pathFrom.c_str(), pathTo.c_str()); }
+        Dir openDir(const char *path);
+        Dir openDir(const String &path) { return openDir(path.c_str()); }
+    };
+}
+
+using fs::Dir;
+using fs::File;
+using fs::FS;
+using fs::FSInfo;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::SeekSet;
+
+extern fs::FS SPIFFS;
@@ -0,0 +1,151 @@
+#include "HostSim.h"
+
+#include <math.h>
+#include <string.h>
+
+// First-fit heap over a fixed arena, standing in for the ESP8266's umm_malloc
+// so String and PubSubClient allocations fragment the way they do on the
+// device. Every block starts with an 8-byte header; free neighbours are merged.
+namespace HostSim
+{
+    struct BlockHeader
+    {
+        uint32_t size; // including the header
+        uint32_t used;
+    };
+
+    static const uint32_t HEADER = sizeof(BlockHeader);
+    static const uint32_t MIN_SPLIT = HEADER + 8;
+
+    alignas(8) static uint8_t s_arena[HEAP_SIZE];
+    static bool s_heapReady = false;
+
+    static BlockHeader *blockAt(uint32_t offset)
+    {
+        return (BlockHeader *)(s_arena + offset);
+    }
+
+    static void heapInit()
+    {
+        if (s_heapReady)
+            return;
+        blockAt(0)->size = HEAP_SIZE;
+        blockAt(0)->used = 0;
+        s_heapReady = true;
+    }
+
+    static uint32_t blockSize(size_t payload)
+    {
+        return (uint32_t)((payload + HEADER + 7) & ~(size_t)7);
+    }
+
+    static void split(BlockHeader *block, uint32_t size)
+    {
+        if (block->size - size < MIN_SPLIT)
+            return;
+        BlockHeader *rest = (BlockHeader *)((uint8_t *)block + size);
+        rest->size = block->size - size;
+        rest->used = 0;
+        block->size = size;
+    }
+
+    static void coalesce()
+    {
+        uint32_t offset = 0;
+        while (offset < HEAP_SIZE)
+        {
+            BlockHeader *block = blockAt(offset);
+            while (!block->used && offset + block->size < HEAP_SIZE && !blockAt(offset + block->size)->used)
+                block->size += blockAt(offset + block->size)->size;
+            offset += block->size;
+        }
+    }
+
+    bool heapOwns(const void *ptr)
+    {
+        return ptr >= (const void *)s_arena && ptr < (const void *)(s_arena + HEAP_SIZE);
+    }
+
+    void *heapAlloc(size_t size)
+    {
+        heapInit();
+        uint32_t need = blockSize(size);
+        for (uint32_t offset = 0; offset < HEAP_SIZE; offset += blockAt(offset)->size)
+        {
+            BlockHeader *block = blockAt(offset);
+            if (block->used || block->size < need)
+                continue;
+            split(block, need);
+            block->used = 1;
+            return (uint8_t *)block + HEADER;
+        }
+        return nullptr;
+    }
+
+    void heapFree(void *ptr)
+    {
+        if (!ptr)
+            return;
+        BlockHeader *block = (BlockHeader *)((uint8_t *)ptr - HEADER);
+        block->used = 0;
+        coalesce();
+    }
+
+    void *heapRealloc(void *ptr, size_t size)
+    {
+        if (!ptr)
+            return heapAlloc(size);
+        if (size == 0)
+        {
+            heapFree(ptr);
+            return nullptr;
+        }
+
+        BlockHeader *block = (BlockHeader *)((uint8_t *)ptr - HEADER);
+        uint32_t need = blockSize(size);
+        uint32_t offset = (uint32_t)((uint8_t *)block - s_arena);
+
+        // grow into a free neighbour, as umm_realloc does, before moving
+        uint32_t next = offset + block->size;
+        if (need > block->size && next < HEAP_SIZE && !blockAt(next)->used &&
+            block->size + blockAt(next)->size >= need)
+            block->size += blockAt(next)->size;
+
+        if (need <= block->size)
+        {
+            split(block, need);
+            coalesce();
+            return ptr;
+        }
+
+        void *moved = heapAlloc(size);
+        if (!moved)
+            return nullptr;
+        memcpy(moved, ptr, block->size - HEADER);
+        heapFree(ptr);
+        return moved;
+    }
+
+    HeapStats heapStats()
+    {
+        heapInit();
+        HeapStats stats = {};
+        double squares = 0;
+        for (uint32_t offset = 0; offset < HEAP_SIZE; offset += blockAt(offset)->size)
+        {
+            BlockHeader *block = blockAt(offset);
+            if (block->used)
+            {
+                ++stats.usedBlocks;
+                continue;
+            }
+            uint32_t free = block->size - HEADER;
+            stats.free += free;
+            stats.maxBlock = free > stats.maxBlock ? free : stats.maxBlock;
+            squares += (double)free * free;
+        }
+        // same metric as EspClass::getHeapStats() on the device
+        stats.fragmentation = stats.free ? (uint8_t)(100 - (uint32_t)(sqrt(squares) * 100 / stats.free)) : 0;
+        return stats;
+    }
+}
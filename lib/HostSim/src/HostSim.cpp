@@ -0,0 +1,554 @@
+#include "HostSim.h"
+#include "Arduino.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace HostSim
+{
+    static const int32_t FB_WIDTH = 480;
+    static const int32_t FB_HEIGHT = 320;
+
+    static uint16_t s_framebuffer[FB_WIDTH * FB_HEIGHT];
+    static SpiStats s_stats;
+    static bool s_costActive = false;
+    static Cost s_cost = Cost::Pixels;
+
+    static const std::chrono::steady_clock::time_point s_start = std::chrono::steady_clock::now();
+    static uint64_t s_virtualMicros = 0;
+
+    struct Touch
+    {
+        uint32_t atMs;
+        uint32_t durationMs;
+        uint16_t x, y;
+    };
+    static std::vector<Touch> s_touches;
+
+    struct Pin
+    {
+        int level = HIGH;
+        void (*isr)(void) = nullptr;
+        int mode = 0;
+    };
+    static Pin s_pins[17];
+
+    struct Timer
+    {
+        void *owner;
+        uint64_t dueUs;
+        uint32_t periodUs;
+        bool repeat;
+        void (*callback)(void *);
+    };
+    static std::vector<Timer> s_timers;
+
+    static String s_wifiSsid = "MessageBox";
+    static String s_wifiPassword = "password";
+    static uint32_t s_wifiAssociateMs = 3000;
+    static bool s_brokerAvailable = true;
+    static bool s_serial = true;
+    static uint32_t s_uartByteNs = 0; // 0 until begin(), writes are free
+    static uint64_t s_uartIdleNs = 0; // when the FIFO will have emptied
+    static uint64_t s_uartBlockedUs = 0;
+
+    CostScope::CostScope(Cost cost) : m_owner(!s_costActive)
+    {
+        if (m_owner)
+        {
+            s_costActive = true;
+            s_cost = cost;
+            s_stats.byCost[(int)cost].calls++;
+            s_stats.total.calls++;
+        }
+    }
+
+    CostScope::~CostScope()
+    {
+        if (m_owner)
+            s_costActive = false;
+    }
+
+    static void account(uint32_t windows, uint32_t pixels)
+    {
+        Cost cost = s_costActive ? s_cost : Cost::Pixels;
+        SpiCost *targets[2] = {&s_stats.byCost[(int)cost], &s_stats.total};
+        for (SpiCost *c : targets)
+        {
+            if (!s_costActive)
+                c->calls += windows;
+            c->windows += windows;
+            c->pixels += pixels;
+            c->bytes += (uint64_t)windows * ADDR_WINDOW_BYTES + (uint64_t)pixels * HOSTSIM_BYTES_PER_PIXEL;
+        }
+
+        // the bus time passes on the clock, but nothing else runs meanwhile,
+        // as a Ticker cannot interrupt a display transaction on the device
+        static uint64_t bitsPending = 0;
+        bitsPending += ((uint64_t)windows * ADDR_WINDOW_BYTES + (uint64_t)pixels * HOSTSIM_BYTES_PER_PIXEL) * 8 * 1000000ULL;
+        s_virtualMicros += bitsPending / HOSTSIM_SPI_HZ;
+        bitsPending %= HOSTSIM_SPI_HZ;
+    }
+
+    void accountWindow()
+    {
+        account(1, 0);
+    }
+
+    void accountPixels(uint32_t pixels)
+    {
+        account(0, pixels);
+    }
+
+    const SpiStats &stats()
+    {
+        return s_stats;
+    }
+
+    void resetStats()
+    {
+        s_stats = SpiStats();
+    }
+
+    uint32_t spiMicros(const SpiCost &cost)
+    {
+        return (uint32_t)(cost.bytes * 8 * 1000000ULL / HOSTSIM_SPI_HZ);
+    }
+
+    const char *costName(Cost cost)
+    {
+        switch (cost)
+        {
+        case Cost::FillScreen:
+            return "fillScreen";
+        case Cost::FillRect:
+            return "fillRect";
+        case Cost::DrawRect:
+            return "drawRect";
+        case Cost::DrawString:
+            return "drawString";
+        case Cost::DrawButton:
+            return "drawButton";
+        case Cost::Lines:
+            return "lines";
+        case Cost::RoundRect:
+            return "roundRect";
+        case Cost::Pixels:
+            return "pixels";
+        case Cost::PushColors:
+            return "pushColors";
+        default:
+            return "?";
+        }
+    }
+
+    void printStats(Print &out, const char *label, const SpiStats &stats)
+    {
+        out.printf("== %s: %u windows, %llu px, %llu bytes, ~%u us @ %lu Hz\n", label,
+                   stats.total.windows, (unsigned long long)stats.total.pixels,
+                   (unsigned long long)stats.total.bytes, spiMicros(stats.total), (unsigned long)HOSTSIM_SPI_HZ);
+        for (int i = 0; i < (int)Cost::Count; ++i)
+        {
+            const SpiCost &c = stats.byCost[i];
+            if (!c.calls)
+                continue;
+            out.printf("   %-11s %6u calls %7u windows %9llu px %10llu bytes %8u us\n", costName((Cost)i),
+                       c.calls, c.windows, (unsigned long long)c.pixels, (unsigned long long)c.bytes, spiMicros(c));
+        }
+    }
+
+    uint16_t pixel(int32_t x, int32_t y)
+    {
+        if (x < 0 || y < 0 || x >= FB_WIDTH || y >= FB_HEIGHT)
+            return 0;
+        return s_framebuffer[y * FB_WIDTH + x];
+    }
+
+    void setPixel(int32_t x, int32_t y, uint16_t color)
+    {
+        if (x < 0 || y < 0 || x >= FB_WIDTH || y >= FB_HEIGHT)
+            return;
+        s_framebuffer[y * FB_WIDTH + x] = color;
+    }
+
+    uint32_t framebufferHash()
+    {
+        // FNV-1a over the whole panel
+        uint32_t hash = 2166136261u;
+        for (int32_t i = 0; i < FB_WIDTH * FB_HEIGHT; ++i)
+        {
+            hash = (hash ^ (s_framebuffer[i] & 0xFF)) * 16777619u;
+            hash = (hash ^ (s_framebuffer[i] >> 8)) * 16777619u;
+        }
+        return hash;
+    }
+
+    bool dumpFramebuffer(const char *path)
+    {
+        FILE *f = fopen(path, "wb");
+        if (!f)
+            return false;
+        fprintf(f, "P6\n%d %d\n255\n", (int)FB_WIDTH, (int)FB_HEIGHT);
+        for (int32_t i = 0; i < FB_WIDTH * FB_HEIGHT; ++i)
+        {
+            uint16_t c = s_framebuffer[i];
+            uint8_t rgb[3] = {(uint8_t)((c >> 8) & 0xF8), (uint8_t)((c >> 3) & 0xFC), (uint8_t)((c << 3) & 0xF8)};
+            fwrite(rgb, 1, 3, f);
+        }
+        fclose(f);
+        return true;
+    }
+
+    uint64_t nowMicros()
+    {
+        auto real = std::chrono::steady_clock::now() - s_start;
+        return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(real).count() + s_virtualMicros;
+    }
+
+    static void updateTouchPin(uint64_t now)
+    {
+        uint16_t x, y;
+        setPinLevel(PEN_IRQ_PIN, touchAt((uint32_t)(now / 1000), &x, &y) ? LOW : HIGH);
+    }
+
+    // set while a Ticker callback runs, SYS context on the device
+    static bool s_inTimer = false;
+
+    static void runTimers(uint64_t now)
+    {
+        // a callback that yields does not run timers again
+        if (s_inTimer)
+            return;
+        s_inTimer = true;
+        // callbacks may add or remove timers, so index rather than iterate
+        for (size_t i = 0; i < s_timers.size(); ++i)
+        {
+            if (s_timers[i].dueUs > now)
+                continue;
+            Timer timer = s_timers[i];
+            if (timer.repeat)
+                s_timers[i].dueUs = now + timer.periodUs;
+            else
+                s_timers.erase(s_timers.begin() + i--);
+            timer.callback(timer.owner);
+        }
+        s_inTimer = false;
+    }
+
+    // the next touch edge or timer after now
+    static uint64_t nextEvent(uint64_t now)
+    {
+        uint64_t next = UINT64_MAX;
+        for (const Touch &t : s_touches)
+        {
+            uint64_t edges[2] = {(uint64_t)t.atMs * 1000, ((uint64_t)t.atMs + t.durationMs) * 1000};
+            for (uint64_t edge : edges)
+            {
+                if (edge > now && edge < next)
+                    next = edge;
+            }
+        }
+        for (const Timer &timer : s_timers)
+            next = std::min(next, std::max(timer.dueUs, now));
+        return next;
+    }
+
+    void advance(uint64_t us)
+    {
+        // the SDK panics on delay() from SYS context, so should this
+        if (s_inTimer && us)
+        {
+            fprintf(stderr, "HostSim: delay() inside a Ticker callback\n");
+            abort();
+        }
+        // step through every touch edge and timer on the way, so a delay()
+        // lets the pen IRQ and periodic samplers run where they would
+        uint64_t target = nowMicros() + us;
+        for (;;)
+        {
+            uint64_t now = nowMicros();
+            updateTouchPin(now);
+            runTimers(now);
+            uint64_t next = nextEvent(nowMicros());
+            if (next > target)
+                break;
+            now = nowMicros();
+            // a timer that is already due still has to let time move on
+            s_virtualMicros += next > now ? next - now : 1;
+        }
+        uint64_t now = nowMicros();
+        if (target > now)
+            s_virtualMicros += target - now;
+        updateTouchPin(nowMicros());
+    }
+
+    void addTimer(void *owner, uint32_t periodUs, bool repeat, void (*callback)(void *))
+    {
+        removeTimer(owner);
+        s_timers.push_back({owner, nowMicros() + periodUs, periodUs, repeat, callback});
+    }
+
+    void removeTimer(void *owner)
+    {
+        for (size_t i = 0; i < s_timers.size(); ++i)
+        {
+            if (s_timers[i].owner == owner)
+                s_timers.erase(s_timers.begin() + i--);
+        }
+    }
+
+    void addTouch(uint32_t atMs, uint16_t x, uint16_t y, uint32_t durationMs)
+    {
+        s_touches.push_back({atMs, durationMs, x, y});
+    }
+
+    void clearTouches()
+    {
+        s_touches.clear();
+    }
+
+    bool touchAt(uint32_t ms, uint16_t *x, uint16_t *y)
+    {
+        for (const Touch &t : s_touches)
+        {
+            if (ms >= t.atMs && ms < t.atMs + t.durationMs)
+            {
+                *x = t.x;
+                *y = t.y;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int pinLevel(uint8_t pin)
+    {
+        return pin < 17 ? s_pins[pin].level : LOW;
+    }
+
+    void setPinLevel(uint8_t pin, int level)
+    {
+        if (pin >= 17 || s_pins[pin].level == level)
+            return;
+        Pin &p = s_pins[pin];
+        bool falling = p.level == HIGH && level == LOW;
+        p.level = level;
+        if (p.isr && (p.mode == CHANGE || (p.mode == FALLING && falling) || (p.mode == RISING && !falling)))
+            p.isr();
+    }
+
+    void attachPinInterrupt(uint8_t pin, void (*isr)(void), int mode)
+    {
+        if (pin >= 17)
+            return;
+        s_pins[pin].isr = isr;
+        s_pins[pin].mode = mode;
+    }
+
+    void setWifiNetwork(const char *ssid, const char *password, uint32_t associateMs)
+    {
+        s_wifiSsid = ssid;
+        s_wifiPassword = password;
+        s_wifiAssociateMs = associateMs;
+    }
+
+    bool wifiNetworkMatches(const char *ssid, const char *password)
+    {
+        // a null password only checks that the network is in range
+        return s_wifiSsid == ssid && (!password || s_wifiPassword == password);
+    }
+
+    uint32_t wifiAssociateMs()
+    {
+        return s_wifiAssociateMs;
+    }
+
+    void setBrokerAvailable(bool available)
+    {
+        s_brokerAvailable = available;
+    }
+
+    bool brokerAvailable()
+    {
+        return s_brokerAvailable;
+    }
+
+    const char *spiffsDir()
+    {
+        const char *dir = getenv("HOSTSIM_SPIFFS");
+        return dir ? dir : ".hostsim_spiffs";
+    }
+
+    void uartBegin(uint32_t baud)
+    {
+        s_uartByteNs = baud ? (uint32_t)(10 * 1000000000ULL / baud) : 0;
+        s_uartIdleNs = 0;
+    }
+
+    static uint32_t uartQueued(uint64_t nowNs)
+    {
+        if (!s_uartByteNs || s_uartIdleNs <= nowNs)
+            return 0;
+        return (uint32_t)((s_uartIdleNs - nowNs + s_uartByteNs - 1) / s_uartByteNs);
+    }
+
+    uint32_t uartAvailable()
+    {
+        uint32_t queued = uartQueued(nowMicros() * 1000);
+        return queued < UART_FIFO_BYTES ? UART_FIFO_BYTES - queued : 0;
+    }
+
+    void uartWrite(size_t bytes)
+    {
+        if (!s_uartByteNs)
+            return;
+        for (size_t i = 0; i < bytes; ++i)
+        {
+            uint64_t now = nowMicros() * 1000;
+            if (uartQueued(now) >= UART_FIFO_BYTES)
+            {
+                // room for one more once the oldest byte is out
+                uint64_t room = s_uartIdleNs - (uint64_t)(UART_FIFO_BYTES - 1) * s_uartByteNs;
+                uint64_t waitUs = (room - now + 999) / 1000;
+                s_virtualMicros += waitUs;
+                s_uartBlockedUs += waitUs;
+                now = nowMicros() * 1000;
+            }
+            s_uartIdleNs = std::max(s_uartIdleNs, now) + s_uartByteNs;
+        }
+    }
+
+    uint64_t uartBlockedMicros()
+    {
+        return s_uartBlockedUs;
+    }
+
+    bool serialEnabled()
+    {
+        return s_serial;
+    }
+
+    void setSerialEnabled(bool enabled)
+    {
+        s_serial = enabled;
+    }
+}
+
+#ifndef HOSTSIM_NO_MAIN
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [--ms N] [--touch x,y,atMs,durMs]... [--wifi ssid:password[:associateMs]]\n"
+            "          [--no-broker] [--dump file.ppm] [--trace] [--quiet]\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t runMs = 3000;
+    const char *dumpPath = nullptr;
+    bool trace = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--ms") && i + 1 < argc)
+        {
+            runMs = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--touch") && i + 1 < argc)
+        {
+            unsigned x, y, at, dur;
+            if (sscanf(argv[++i], "%u,%u,%u,%u", &x, &y, &at, &dur) != 4)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            HostSim::addTouch(at, x, y, dur);
+        }
+        else if (!strcmp(argv[i], "--wifi") && i + 1 < argc)
+        {
+            char ssid[33] = "", password[65] = "";
+            unsigned associateMs = 3000;
+            sscanf(argv[++i], "%32[^:]:%64[^:]:%u", ssid, password, &associateMs);
+            HostSim::setWifiNetwork(ssid, password, associateMs);
+        }
+        else if (!strcmp(argv[i], "--no-broker"))
+        {
+            HostSim::setBrokerAvailable(false);
+        }
+        else if (!strcmp(argv[i], "--dump") && i + 1 < argc)
+        {
+            dumpPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--trace"))
+        {
+            trace = true;
+        }
+        else if (!strcmp(argv[i], "--quiet"))
+        {
+            HostSim::setSerialEnabled(false);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    setup();
+    HostSim::SpiStats total = HostSim::stats();
+    bool serial = HostSim::serialEnabled();
+    HostSim::setSerialEnabled(true);
+    HostSim::printStats(Serial, "setup()", total);
+    HostSim::setSerialEnabled(serial);
+
+    unsigned long iteration = 0;
+    while (millis() < runMs)
+    {
+        HostSim::resetStats();
+        unsigned long before = micros();
+        loop();
+        // a loop() that never waits still costs the MCU some time
+        if (micros() - before < 1000)
+            HostSim::advance(1000);
+        ++iteration;
+
+        const HostSim::SpiStats &frame = HostSim::stats();
+        for (int c = 0; c < (int)HostSim::Cost::Count; ++c)
+        {
+            total.byCost[c].calls += frame.byCost[c].calls;
+            total.byCost[c].windows += frame.byCost[c].windows;
+            total.byCost[c].pixels += frame.byCost[c].pixels;
+            total.byCost[c].bytes += frame.byCost[c].bytes;
+        }
+        total.total.calls += frame.total.calls;
+        total.total.windows += frame.total.windows;
+        total.total.pixels += frame.total.pixels;
+        total.total.bytes += frame.total.bytes;
+
+        if (trace && frame.total.windows)
+        {
+            char label[48];
+            snprintf(label, sizeof(label), "loop() #%lu at %lu ms", iteration, millis());
+            HostSim::setSerialEnabled(true);
+            HostSim::printStats(Serial, label, frame);
+            HostSim::setSerialEnabled(serial);
+        }
+    }
+
+    HostSim::setSerialEnabled(true);
+    char label[64];
+    snprintf(label, sizeof(label), "total over %lu loop() calls", iteration);
+    HostSim::printStats(Serial, label, total);
+    Serial.printf("framebuffer hash %08x\n", HostSim::framebufferHash());
+    if (dumpPath && !HostSim::dumpFramebuffer(dumpPath))
+        fprintf(stderr, "could not write %s\n", dumpPath);
+    Serial.flush();
+    return 0;
+}
+
+#endif // ifndef HOSTSIM_NO_MAIN
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "Print.h"
+
+// Control and measurement API for the host build. Firmware code never calls
+// into this; host tools and the bundled main() use it to script input and read
+// back what the firmware cost in SPI traffic.
+namespace HostSim
+{
+    // Bytes the panel needs per pixel over SPI. The ILI9488 only takes 18-bit
+    // colour on SPI, so every RGB565 pixel is expanded to three bytes.
+#ifndef HOSTSIM_BYTES_PER_PIXEL
+#define HOSTSIM_BYTES_PER_PIXEL 3
+#endif
+#ifndef HOSTSIM_SPI_HZ
+#define HOSTSIM_SPI_HZ 26670000UL
+#endif
+    // CASET + 4 bytes, PASET + 4 bytes, RAMWR
+    const uint32_t ADDR_WINDOW_BYTES = 11;
+
+    enum class Cost : uint8_t
+    {
+        FillScreen,
+        FillRect,
+        DrawRect,
+        DrawString,
+        DrawButton,
+        Lines,
+        RoundRect,
+        Pixels,
+        PushColors,
+        Count
+    };
+
+    struct SpiCost
+    {
+        uint32_t calls;
+        uint32_t windows;
+        uint64_t pixels;
+        uint64_t bytes;
+    };
+
+    struct SpiStats
+    {
+        SpiCost byCost[(int)Cost::Count];
+        SpiCost total;
+    };
+
+    // Attributes all panel traffic issued while it is alive to one primitive.
+    // Nested scopes keep the outermost attribution, so the rounded rectangles
+    // and text of a button are charged to drawButton.
+    class CostScope
+    {
+        private:
+        bool m_owner;
+
+        public:
+        explicit CostScope(Cost cost);
+        ~CostScope();
+    };
+
+    void accountWindow();
+    void accountPixels(uint32_t pixels);
+    const SpiStats &stats();
+    void resetStats();
+    uint32_t spiMicros(const SpiCost &cost);
+    const char *costName(Cost cost);
+    void printStats(Print &out, const char *label, const SpiStats &stats);
+
+    uint16_t pixel(int32_t x, int32_t y);
+    void setPixel(int32_t x, int32_t y, uint16_t color);
+    uint32_t framebufferHash();
+    bool dumpFramebuffer(const char *path);
+
+    uint64_t nowMicros();
+    void advance(uint64_t us);
+
+    // Scripted touches. While one is held the panel also pulls PEN_IRQ_PIN
+    // low, as the XPT2046's PENIRQ output does.
+    const uint8_t PEN_IRQ_PIN = 4; // D2
+    void addTouch(uint32_t atMs, uint16_t x, uint16_t y, uint32_t durationMs);
+    void clearTouches();
+    bool touchAt(uint32_t ms, uint16_t *x, uint16_t *y);
+
+    // One-shot and periodic callbacks behind the Ticker stand-in. They run as
+    // virtual time passes in delay() and yield(), like os_timer callbacks do
+    // between loop() iterations on the device.
+    void addTimer(void *owner, uint32_t periodUs, bool repeat, void (*callback)(void *));
+    void removeTimer(void *owner);
+
+    int pinLevel(uint8_t pin);
+    void setPinLevel(uint8_t pin, int level);
+    void attachPinInterrupt(uint8_t pin, void (*isr)(void), int mode);
+
+    void setWifiNetwork(const char *ssid, const char *password, uint32_t associateMs);
+    bool wifiNetworkMatches(const char *ssid, const char *password);
+    uint32_t wifiAssociateMs();
+
+    void setBrokerAvailable(bool available);
+    bool brokerAvailable();
+
+    struct MqttMessage
+    {
+        String topic;
+        std::vector<uint8_t> payload;
+    };
+
+    // queue a message the broker will deliver to matching subscriptions
+    void brokerInject(const char *topic, const uint8_t *payload, size_t length);
+    // drop the current client connection, as a broker restart would
+    void brokerDrop();
+    // the next count subscribes fail on the wire with the session still up
+    void brokerFailSubscribes(uint32_t count);
+    const std::vector<MqttMessage> &brokerPublished();
+    void brokerClearPublished();
+
+    const char *spiffsDir();
+
+    // Simulated device heap. String and PubSubClient allocate from here so
+    // ESP.getFreeHeap()/getHeapFragmentation() report what the firmware did.
+    static const uint32_t HEAP_SIZE = 40 * 1024;
+
+    struct HeapStats
+    {
+        uint32_t free;
+        uint32_t maxBlock;
+        uint32_t usedBlocks;
+        uint8_t fragmentation;
+    };
+
+    void *heapAlloc(size_t size);
+    void *heapRealloc(void *ptr, size_t size);
+    void heapFree(void *ptr);
+    bool heapOwns(const void *ptr);
+    HeapStats heapStats();
+
+    // Serial as the ESP8266 UART drives it: a 128 byte transmit FIFO that
+    // empties at the baud rate, 10 bits a byte. A write into a full FIFO
+    // busy-waits for room, with the clock running and nothing else, which is
+    // what a burst of Serial.print() costs the loop on the device.
+    const uint32_t UART_FIFO_BYTES = 128;
+    void uartBegin(uint32_t baud);
+    uint32_t uartAvailable();
+    void uartWrite(size_t bytes);
+    // time writes have spent waiting for the FIFO
+    uint64_t uartBlockedMicros();
+
+    bool serialEnabled();
+    void setSerialEnabled(bool enabled);
+}
@@ -0,0 +1,316 @@
+#include "PubSubClient.h"
+#include "HostSim.h"
+
+#include <deque>
+#include <set>
+#include <string>
+
+namespace HostSim
+{
+    static std::deque<MqttMessage> s_pending;
+    static std::vector<MqttMessage> s_published;
+    static std::set<std::string> s_subscriptions;
+    static uint32_t s_brokerEpoch = 0;
+    static uint32_t s_failSubscribes = 0;
+
+    void brokerInject(const char *topic, const uint8_t *payload, size_t length)
+    {
+        MqttMessage m;
+        m.topic = topic;
+        m.payload.assign(payload, payload + length);
+        s_pending.push_back(m);
+    }
+
+    void brokerDrop()
+    {
+        s_brokerEpoch++;
+    }
+
+    void brokerFailSubscribes(uint32_t count)
+    {
+        s_failSubscribes = count;
+    }
+
+    const std::vector<MqttMessage> &brokerPublished()
+    {
+        return s_published;
+    }
+
+    void brokerClearPublished()
+    {
+        s_published.clear();
+    }
+
+    static bool subscribed(const std::string &topic)
+    {
+        for (const std::string &filter : s_subscriptions)
+        {
+            if (filter == topic)
+                return true;
+            if (!filter.empty() && filter.back() == '#' &&
+                topic.compare(0, filter.size() - 1, filter, 0, filter.size() - 1) == 0)
+                return true;
+        }
+        return false;
+    }
+}
+
+static uint32_t s_connectedEpoch = 0;
+
+PubSubClient::PubSubClient() : _client(nullptr),
+    stream(nullptr),
+    callback(nullptr),
+    buffer(nullptr),
+    bufferSize(0),
+    keepAlive(MQTT_KEEPALIVE),
+    socketTimeout(MQTT_SOCKET_TIMEOUT),
+    _state(MQTT_DISCONNECTED)
+{
+    setBufferSize(MQTT_MAX_PACKET_SIZE);
+}
+
+PubSubClient::~PubSubClient()
+{
+    HostSim::heapFree(buffer);
+}
+
+PubSubClient::PubSubClient(Client &client) : PubSubClient()
+{
+    setClient(client);
+}
+
+PubSubClient::PubSubClient(Client &client, Stream &stream) : PubSubClient()
+{
+    setClient(client);
+    setStream(stream);
+}
+
+PubSubClient &PubSubClient::setServer(const char *domain, uint16_t port)
+{
+    (void)domain;
+    (void)port;
+    return *this;
+}
+
+PubSubClient &PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE)
+{
+    this->callback = callback;
+    return *this;
+}
+
+PubSubClient &PubSubClient::setClient(Client &client)
+{
+    _client = &client;
+    return *this;
+}
+
+PubSubClient &PubSubClient::setStream(Stream &stream)
+{
+    this->stream = &stream;
+    return *this;
+}
+
+PubSubClient &PubSubClient::setKeepAlive(uint16_t keepAlive)
+{
+    this->keepAlive = keepAlive;
+    return *this;
+}
+
+PubSubClient &PubSubClient::setSocketTimeout(uint16_t timeout)
+{
+    socketTimeout = timeout;
+    return *this;
+}
+
+bool PubSubClient::setBufferSize(uint16_t size)
+{
+    if (size == 0)
+        return false;
+    // the real client keeps one heap block of this size for its lifetime
+    uint8_t *newBuffer = (uint8_t *)HostSim::heapRealloc(buffer, size);
+    if (!newBuffer)
+        return false;
+    buffer = newBuffer;
+    bufferSize = size;
+    return true;
+}
+
+bool PubSubClient::connect(const char *id)
+{
+    return connect(id, nullptr, nullptr);
+}
+
+bool PubSubClient::connect(const char *id, const char *user, const char *pass)
+{
+    (void)user;
+    (void)pass;
+    // PubSubClient 2.8 keeps a session that is already up, subscriptions and all
+    if (connected())
+        return true;
+    if (!_client || !_client->connect("broker", 8883))
+    {
+        _state = MQTT_CONNECT_FAILED;
+        return false;
+    }
+    m_clientId = id;
+    HostSim::s_subscriptions.clear();
+    s_connectedEpoch = HostSim::s_brokerEpoch;
+    _state = MQTT_CONNECTED;
+    return true;
+}
+
+void PubSubClient::disconnect()
+{
+    if (_client)
+        _client->stop();
+    _state = MQTT_DISCONNECTED;
+}
+
+bool PubSubClient::connected()
+{
+    if (_state != MQTT_CONNECTED)
+        return false;
+    if (!_client || !_client->connected() || s_connectedEpoch != HostSim::s_brokerEpoch ||
+        !HostSim::brokerAvailable())
+    {
+        if (_client)
+            _client->stop();
+        _state = MQTT_CONNECTION_LOST;
+        return false;
+    }
+    return true;
+}
+
+bool PubSubClient::publish(const char *topic, const char *payload)
+{
+    return publish(topic, (const uint8_t *)payload, payload ? strlen(payload) : 0, false);
+}
+
+bool PubSubClient::publish(const char *topic, const char *payload, bool retained)
+{
+    return publish(topic, (const uint8_t *)payload, payload ? strlen(payload) : 0, retained);
+}
+
+bool PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int plength)
+{
+    return publish(topic, payload, plength, false);
+}
+
+bool PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int plength, bool retained)
+{
+    (void)retained;
+    // fixed header (up to 5 bytes), topic length and topic must fit the buffer
+    if (!connected() || 5 + 2 + strlen(topic) + plength > bufferSize)
+        return false;
+    HostSim::MqttMessage m;
+    m.topic = topic;
+    m.payload.assign(payload, payload + plength);
+    HostSim::s_published.push_back(m);
+    return true;
+}
+
+bool PubSubClient::beginPublish(const char *topic, unsigned int plength, bool retained)
+{
+    (void)plength;
+    (void)retained;
+    if (!connected())
+        return false;
+    m_publishTopic = topic;
+    m_publishPayload = "";
+    return true;
+}
+
+size_t PubSubClient::write(uint8_t c)
+{
+    m_publishPayload += (char)c;
+    return 1;
+}
+
+size_t PubSubClient::write(const uint8_t *buffer, size_t size)
+{
+    m_publishPayload.concat((const char *)buffer, size);
+    return size;
+}
+
+int PubSubClient::endPublish()
+{
+    if (!connected())
+        return 0;
+    HostSim::MqttMessage m;
+    m.topic = m_publishTopic;
+    m.payload.assign(m_publishPayload.c_str(), m_publishPayload.c_str() + m_publishPayload.length());
+    HostSim::s_published.push_back(m);
+    return 1;
+}
+
+bool PubSubClient::subscribe(const char *topic)
+{
+    return subscribe(topic, 0);
+}
+
+bool PubSubClient::subscribe(const char *topic, uint8_t qos)
+{
+    if (qos > 1 || bufferSize < 9 + strlen(topic) || !connected())
+        return false;
+    if (HostSim::s_failSubscribes)
+    {
+        --HostSim::s_failSubscribes;
+        return false;
+    }
+    HostSim::s_subscriptions.insert(topic);
+    return true;
+}
+
+bool PubSubClient::unsubscribe(const char *topic)
+{
+    if (!connected())
+        return false;
+    HostSim::s_subscriptions.erase(topic);
+    return true;
+}
+
+bool PubSubClient::loop()
+{
+    if (!connected())
+        return false;
+
+    // one inbound packet per call, like the real client
+    while (!HostSim::s_pending.empty())
+    {
+        HostSim::MqttMessage m = HostSim::s_pending.front();
+        HostSim::s_pending.pop_front();
+        std::string topic = m.topic.c_str();
+        if (!HostSim::subscribed(topic))
+            continue;
+
+        size_t remaining = 2 + topic.size() + m.payload.size();
+        size_t lengthBytes = remaining < 128 ? 1 : (remaining < 16384 ? 2 : 3);
+        size_t packet = 1 + lengthBytes + remaining;
+        if (stream)
+        {
+            for (uint8_t b : m.payload)
+                stream->write(b);
+        }
+        else if (packet > bufferSize)
+        {
+            // too big for the buffer: the real client silently drops it
+            break;
+        }
+
+        if (callback)
+        {
+            // only what fitted in the buffer is payload, and the length
+            // says so, as the real client's does
+            size_t header = 1 + lengthBytes + 2 + topic.size();
+            size_t fits = bufferSize > header ? bufferSize - header : 0;
+            size_t length = std::min(fits, m.payload.size());
+            std::vector<uint8_t> buffer(length + 1, 0);
+            memcpy(buffer.data(), m.payload.data(), length);
+            std::vector<char> topicBuf(topic.begin(), topic.end());
+            topicBuf.push_back(0);
+            callback(topicBuf.data(), buffer.data(), (unsigned int)length);
+        }
+        break;
+    }
+    return true;
+}
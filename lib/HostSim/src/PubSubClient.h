@@ -0,0 +1,79 @@
+#pragma once
+
+// Host stand-in for knolleary/PubSubClient talking to an in-process broker.
+// connect() goes through the network client so the TLS handshake cost is
+// paid; messages injected with HostSim::brokerInject() are delivered from
+// loop() with the same buffer-size and stream rules as the real library.
+
+#include <functional>
+
+#include "Arduino.h"
+
+#define MQTT_VERSION_3_1_1 4
+#define MQTT_KEEPALIVE 15
+#define MQTT_SOCKET_TIMEOUT 15
+#define MQTT_MAX_PACKET_SIZE 256
+
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+#define MQTT_CONNECTED 0
+#define MQTT_CONNECT_BAD_PROTOCOL 1
+#define MQTT_CONNECT_BAD_CLIENT_ID 2
+#define MQTT_CONNECT_UNAVAILABLE 3
+#define MQTT_CONNECT_BAD_CREDENTIALS 4
+#define MQTT_CONNECT_UNAUTHORIZED 5
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char *, uint8_t *, unsigned int)> callback
+
+class PubSubClient : public Print
+{
+    private:
+    Client *_client;
+    Stream *stream;
+    MQTT_CALLBACK_SIGNATURE;
+    uint8_t *buffer;
+    uint16_t bufferSize;
+    uint16_t keepAlive;
+    uint16_t socketTimeout;
+    int _state;
+    String m_clientId;
+    String m_publishTopic;
+    String m_publishPayload;
+
+    public:
+    PubSubClient();
+    PubSubClient(Client &client);
+    PubSubClient(Client &client, Stream &stream);
+    ~PubSubClient();
+
+    PubSubClient &setServer(const char *domain, uint16_t port);
+    PubSubClient &setCallback(MQTT_CALLBACK_SIGNATURE);
+    PubSubClient &setClient(Client &client);
+    PubSubClient &setStream(Stream &stream);
+    PubSubClient &setKeepAlive(uint16_t keepAlive);
+    PubSubClient &setSocketTimeout(uint16_t timeout);
+
+    bool setBufferSize(uint16_t size);
+    uint16_t getBufferSize() { return bufferSize; }
+
+    bool connect(const char *id);
+    bool connect(const char *id, const char *user, const char *pass);
+    void disconnect();
+    bool publish(const char *topic, const char *payload);
+    bool publish(const char *topic, const char *payload, bool retained);
+    bool publish(const char *topic, const uint8_t *payload, unsigned int plength);
+    bool publish(const char *topic, const uint8_t *payload, unsigned int plength, bool retained);
+    bool beginPublish(const char *topic, unsigned int plength, bool retained);
+    int endPublish();
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    bool subscribe(const char *topic);
+    bool subscribe(const char *topic, uint8_t qos);
+    bool unsubscribe(const char *topic);
+    bool loop();
+    bool connected();
+    int state() { return _state; }
+};
@@ -0,0 +1,3 @@
+#pragma once
+
+// The host build has no SPI bus; TFT_eSPI accounts for its traffic itself.
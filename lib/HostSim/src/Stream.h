@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Print.h"
+
+class Stream : public Print
+{
+    protected:
+    unsigned long m_timeout = 1000;
+
+    public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { m_timeout = timeout; }
+
+    size_t readBytes(char *buffer, size_t length)
+    {
+        size_t count = 0;
+        while (count < length)
+        {
+            int c = read();
+            if (c < 0)
+                break;
+            buffer[count++] = (char)c;
+        }
+        return count;
+    }
+    size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+
+    String readStringUntil(char terminator)
+    {
+        String ret;
+        int c = read();
+        while (c >= 0 && c != terminator)
+        {
+            ret += (char)c;
+            c = read();
+        }
+        return ret;
+    }
+
+    String readString()
+    {
+        String ret;
+        int c = read();
+        while (c >= 0)
+        {
+            ret += (char)c;
+            c = read();
+        }
+        return ret;
+    }
+};
+
+class Client : public Stream
+{
+    public:
+    virtual int connect(const char *host, uint16_t port) = 0;
+    virtual uint8_t connected() = 0;
+    virtual void stop() = 0;
+    virtual int read(uint8_t *buf, size_t size) = 0;
+    using Stream::read;
+    virtual operator bool() { return connected(); }
+};
@@ -0,0 +1,873 @@
+#include "TFT_eSPI.h"
+#include "HostSim.h"
+
+using HostSim::Cost;
+using HostSim::CostScope;
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h) : _width(w),
+    _height(h),
+    m_winX(0),
+    m_winY(0),
+    m_winW(0),
+    m_winH(0),
+    m_winPos(0),
+    m_touchCal{0, 0, 0, 0, 0},
+    cursor_x(0),
+    cursor_y(0),
+    textcolor(TFT_WHITE),
+    textbgcolor(TFT_BLACK),
+    textfont(1),
+    textsize(1),
+    textdatum(TL_DATUM),
+    rotation(0),
+    padX(0)
+{
+}
+
+void TFT_eSPI::init(uint8_t tc)
+{
+    (void)tc;
+    setRotation(rotation);
+}
+
+void TFT_eSPI::setRotation(uint8_t r)
+{
+    rotation = r & 3;
+    if (rotation & 1)
+    {
+        _width = TFT_HEIGHT;
+        _height = TFT_WIDTH;
+    }
+    else
+    {
+        _width = TFT_WIDTH;
+        _height = TFT_HEIGHT;
+    }
+}
+
+void TFT_eSPI::storePixel(int32_t x, int32_t y, uint16_t color)
+{
+    HostSim::setPixel(x, y, color);
+}
+
+void TFT_eSPI::rasterRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+{
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if (x + w > _width)
+        w = _width - x;
+    if (y + h > _height)
+        h = _height - y;
+    if (w <= 0 || h <= 0)
+        return;
+
+    if (m_onPanel)
+    {
+        HostSim::accountWindow();
+        HostSim::accountPixels((uint32_t)(w * h));
+    }
+    for (int32_t j = y; j < y + h; ++j)
+        for (int32_t i = x; i < x + w; ++i)
+            storePixel(i, j, color);
+}
+
+void TFT_eSPI::fillScreen(uint32_t color)
+{
+    CostScope scope(Cost::FillScreen);
+    fillRect(0, 0, _width, _height, color);
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color)
+{
+    CostScope scope(Cost::Pixels);
+    rasterRect(x, y, 1, 1, (uint16_t)color);
+}
+
+void TFT_eSPI::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color)
+{
+    CostScope scope(Cost::Lines);
+    rasterRect(x, y, w, 1, (uint16_t)color);
+}
+
+void TFT_eSPI::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color)
+{
+    CostScope scope(Cost::Lines);
+    rasterRect(x, y, 1, h, (uint16_t)color);
+}
+
+void TFT_eSPI::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color)
+{
+    CostScope scope(Cost::Lines);
+    // Bresenham, batching each straight run into one window like the driver does
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep)
+    {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    if (x0 > x1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    int32_t dx = x1 - x0, dy = abs(y1 - y0);
+    int32_t err = dx >> 1, ystep = (y0 < y1) ? 1 : -1;
+    int32_t runStart = x0;
+    for (int32_t x = x0; x <= x1; ++x)
+    {
+        err -= dy;
+        if (err < 0 || x == x1)
+        {
+            int32_t len = x - runStart + 1;
+            if (steep)
+                rasterRect(y0, runStart, 1, len, (uint16_t)color);
+            else
+                rasterRect(runStart, y0, len, 1, (uint16_t)color);
+            if (err < 0)
+            {
+                y0 += ystep;
+                err += dx;
+            }
+            runStart = x + 1;
+        }
+    }
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color)
+{
+    CostScope scope(Cost::FillRect);
+    rasterRect(x, y, w, h, (uint16_t)color);
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color)
+{
+    CostScope scope(Cost::DrawRect);
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y + 1, h - 2, color);
+    drawFastVLine(x + w - 1, y + 1, h - 2, color);
+}
+
+void TFT_eSPI::fillCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t cornername, int32_t delta, uint32_t color)
+{
+    int32_t f = 1 - r;
+    int32_t ddF_x = 1;
+    int32_t ddF_y = -r - r;
+    int32_t y = 0;
+
+    delta++;
+    while (y < r)
+    {
+        if (f >= 0)
+        {
+            if (cornername & 0x1)
+                drawFastHLine(x0 - y, y0 + r, y + y + delta, color);
+            if (cornername & 0x2)
+                drawFastHLine(x0 - y, y0 - r, y + y + delta, color);
+            r--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        y++;
+        ddF_x += 2;
+        f += ddF_x;
+        if (cornername & 0x1)
+            drawFastHLine(x0 - r, y0 + y, r + r + delta, color);
+        if (cornername & 0x2)
+            drawFastHLine(x0 - r, y0 - y, r + r + delta, color);
+    }
+}
+
+void TFT_eSPI::drawCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t cornername, uint32_t color)
+{
+    int32_t f = 1 - r;
+    int32_t ddF_x = 1;
+    int32_t ddF_y = -2 * r;
+    int32_t x = 0;
+
+    while (x < r)
+    {
+        if (f >= 0)
+        {
+            r--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
+        if (cornername & 0x4)
+        {
+            drawPixel(x0 + x, y0 + r, color);
+            drawPixel(x0 + r, y0 + x, color);
+        }
+        if (cornername & 0x2)
+        {
+            drawPixel(x0 + x, y0 - r, color);
+            drawPixel(x0 + r, y0 - x, color);
+        }
+        if (cornername & 0x8)
+        {
+            drawPixel(x0 - r, y0 + x, color);
+            drawPixel(x0 - x, y0 + r, color);
+        }
+        if (cornername & 0x1)
+        {
+            drawPixel(x0 - r, y0 - x, color);
+            drawPixel(x0 - x, y0 - r, color);
+        }
+    }
+}
+
+void TFT_eSPI::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color)
+{
+    CostScope scope(Cost::RoundRect);
+    fillRect(x, y + r, w, h - r - r, color);
+    fillCircleHelper(x + r, y + h - r - 1, r, 1, w - r - r - 1, color);
+    fillCircleHelper(x + r, y + r, r, 2, w - r - r - 1, color);
+}
+
+void TFT_eSPI::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color)
+{
+    CostScope scope(Cost::RoundRect);
+    drawFastHLine(x + r, y, w - r - r, color);
+    drawFastHLine(x + r, y + h - 1, w - r - r, color);
+    drawFastVLine(x, y + r, h - r - r, color);
+    drawFastVLine(x + w - 1, y + r, h - r - r, color);
+    drawCircleHelper(x + r, y + r, r, 1, color);
+    drawCircleHelper(x + w - r - 1, y + r, r, 2, color);
+    drawCircleHelper(x + w - r - 1, y + h - r - 1, r, 4, color);
+    drawCircleHelper(x + r, y + h - r - 1, r, 8, color);
+}
+
+void TFT_eSPI::fillCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color)
+{
+    CostScope scope(Cost::Lines);
+    int32_t x = 0;
+    int32_t dx = 1;
+    int32_t dy = r + r;
+    int32_t p = -(r >> 1);
+
+    drawFastHLine(x0 - r, y0, dy + 1, color);
+    while (x < r)
+    {
+        if (p >= 0)
+        {
+            drawFastHLine(x0 - x, y0 + r, 2 * x + 1, color);
+            drawFastHLine(x0 - x, y0 - r, 2 * x + 1, color);
+            dy -= 2;
+            p -= dy;
+            r--;
+        }
+        dx += 2;
+        p += dx;
+        x++;
+        drawFastHLine(x0 - r, y0 + x, 2 * r + 1, color);
+        drawFastHLine(x0 - r, y0 - x, 2 * r + 1, color);
+    }
+}
+
+void TFT_eSPI::drawCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color)
+{
+    CostScope scope(Cost::Pixels);
+    int32_t x = 0, y = r, f = 1 - r;
+    while (x <= y)
+    {
+        drawPixel(x0 + x, y0 + y, color);
+        drawPixel(x0 - x, y0 + y, color);
+        drawPixel(x0 + x, y0 - y, color);
+        drawPixel(x0 - x, y0 - y, color);
+        drawPixel(x0 + y, y0 + x, color);
+        drawPixel(x0 - y, y0 + x, color);
+        drawPixel(x0 + y, y0 - x, color);
+        drawPixel(x0 - y, y0 - x, color);
+        x++;
+        if (f < 0)
+        {
+            f += 2 * x + 1;
+        }
+        else
+        {
+            y--;
+            f += 2 * (x - y) + 1;
+        }
+    }
+}
+
+void TFT_eSPI::setAddrWindow(int32_t x, int32_t y, int32_t w, int32_t h)
+{
+    CostScope scope(Cost::PushColors);
+    m_winX = x;
+    m_winY = y;
+    m_winW = w;
+    m_winH = h;
+    m_winPos = 0;
+    if (m_onPanel)
+        HostSim::accountWindow();
+}
+
+void TFT_eSPI::pushWindowPixel(uint16_t color)
+{
+    if (m_winW <= 0 || m_winPos >= m_winW * m_winH)
+        return;
+    storePixel(m_winX + m_winPos % m_winW, m_winY + m_winPos / m_winW, color);
+    m_winPos++;
+}
+
+void TFT_eSPI::pushColor(uint16_t color)
+{
+    pushColor(color, 1);
+}
+
+void TFT_eSPI::pushColor(uint16_t color, uint32_t len)
+{
+    CostScope scope(Cost::PushColors);
+    if (m_onPanel)
+        HostSim::accountPixels(len);
+    while (len--)
+        pushWindowPixel(color);
+}
+
+void TFT_eSPI::pushColors(uint16_t *data, uint32_t len, bool swap)
+{
+    CostScope scope(Cost::PushColors);
+    if (m_onPanel)
+        HostSim::accountPixels(len);
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        uint16_t color = data[i];
+        if (!swap)
+            color = (color >> 8) | (color << 8);
+        pushWindowPixel(color);
+    }
+}
+
+void TFT_eSPI::pushColors(uint8_t *data, uint32_t len)
+{
+    pushColors((uint16_t *)data, len / 2, false);
+}
+
+void TFT_eSPI::pushPixels(const void *data_in, uint32_t len)
+{
+    pushColors((uint16_t *)data_in, len, true);
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data)
+{
+    pushImage(x, y, w, h, (const uint16_t *)data);
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data)
+{
+    CostScope scope(Cost::PushColors);
+    setAddrWindow(x, y, w, h);
+    pushColors((uint16_t *)data, (uint32_t)(w * h), true);
+}
+
+int16_t TFT_eSPI::glyphWidth(uint16_t c, uint8_t font)
+{
+    if (font == 1)
+        return 6 * textsize;
+
+    int16_t w;
+    if (c == ' ')
+        w = 4;
+    else if (strchr("il.,:;'!|`", c))
+        w = 3;
+    else if (strchr("fjrt()[]{}", c))
+        w = 5;
+    else if (strchr("mwMW@", c))
+        w = 10;
+    else if (isupper(c) || strchr("#%&", c))
+        w = 8;
+    else
+        w = 7;
+
+    if (font == 4)
+        w = (w * 26 + 8) / 16;
+    else if (font >= 6)
+        w = (w * 48 + 8) / 16;
+    return w * textsize;
+}
+
+int16_t TFT_eSPI::fontHeight(int16_t font)
+{
+    switch (font)
+    {
+    case 1:
+        return 8 * textsize;
+    case 2:
+        return 16 * textsize;
+    case 4:
+        return 26 * textsize;
+    case 8:
+        return 75 * textsize;
+    default:
+        return 48 * textsize;
+    }
+}
+
+int16_t TFT_eSPI::textWidth(const char *string, uint8_t font)
+{
+    int16_t w = 0;
+    while (string && *string)
+        w += glyphWidth((uint8_t)*string++, font);
+    return w;
+}
+
+void TFT_eSPI::rasterGlyph(uint16_t c, int32_t x, int32_t y, uint8_t font, uint32_t fg, uint32_t bg)
+{
+    int32_t w = glyphWidth(c, font);
+    int32_t h = fontHeight(font);
+    int32_t scale = textsize;
+
+    // Synthetic glyph: a hash of the character picks which cells are inked
+    // inside a one-cell margin, so equal strings produce equal pixels.
+    auto inked = [&](int32_t px, int32_t py) -> bool {
+        px /= scale;
+        py /= scale;
+        if (c == ' ' || px < 1 || py < 2 || px >= w / scale - 1 || py >= h / scale - 2)
+            return false;
+        uint32_t hash = (c * 2654435761u) ^ (px * 40503u) ^ (py * 9973u);
+        return ((hash >> 7) % 3) == 0;
+    };
+
+    if (fg != bg)
+    {
+        // solid background: the driver opens one window over the cell
+        if (m_onPanel)
+        {
+            HostSim::accountWindow();
+            HostSim::accountPixels((uint32_t)(w * h));
+        }
+        for (int32_t py = 0; py < h; ++py)
+            for (int32_t px = 0; px < w; ++px)
+                storePixel(x + px, y + py, inked(px, py) ? fg : bg);
+        return;
+    }
+
+    // transparent background: one window per horizontal run of ink
+    for (int32_t py = 0; py < h; ++py)
+    {
+        int32_t px = 0;
+        while (px < w)
+        {
+            if (!inked(px, py))
+            {
+                px++;
+                continue;
+            }
+            int32_t run = px;
+            while (run < w && inked(run, py))
+                run++;
+            rasterRect(x + px, y + py, run - px, 1, (uint16_t)fg);
+            px = run;
+        }
+    }
+}
+
+int16_t TFT_eSPI::drawChar(uint16_t uniCode, int32_t x, int32_t y, uint8_t font)
+{
+    CostScope scope(Cost::DrawString);
+    rasterGlyph(uniCode, x, y, font, textcolor, textbgcolor);
+    return glyphWidth(uniCode, font);
+}
+
+int16_t TFT_eSPI::drawString(const char *string, int32_t x, int32_t y, uint8_t font)
+{
+    CostScope scope(Cost::DrawString);
+    int32_t w = textWidth(string, font);
+    int32_t h = fontHeight(font);
+
+    int32_t padLeft = 0;
+    switch (textdatum)
+    {
+    case TC_DATUM:
+    case MC_DATUM:
+    case BC_DATUM:
+    case C_BASELINE:
+        x -= w / 2;
+        padLeft = (padX > w) ? (padX - w) / 2 : 0;
+        break;
+    case TR_DATUM:
+    case MR_DATUM:
+    case BR_DATUM:
+    case R_BASELINE:
+        x -= w;
+        padLeft = (padX > w) ? padX - w : 0;
+        break;
+    }
+    switch (textdatum)
+    {
+    case ML_DATUM:
+    case MC_DATUM:
+    case MR_DATUM:
+        y -= h / 2;
+        break;
+    case BL_DATUM:
+    case BC_DATUM:
+    case BR_DATUM:
+    case L_BASELINE:
+    case C_BASELINE:
+    case R_BASELINE:
+        y -= h;
+        break;
+    }
+
+    for (const char *p = string; p && *p; ++p)
+    {
+        rasterGlyph((uint8_t)*p, x, y, font, textcolor, textbgcolor);
+        x += glyphWidth((uint8_t)*p, font);
+    }
+
+    if (padX > w && textcolor != textbgcolor)
+    {
+        int32_t padRight = padX - w - padLeft;
+        if (padLeft)
+            rasterRect(x - w - padLeft, y, padLeft, h, (uint16_t)textbgcolor);
+        if (padRight)
+            rasterRect(x, y, padRight, h, (uint16_t)textbgcolor);
+    }
+    return (int16_t)w;
+}
+
+int16_t TFT_eSPI::drawCentreString(const char *string, int32_t x, int32_t y, uint8_t font)
+{
+    uint8_t tempdatum = textdatum;
+    textdatum = TC_DATUM;
+    int16_t w = drawString(string, x, y, font);
+    textdatum = tempdatum;
+    return w;
+}
+
+int16_t TFT_eSPI::drawRightString(const char *string, int32_t x, int32_t y, uint8_t font)
+{
+    uint8_t tempdatum = textdatum;
+    textdatum = TR_DATUM;
+    int16_t w = drawString(string, x, y, font);
+    textdatum = tempdatum;
+    return w;
+}
+
+size_t TFT_eSPI::write(uint8_t c)
+{
+    if (c == '\n')
+    {
+        cursor_x = 0;
+        cursor_y += fontHeight(textfont);
+        return 1;
+    }
+    if (c == '\r')
+        return 1;
+    cursor_x += drawChar(c, cursor_x, cursor_y, textfont);
+    return 1;
+}
+
+// five validTouch() passes, as the library makes them
+uint8_t TFT_eSPI::getTouch(uint16_t *x, uint16_t *y, uint16_t threshold)
+{
+    if (threshold < 20)
+        threshold = 20;
+    uint16_t xTmp = 0, yTmp = 0;
+    uint8_t valid = 0;
+    for (uint8_t n = 0; n < 5; ++n)
+        valid += validTouch(&xTmp, &yTmp, threshold);
+    if (!valid)
+        return 0;
+    *x = xTmp;
+    *y = yTmp;
+    return valid;
+}
+
+// waits for the pressure to settle, then reads twice with delay()s between,
+// the delays being what makes getTouch() unusable outside loop context
+uint8_t TFT_eSPI::validTouch(uint16_t *x, uint16_t *y, uint16_t threshold)
+{
+    uint16_t z1 = 1, z2 = 0;
+    while (z1 > z2)
+    {
+        z2 = z1;
+        z1 = getTouchRawZ();
+        delay(1);
+    }
+    if (z1 <= threshold)
+        return 0;
+
+    uint16_t x1, y1, x2, y2;
+    if (!HostSim::touchAt(millis(), &x1, &y1))
+        return 0;
+    delay(1);
+    if (getTouchRawZ() <= threshold)
+        return 0;
+    delay(2);
+    if (!HostSim::touchAt(millis(), &x2, &y2))
+        return 0;
+    *x = x1;
+    *y = y1;
+    return 1;
+}
+
+uint16_t TFT_eSPI::getTouchRawZ()
+{
+    uint16_t x, y;
+    return HostSim::touchAt(millis(), &x, &y) ? 1000 : 0;
+}
+
+void TFT_eSPI::setTouch(uint16_t *data)
+{
+    memcpy(m_touchCal, data, sizeof(m_touchCal));
+}
+
+void TFT_eSPI::calibrateTouch(uint16_t *data, uint32_t color_fg, uint32_t color_bg, uint8_t size)
+{
+    // the host panel is already in screen coordinates
+    static const uint16_t identity[5] = {0, 4095, 0, 4095, 1};
+    (void)color_fg;
+    (void)color_bg;
+    (void)size;
+    memcpy(data, identity, sizeof(identity));
+    setTouch(data);
+}
+
+TFT_eSprite::TFT_eSprite(TFT_eSPI *tft) : TFT_eSPI(0, 0),
+    m_tft(tft),
+    m_buffer(nullptr),
+    m_bpp(16)
+{
+    m_onPanel = false;
+}
+
+TFT_eSprite::~TFT_eSprite()
+{
+    deleteSprite();
+}
+
+void *TFT_eSprite::createSprite(int16_t w, int16_t h, uint8_t frames)
+{
+    (void)frames;
+    if (m_buffer)
+        return m_buffer;
+    if (w <= 0 || h <= 0)
+        return nullptr;
+    m_buffer = HostSim::heapAlloc((size_t)w * h * (m_bpp / 8));
+    if (!m_buffer)
+        return nullptr;
+    _width = w;
+    _height = h;
+    memset(m_buffer, 0, (size_t)w * h * (m_bpp / 8));
+    return m_buffer;
+}
+
+void TFT_eSprite::deleteSprite()
+{
+    HostSim::heapFree(m_buffer);
+    m_buffer = nullptr;
+    _width = 0;
+    _height = 0;
+}
+
+void *TFT_eSprite::setColorDepth(int8_t b)
+{
+    int8_t bpp = b == 8 ? 8 : 16;
+    if (bpp == m_bpp)
+        return m_buffer;
+    m_bpp = bpp;
+    if (!m_buffer)
+        return nullptr;
+    int16_t w = _width, h = _height;
+    deleteSprite();
+    return createSprite(w, h);
+}
+
+void TFT_eSprite::storePixel(int32_t x, int32_t y, uint16_t color)
+{
+    if (!m_buffer || x < 0 || y < 0 || x >= _width || y >= _height)
+        return;
+    if (m_bpp == 16)
+        ((uint16_t *)m_buffer)[y * _width + x] = color;
+    else
+        ((uint8_t *)m_buffer)[y * _width + x] = ((color & 0xE000) >> 8) | ((color & 0x0700) >> 6) | ((color & 0x0018) >> 3);
+}
+
+uint16_t TFT_eSprite::readPixel(int32_t x, int32_t y)
+{
+    if (!m_buffer || x < 0 || y < 0 || x >= _width || y >= _height)
+        return 0xFFFF;
+    return bufferPixel(y * _width + x);
+}
+
+uint16_t TFT_eSprite::bufferPixel(int32_t i)
+{
+    if (m_bpp == 16)
+        return ((uint16_t *)m_buffer)[i];
+    // RGB332 back to RGB565 the way the driver expands it
+    uint8_t c = ((uint8_t *)m_buffer)[i];
+    return ((c & 0xE0) << 8) | ((c & 0xE0) << 5) | ((c & 0x1C) << 6) | ((c & 0x1C) << 3) | ((c & 0x03) << 3) |
+           ((c & 0x03) << 1) | ((c & 0x03) >> 1);
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y)
+{
+    if (!m_buffer)
+        return;
+    CostScope scope(Cost::PushColors);
+    m_tft->setAddrWindow(x, y, _width, _height);
+    for (int32_t j = 0; j < _height; ++j)
+    {
+        uint16_t line[480];
+        int32_t w = min(_width, (int32_t)480);
+        for (int32_t i = 0; i < w; ++i)
+            line[i] = bufferPixel(j * _width + i);
+        m_tft->pushColors(line, w);
+    }
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y, uint16_t transparent)
+{
+    if (!m_buffer)
+        return;
+    // the driver sends each opaque run as its own window
+    CostScope scope(Cost::PushColors);
+    for (int32_t j = 0; j < _height; ++j)
+    {
+        int32_t i = 0;
+        while (i < _width)
+        {
+            while (i < _width && bufferPixel(j * _width + i) == transparent)
+                ++i;
+            int32_t start = i;
+            uint16_t run[480];
+            while (i < _width && bufferPixel(j * _width + i) != transparent && i - start < 480)
+            {
+                run[i - start] = bufferPixel(j * _width + i);
+                ++i;
+            }
+            if (i > start)
+            {
+                m_tft->setAddrWindow(x + start, y + j, i - start, 1);
+                m_tft->pushColors(run, i - start);
+            }
+        }
+    }
+}
+
+TFT_eSPI_Button::TFT_eSPI_Button(void) : _gfx(nullptr),
+    _x1(0),
+    _y1(0),
+    _xd(0),
+    _yd(0),
+    _textdatum(MC_DATUM),
+    _w(0),
+    _h(0),
+    _textsize(1),
+    _outlinecolor(TFT_WHITE),
+    _fillcolor(TFT_BLACK),
+    _textcolor(TFT_WHITE),
+    _label{0},
+    currstate(false),
+    laststate(false)
+{
+}
+
+void TFT_eSPI_Button::initButton(TFT_eSPI *gfx, int16_t x, int16_t y, uint16_t w, uint16_t h,
+                                 uint16_t outline, uint16_t fill, uint16_t textcolor, char *label, uint8_t textsize)
+{
+    initButtonUL(gfx, x - (w / 2), y - (h / 2), w, h, outline, fill, textcolor, label, textsize);
+}
+
+void TFT_eSPI_Button::initButtonUL(TFT_eSPI *gfx, int16_t x1, int16_t y1, uint16_t w, uint16_t h,
+                                   uint16_t outline, uint16_t fill, uint16_t textcolor, char *label, uint8_t textsize)
+{
+    _x1 = x1;
+    _y1 = y1;
+    _w = w;
+    _h = h;
+    _outlinecolor = outline;
+    _fillcolor = fill;
+    _textcolor = textcolor;
+    _textsize = textsize;
+    _gfx = gfx;
+    strncpy(_label, label, 9);
+    _label[9] = 0;
+}
+
+void TFT_eSPI_Button::setLabelDatum(int16_t x_delta, int16_t y_delta, uint8_t datum)
+{
+    _xd = x_delta;
+    _yd = y_delta;
+    _textdatum = datum;
+}
+
+void TFT_eSPI_Button::drawButton(bool inverted, String long_name)
+{
+    CostScope scope(Cost::DrawButton);
+    uint16_t fill, outline, text;
+
+    if (!inverted)
+    {
+        fill = _fillcolor;
+        outline = _outlinecolor;
+        text = _textcolor;
+    }
+    else
+    {
+        fill = _textcolor;
+        outline = _outlinecolor;
+        text = _fillcolor;
+    }
+
+    uint8_t r = min(_w, _h) / 4;
+    _gfx->fillRoundRect(_x1, _y1, _w, _h, r, fill);
+    _gfx->drawRoundRect(_x1, _y1, _w, _h, r, outline);
+
+    _gfx->setTextColor(text, fill);
+    _gfx->setTextSize(_textsize);
+
+    uint8_t tempdatum = _gfx->getTextDatum();
+    _gfx->setTextDatum(_textdatum);
+    uint16_t tempPadding = _gfx->getTextPadding();
+    _gfx->setTextPadding(0);
+
+    if (long_name == "")
+        _gfx->drawString(_label, _x1 + (_w / 2) + _xd, _y1 + (_h / 2) - 4 + _yd);
+    else
+        _gfx->drawString(long_name, _x1 + (_w / 2) + _xd, _y1 + (_h / 2) - 4 + _yd);
+
+    _gfx->setTextDatum(tempdatum);
+    _gfx->setTextPadding(tempPadding);
+}
+
+bool TFT_eSPI_Button::contains(int16_t x, int16_t y)
+{
+    return ((x >= _x1) && (x < (_x1 + _w)) &&
+            (y >= _y1) && (y < (_y1 + _h)));
+}
+
+void TFT_eSPI_Button::press(bool p)
+{
+    laststate = currstate;
+    currstate = p;
+}
+
+bool TFT_eSPI_Button::isPressed()
+{
+    return currstate;
+}
+
+bool TFT_eSPI_Button::justPressed()
+{
+    return (currstate && !laststate);
+}
+
+bool TFT_eSPI_Button::justReleased()
+{
+    return (!currstate && laststate);
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+// Host stand-in for Bodmer's TFT_eSPI. Drawing lands in the HostSim RGB565
+// framebuffer and every address window and pixel is charged to the SPI cost
+// counters the way the real driver would put them on the bus. Glyphs are
+// synthetic boxes with approximate per-font advances, so text costs are close
+// to but not identical with the real fonts.
+
+#include "Arduino.h"
+
+#define TFT_WIDTH 320
+#define TFT_HEIGHT 480
+
+#define TFT_BLACK 0x0000
+#define TFT_NAVY 0x000F
+#define TFT_DARKGREEN 0x03E0
+#define TFT_DARKCYAN 0x03EF
+#define TFT_MAROON 0x7800
+#define TFT_PURPLE 0x780F
+#define TFT_OLIVE 0x7BE0
+#define TFT_LIGHTGREY 0xD69A
+#define TFT_DARKGREY 0x7BEF
+#define TFT_BLUE 0x001F
+#define TFT_GREEN 0x07E0
+#define TFT_CYAN 0x07FF
+#define TFT_RED 0xF800
+#define TFT_MAGENTA 0xF81F
+#define TFT_YELLOW 0xFFE0
+#define TFT_WHITE 0xFFFF
+#define TFT_ORANGE 0xFDA0
+#define TFT_GREENYELLOW 0xB7E0
+#define TFT_PINK 0xFE19
+#define TFT_BROWN 0x9A60
+#define TFT_GOLD 0xFEA0
+#define TFT_SILVER 0xC618
+#define TFT_SKYBLUE 0x867D
+#define TFT_VIOLET 0x915C
+#define TFT_TRANSPARENT 0x0120
+
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define TR_DATUM 2
+#define ML_DATUM 3
+#define CL_DATUM 3
+#define MC_DATUM 4
+#define CC_DATUM 4
+#define MR_DATUM 5
+#define CR_DATUM 5
+#define BL_DATUM 6
+#define BC_DATUM 7
+#define BR_DATUM 8
+#define L_BASELINE 9
+#define C_BASELINE 10
+#define R_BASELINE 11
+
+class TFT_eSPI : public Print
+{
+    protected:
+    int32_t _width, _height;
+    int32_t m_winX, m_winY, m_winW, m_winH, m_winPos;
+    uint16_t m_touchCal[5];
+
+    // True for the panel itself; sprites clear it so that drawing into their
+    // buffer is not charged to the SPI counters.
+    bool m_onPanel = true;
+
+    virtual void storePixel(int32_t x, int32_t y, uint16_t color);
+    void rasterRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+    void pushWindowPixel(uint16_t color);
+
+    int16_t glyphWidth(uint16_t c, uint8_t font);
+    void rasterGlyph(uint16_t c, int32_t x, int32_t y, uint8_t font, uint32_t fg, uint32_t bg);
+    void fillCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t cornername, int32_t delta, uint32_t color);
+    void drawCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t cornername, uint32_t color);
+
+    public:
+    // public in the real driver too
+    int32_t cursor_x, cursor_y;
+    uint32_t textcolor, textbgcolor;
+    uint8_t textfont, textsize, textdatum, rotation;
+    uint16_t padX;
+
+    TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
+    virtual ~TFT_eSPI() {}
+
+    void init(uint8_t tc = 0);
+    void begin(uint8_t tc = 0) { init(tc); }
+    void setRotation(uint8_t r);
+    uint8_t getRotation() { return rotation; }
+    int16_t width() { return _width; }
+    int16_t height() { return _height; }
+
+    void startWrite() {}
+    void endWrite() {}
+
+    void fillScreen(uint32_t color);
+    void drawPixel(int32_t x, int32_t y, uint32_t color);
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color);
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color);
+    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+    void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+    void fillCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color);
+    void drawCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color);
+
+    void setAddrWindow(int32_t x, int32_t y, int32_t w, int32_t h);
+    void setWindow(int32_t x0, int32_t y0, int32_t x1, int32_t y1) { setAddrWindow(x0, y0, x1 - x0 + 1, y1 - y0 + 1); }
+    void pushColor(uint16_t color);
+    void pushColor(uint16_t color, uint32_t len);
+    void pushColors(uint16_t *data, uint32_t len, bool swap = true);
+    void pushColors(uint8_t *data, uint32_t len);
+    void pushBlock(uint16_t color, uint32_t len) { pushColor(color, len); }
+    void pushPixels(const void *data_in, uint32_t len);
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data);
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+
+    void setCursor(int16_t x, int16_t y) { cursor_x = x; cursor_y = y; }
+    void setCursor(int16_t x, int16_t y, uint8_t font) { setTextFont(font); setCursor(x, y); }
+    int16_t getCursorX() { return cursor_x; }
+    int16_t getCursorY() { return cursor_y; }
+    void setTextFont(uint8_t font) { textfont = font ? font : 1; }
+    void setTextSize(uint8_t size) { textsize = size ? size : 1; }
+    void setTextColor(uint16_t color) { textcolor = textbgcolor = color; }
+    void setTextColor(uint16_t fgcolor, uint16_t bgcolor) { textcolor = fgcolor; textbgcolor = bgcolor; }
+    void setTextDatum(uint8_t datum) { textdatum = datum; }
+    uint8_t getTextDatum() { return textdatum; }
+    void setTextPadding(uint16_t x_width) { padX = x_width; }
+    uint16_t getTextPadding() { return padX; }
+    void setTextWrap(bool wrapX, bool wrapY = false) { (void)wrapX; (void)wrapY; }
+
+    int16_t textWidth(const char *string, uint8_t font);
+    int16_t textWidth(const char *string) { return textWidth(string, textfont); }
+    int16_t textWidth(const String &string, uint8_t font) { return textWidth(string.c_str(), font); }
+    int16_t textWidth(const String &string) { return textWidth(string.c_str(), textfont); }
+    int16_t fontHeight(int16_t font);
+    int16_t fontHeight() { return fontHeight(textfont); }
+
+    int16_t drawChar(uint16_t uniCode, int32_t x, int32_t y, uint8_t font);
+    int16_t drawChar(uint16_t uniCode, int32_t x, int32_t y) { return drawChar(uniCode, x, y, textfont); }
+    int16_t drawString(const char *string, int32_t x, int32_t y, uint8_t font);
+    int16_t drawString(const char *string, int32_t x, int32_t y) { return drawString(string, x, y, textfont); }
+    int16_t drawString(const String &string, int32_t x, int32_t y, uint8_t font) { return drawString(string.c_str(), x, y, font); }
+    int16_t drawString(const String &string, int32_t x, int32_t y) { return drawString(string.c_str(), x, y, textfont); }
+    int16_t drawCentreString(const char *string, int32_t x, int32_t y, uint8_t font);
+    int16_t drawCentreString(const String &string, int32_t x, int32_t y, uint8_t font) { return drawCentreString(string.c_str(), x, y, font); }
+    int16_t drawRightString(const char *string, int32_t x, int32_t y, uint8_t font);
+    int16_t drawRightString(const String &string, int32_t x, int32_t y, uint8_t font) { return drawRightString(string.c_str(), x, y, font); }
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    // blocks with delay() as the library does, 5 ms with the pen up and
+    // 25 ms with it down
+    uint8_t getTouch(uint16_t *x, uint16_t *y, uint16_t threshold = 600);
+    uint8_t validTouch(uint16_t *x, uint16_t *y, uint16_t threshold);
+    uint16_t getTouchRawZ();
+    void setTouch(uint16_t *data);
+    void calibrateTouch(uint16_t *data, uint32_t color_fg, uint32_t color_bg, uint8_t size);
+
+    uint16_t color565(uint8_t r, uint8_t g, uint8_t b) { return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3); }
+};
+
+// Off-screen RGB565 buffer with the full drawing API. Drawing into it costs no
+// SPI traffic; pushSprite() sends it as one address window. The buffer comes
+// from the simulated heap, like the real driver's malloc.
+class TFT_eSprite : public TFT_eSPI
+{
+    public:
+    explicit TFT_eSprite(TFT_eSPI *tft);
+    ~TFT_eSprite();
+
+    void *createSprite(int16_t w, int16_t h, uint8_t frames = 1);
+    void deleteSprite();
+    bool created() { return m_buffer != nullptr; }
+    void *setColorDepth(int8_t b);
+    int8_t getColorDepth() { return m_bpp; }
+
+    void fillSprite(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+    uint16_t readPixel(int32_t x, int32_t y);
+    void pushSprite(int32_t x, int32_t y);
+    void pushSprite(int32_t x, int32_t y, uint16_t transparent);
+
+    protected:
+    void storePixel(int32_t x, int32_t y, uint16_t color) override;
+
+    private:
+    TFT_eSPI *m_tft;
+    void *m_buffer;
+    int8_t m_bpp;
+
+    uint16_t bufferPixel(int32_t i);
+};
+
+class TFT_eSPI_Button
+{
+    public:
+    TFT_eSPI_Button(void);
+
+    void initButton(TFT_eSPI *gfx, int16_t x, int16_t y, uint16_t w, uint16_t h,
+                    uint16_t outline, uint16_t fill, uint16_t textcolor, char *label, uint8_t textsize);
+    void initButtonUL(TFT_eSPI *gfx, int16_t x1, int16_t y1, uint16_t w, uint16_t h,
+                      uint16_t outline, uint16_t fill, uint16_t textcolor, char *label, uint8_t textsize);
+    void setLabelDatum(int16_t x_delta, int16_t y_delta, uint8_t datum = MC_DATUM);
+    void drawButton(bool inverted = false, String long_name = "");
+    bool contains(int16_t x, int16_t y);
+
+    void press(bool p);
+    bool isPressed();
+    bool justPressed();
+    bool justReleased();
+
+    private:
+    TFT_eSPI *_gfx;
+    int16_t _x1, _y1;
+    int16_t _xd, _yd;
+    uint8_t _textdatum;
+    uint16_t _w, _h;
+    uint8_t _textsize;
+    uint16_t _outlinecolor, _fillcolor, _textcolor;
+    char _label[10];
+    bool currstate, laststate;
+};
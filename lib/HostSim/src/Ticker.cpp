@@ -0,0 +1,55 @@
+#include "Ticker.h"
+#include "HostSim.h"
+
+Ticker::Ticker(void) : m_callback(),
+    m_active(false),
+    m_repeat(false)
+{
+}
+
+Ticker::~Ticker()
+{
+    detach();
+}
+
+void Ticker::arm(uint32_t periodUs, bool repeat, callback_function_t callback)
+{
+    m_callback = callback;
+    m_active = true;
+    m_repeat = repeat;
+    HostSim::addTimer(this, periodUs, repeat, fire);
+}
+
+void Ticker::attach(float seconds, callback_function_t callback)
+{
+    arm((uint32_t)(seconds * 1000000), true, callback);
+}
+
+void Ticker::attach_ms(uint32_t milliseconds, callback_function_t callback)
+{
+    arm(milliseconds * 1000, true, callback);
+}
+
+void Ticker::once_ms(uint32_t milliseconds, callback_function_t callback)
+{
+    arm(milliseconds * 1000, false, callback);
+}
+
+void Ticker::detach()
+{
+    if (!m_active)
+        return;
+    HostSim::removeTimer(this);
+    m_active = false;
+}
+
+void Ticker::fire(void *ticker)
+{
+    Ticker *self = (Ticker *)ticker;
+    // a one-shot is already off the timer list
+    if (!self->m_repeat)
+        self->m_active = false;
+    callback_function_t callback = self->m_callback;
+    if (callback)
+        callback();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Host stand-in for the ESP8266 core's Ticker. Callbacks run from delay() and
+// yield() as virtual time passes, see HostSim::addTimer().
+
+#include <Arduino.h>
+
+#include <functional>
+
+class Ticker
+{
+    public:
+    typedef std::function<void(void)> callback_function_t;
+
+    Ticker(void);
+    ~Ticker();
+
+    void attach(float seconds, callback_function_t callback);
+    void attach_ms(uint32_t milliseconds, callback_function_t callback);
+    void once_ms(uint32_t milliseconds, callback_function_t callback);
+    void detach();
+    bool active() const { return m_active; }
+
+    private:
+    callback_function_t m_callback;
+    bool m_active;
+    bool m_repeat;
+
+    void arm(uint32_t periodUs, bool repeat, callback_function_t callback);
+    static void fire(void *ticker);
+};
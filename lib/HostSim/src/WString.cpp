@@ -0,0 +1,394 @@
+#include "WString.h"
+#include "HostSim.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const String emptyString;
+
+static void formatInteger(char *buf, size_t size, unsigned long value, bool negative, unsigned char base)
+{
+    char tmp[33];
+    int i = 0;
+    if (base < 2)
+        base = 10;
+    do
+    {
+        unsigned long digit = value % base;
+        tmp[i++] = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+        value /= base;
+    } while (value && i < 32);
+
+    size_t pos = 0;
+    if (negative && pos + 1 < size)
+        buf[pos++] = '-';
+    while (i > 0 && pos + 1 < size)
+        buf[pos++] = tmp[--i];
+    buf[pos] = 0;
+}
+
+String::String(const char *cstr) : m_buffer(nullptr), m_capacity(0), m_len(0)
+{
+    if (cstr)
+        copy(cstr, strlen(cstr));
+}
+
+String::String(const String &str) : m_buffer(nullptr), m_capacity(0), m_len(0)
+{
+    *this = str;
+}
+
+String::String(String &&rval) : m_buffer(rval.m_buffer), m_capacity(rval.m_capacity), m_len(rval.m_len)
+{
+    rval.m_buffer = nullptr;
+    rval.m_capacity = 0;
+    rval.m_len = 0;
+}
+
+String::String(const __FlashStringHelper *str) : String((const char *)str)
+{
+}
+
+String::String(char c) : m_buffer(nullptr), m_capacity(0), m_len(0)
+{
+    char buf[2] = {c, 0};
+    copy(buf, 1);
+}
+
+String::String(unsigned char value, unsigned char base) : String((unsigned long)value, base)
+{
+}
+
+String::String(int value, unsigned char base) : String((long)value, base)
+{
+}
+
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base)
+{
+}
+
+String::String(long value, unsigned char base) : m_buffer(nullptr), m_capacity(0), m_len(0)
+{
+    char buf[34];
+    bool negative = value < 0 && base == 10;
+    formatInteger(buf, sizeof(buf), negative ? 0UL - (unsigned long)value : (unsigned long)value, negative, base);
+    copy(buf, strlen(buf));
+}
+
+String::String(unsigned long value, unsigned char base) : m_buffer(nullptr), m_capacity(0), m_len(0)
+{
+    char buf[34];
+    formatInteger(buf, sizeof(buf), value, false, base);
+    copy(buf, strlen(buf));
+}
+
+String::String(float value, unsigned char decimalPlaces) : String((double)value, decimalPlaces)
+{
+}
+
+String::String(double value, unsigned char decimalPlaces) : m_buffer(nullptr), m_capacity(0), m_len(0)
+{
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+    copy(buf, strlen(buf));
+}
+
+String::~String()
+{
+    HostSim::heapFree(m_buffer);
+}
+
+void String::invalidate()
+{
+    HostSim::heapFree(m_buffer);
+    m_buffer = nullptr;
+    m_capacity = 0;
+    m_len = 0;
+}
+
+bool String::reserve(unsigned int size)
+{
+    if (m_buffer && m_capacity >= size)
+        return true;
+    if (changeBuffer(size))
+    {
+        if (m_len == 0)
+            m_buffer[0] = 0;
+        return true;
+    }
+    return false;
+}
+
+bool String::changeBuffer(unsigned int maxStrLen)
+{
+    char *newbuffer = (char *)HostSim::heapRealloc(m_buffer, maxStrLen + 1);
+    if (!newbuffer)
+        return false;
+    m_buffer = newbuffer;
+    m_capacity = maxStrLen;
+    return true;
+}
+
+String &String::copy(const char *cstr, unsigned int length)
+{
+    if (!reserve(length))
+    {
+        invalidate();
+        return *this;
+    }
+    m_len = length;
+    memmove(m_buffer, cstr, length);
+    m_buffer[length] = 0;
+    return *this;
+}
+
+String &String::operator=(const String &rhs)
+{
+    if (this == &rhs)
+        return *this;
+    return copy(rhs.c_str(), rhs.m_len);
+}
+
+String &String::operator=(String &&rval)
+{
+    if (this != &rval)
+    {
+        HostSim::heapFree(m_buffer);
+        m_buffer = rval.m_buffer;
+        m_capacity = rval.m_capacity;
+        m_len = rval.m_len;
+        rval.m_buffer = nullptr;
+        rval.m_capacity = 0;
+        rval.m_len = 0;
+    }
+    return *this;
+}
+
+String &String::operator=(const char *cstr)
+{
+    if (cstr)
+        return copy(cstr, strlen(cstr));
+    invalidate();
+    return *this;
+}
+
+bool String::concat(const char *cstr, unsigned int length)
+{
+    unsigned int newlen = m_len + length;
+    if (!cstr)
+        return false;
+    if (length == 0)
+        return true;
+    if (!reserve(newlen))
+        return false;
+    memmove(m_buffer + m_len, cstr, length);
+    m_len = newlen;
+    m_buffer[m_len] = 0;
+    return true;
+}
+
+bool String::concat(const String &s)
+{
+    return concat(s.c_str(), s.m_len);
+}
+
+bool String::concat(const char *cstr)
+{
+    if (!cstr)
+        return false;
+    return concat(cstr, strlen(cstr));
+}
+
+bool String::concat(char c)
+{
+    return concat(&c, 1);
+}
+
+bool String::concat(unsigned char num)
+{
+    return concat(String(num));
+}
+
+bool String::concat(int num)
+{
+    return concat(String(num));
+}
+
+bool String::concat(unsigned int num)
+{
+    return concat(String(num));
+}
+
+bool String::concat(long num)
+{
+    return concat(String(num));
+}
+
+bool String::concat(unsigned long num)
+{
+    return concat(String(num));
+}
+
+int String::compareTo(const String &s) const
+{
+    return strcmp(c_str(), s.c_str());
+}
+
+bool String::equals(const String &s) const
+{
+    return m_len == s.m_len && compareTo(s) == 0;
+}
+
+bool String::equals(const char *cstr) const
+{
+    return strcmp(c_str(), cstr ? cstr : "") == 0;
+}
+
+bool String::startsWith(const String &prefix) const
+{
+    return prefix.m_len <= m_len && strncmp(c_str(), prefix.c_str(), prefix.m_len) == 0;
+}
+
+bool String::endsWith(const String &suffix) const
+{
+    return suffix.m_len <= m_len && strcmp(c_str() + m_len - suffix.m_len, suffix.c_str()) == 0;
+}
+
+char String::charAt(unsigned int index) const
+{
+    return index < m_len ? m_buffer[index] : 0;
+}
+
+char &String::operator[](unsigned int index)
+{
+    static char dummy;
+    if (index >= m_len)
+    {
+        dummy = 0;
+        return dummy;
+    }
+    return m_buffer[index];
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const
+{
+    if (fromIndex >= m_len)
+        return -1;
+    const char *found = strchr(m_buffer + fromIndex, ch);
+    return found ? (int)(found - m_buffer) : -1;
+}
+
+int String::indexOf(const String &str, unsigned int fromIndex) const
+{
+    if (fromIndex >= m_len)
+        return -1;
+    const char *found = strstr(m_buffer + fromIndex, str.c_str());
+    return found ? (int)(found - m_buffer) : -1;
+}
+
+String String::substring(unsigned int left, unsigned int right) const
+{
+    if (left > right)
+    {
+        unsigned int temp = right;
+        right = left;
+        left = temp;
+    }
+    String out;
+    if (left >= m_len)
+        return out;
+    if (right > m_len)
+        right = m_len;
+    out.copy(m_buffer + left, right - left);
+    return out;
+}
+
+void String::toUpperCase()
+{
+    for (unsigned int i = 0; i < m_len; ++i)
+        m_buffer[i] = (char)toupper((unsigned char)m_buffer[i]);
+}
+
+void String::toLowerCase()
+{
+    for (unsigned int i = 0; i < m_len; ++i)
+        m_buffer[i] = (char)tolower((unsigned char)m_buffer[i]);
+}
+
+void String::trim()
+{
+    if (!m_buffer || m_len == 0)
+        return;
+    char *begin = m_buffer;
+    while (isspace((unsigned char)*begin))
+        begin++;
+    char *end = m_buffer + m_len - 1;
+    while (end >= begin && isspace((unsigned char)*end))
+        end--;
+    m_len = end + 1 - begin;
+    memmove(m_buffer, begin, m_len);
+    m_buffer[m_len] = 0;
+}
+
+long String::toInt() const
+{
+    return m_buffer ? atol(m_buffer) : 0;
+}
+
+String operator+(const String &lhs, const String &rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, const char *rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const char *lhs, const String &rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, char rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, int rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, unsigned int rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, long rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, unsigned long rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
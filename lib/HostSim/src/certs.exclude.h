@@ -0,0 +1,5 @@
+#pragma once
+
+// The host build never opens a real TLS session, so no CERTS are defined and
+// main.cpp skips the trust anchor setup. A real certs.exclude.h in include/
+// takes precedence over this one.
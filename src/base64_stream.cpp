@@ -0,0 +1,223 @@
+#include "base64_stream.h"
+
+// decode table values that are not sextets
+#define BASE64_SKIP 0x40
+#define BASE64_PAD 0x41
+#define BASE64_BAD 0xFF
+
+static const char alphabet[64] PROGMEM = {
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+    'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+    'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'};
+
+#define X BASE64_BAD
+#define S BASE64_SKIP
+static const uint8_t sextets[256] PROGMEM = {
+    X, X, X, X, X, X, X, X, X, S, S, X, X, S, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    S, X, X, X, X, X, X, X, X, X, X, 62, X, X, X, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, X, X, X, BASE64_PAD, X, X,
+    X, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, X, X, X, X, X,
+    X, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X};
+#undef X
+#undef S
+
+static inline uint8_t sextet(char c)
+{
+    return pgm_read_byte(&sextets[(uint8_t)c]);
+}
+
+static inline char *quad(char *out, uint8_t a, uint8_t b, uint8_t c)
+{
+    uint32_t v = (uint32_t)a << 16 | b << 8 | c;
+    out[0] = pgm_read_byte(&alphabet[v >> 18]);
+    out[1] = pgm_read_byte(&alphabet[(v >> 12) & 0x3F]);
+    out[2] = pgm_read_byte(&alphabet[(v >> 6) & 0x3F]);
+    out[3] = pgm_read_byte(&alphabet[v & 0x3F]);
+    return out + 4;
+}
+
+Base64Encoder::Base64Encoder(Print *out) : m_out(out),
+    m_group(),
+    m_pending(0)
+{
+}
+
+size_t Base64Encoder::encode(const uint8_t *in, size_t length, char *out)
+{
+    char *p = out;
+    // a group begun in the last call
+    while (m_pending && length)
+    {
+        m_group[m_pending++] = *in++;
+        --length;
+        if (m_pending == 3)
+        {
+            p = quad(p, m_group[0], m_group[1], m_group[2]);
+            m_pending = 0;
+        }
+    }
+    for (; length >= 3; length -= 3, in += 3)
+        p = quad(p, in[0], in[1], in[2]);
+    while (length--)
+        m_group[m_pending++] = *in++;
+    return p - out;
+}
+
+size_t Base64Encoder::finish(char *out)
+{
+    if (!m_pending)
+        return 0;
+    uint8_t pending = m_pending;
+    quad(out, m_group[0], pending > 1 ? m_group[1] : 0, 0);
+    out[3] = '=';
+    if (pending == 1)
+        out[2] = '=';
+    m_pending = 0;
+    return 4;
+}
+
+size_t Base64Encoder::write(const uint8_t *buffer, size_t size)
+{
+    // two bytes carried in can make one more group
+    char text[(BASE64_CHUNK_SIZE + 2) / 3 * 4];
+    for (size_t done = 0; done < size;)
+    {
+        size_t n = min(size - done, (size_t)BASE64_CHUNK_SIZE);
+        size_t length = encode(buffer + done, n, text);
+        if (m_out->write((const uint8_t *)text, length) != length)
+            return done;
+        done += n;
+    }
+    return size;
+}
+
+bool Base64Encoder::finish()
+{
+    char text[4];
+    size_t length = finish(text);
+    return m_out->write((const uint8_t *)text, length) == length;
+}
+
+Base64Decoder::Base64Decoder(Print *out) : m_out(out),
+    m_bits(0),
+    m_count(0),
+    m_padded(false),
+    m_error(false),
+    m_finished(false)
+{
+}
+
+// the bytes of a group cut short by padding or the end
+uint8_t *Base64Decoder::tail(uint8_t *out)
+{
+    if (m_count == 1)
+        m_error = true;
+    if (m_count >= 2)
+        *out++ = m_bits >> (m_count == 2 ? 4 : 10);
+    if (m_count == 3)
+        *out++ = m_bits >> 2;
+    m_bits = 0;
+    m_count = 0;
+    return out;
+}
+
+size_t Base64Decoder::decode(const char *in, size_t length, uint8_t *out)
+{
+    if (m_finished)
+    {
+        m_finished = false;
+        m_error = false;
+    }
+    uint8_t *p = out;
+    const char *end = in + length;
+    while (in < end && !m_error)
+    {
+        // four characters at a time while no group is open
+        if (!m_count && !m_padded && end - in >= 4)
+        {
+            uint8_t a = sextet(in[0]), b = sextet(in[1]), c = sextet(in[2]), d = sextet(in[3]);
+            if ((a | b | c | d) < 64)
+            {
+                uint32_t v = (uint32_t)a << 18 | (uint32_t)b << 12 | c << 6 | d;
+                p[0] = v >> 16;
+                p[1] = v >> 8;
+                p[2] = v;
+                p += 3;
+                in += 4;
+                continue;
+            }
+        }
+
+        uint8_t v = sextet(*in++);
+        if (v == BASE64_SKIP)
+            continue;
+        if (v == BASE64_PAD)
+        {
+            if (!m_padded)
+                p = tail(p);
+            m_padded = true;
+        }
+        else if (v < 64 && !m_padded)
+        {
+            m_bits = m_bits << 6 | v;
+            if (++m_count < 4)
+                continue;
+            p[0] = m_bits >> 16;
+            p[1] = m_bits >> 8;
+            p[2] = m_bits;
+            p += 3;
+            m_bits = 0;
+            m_count = 0;
+        }
+        else
+        {
+            m_error = true;
+        }
+    }
+    return p - out;
+}
+
+size_t Base64Decoder::finish(uint8_t *out)
+{
+    uint8_t *p = m_error ? out : tail(out);
+    m_bits = 0;
+    m_count = 0;
+    m_padded = false;
+    m_finished = true;
+    return p - out;
+}
+
+size_t Base64Decoder::write(const uint8_t *buffer, size_t size)
+{
+    uint8_t data[BASE64_CHUNK_SIZE];
+    for (size_t done = 0; done < size;)
+    {
+        // a group left open holds at most three characters, so 64 in
+        // make at most 48 out
+        size_t n = min(size - done, (size_t)(BASE64_CHUNK_SIZE / 3 * 4));
+        size_t length = decode((const char *)buffer + done, n, data);
+        if (m_error || m_out->write(data, length) != length)
+            return done;
+        done += n;
+    }
+    return size;
+}
+
+bool Base64Decoder::finish()
+{
+    uint8_t data[2];
+    size_t length = finish(data);
+    return m_out->write(data, length) == length && !m_error;
+}
@@ -0,0 +1,62 @@
+#include "boot_timer.h"
+
+static const char *const PHASE_NAMES[BootTimer::PhaseCount] = {
+    "setup", "config", "display", "touchcal", "delay", "tls", "mqttsetup", "setupdone",
+    "wifi", "mqtt", "firstmsg"};
+
+uint32_t BootTimer::s_marks[PhaseCount];
+
+void BootTimer::mark(Phase phase)
+{
+    if (s_marks[phase] != 0)
+        return;
+    uint32_t now = micros();
+    // 0 means not reached
+    s_marks[phase] = now ? now : 1;
+}
+
+uint32_t BootTimer::took(uint8_t phase)
+{
+    // time since the last milestone before it that was reached
+    for (int8_t before = phase - 1; before >= 0; --before)
+    {
+        if (s_marks[before])
+            return s_marks[phase] - s_marks[before];
+    }
+    return s_marks[phase];
+}
+
+void BootTimer::print(Print &out)
+{
+    out.println("boot timing, us since power-on (+ phase):");
+    for (uint8_t i = 0; i < PhaseCount; ++i)
+    {
+        if (!s_marks[i])
+            continue;
+        char line[48];
+        snprintf(line, sizeof(line), "  %-10s %10lu +%lu", PHASE_NAMES[i], (unsigned long)s_marks[i],
+                 (unsigned long)took(i));
+        out.println(line);
+    }
+}
+
+size_t BootTimer::format(char *buffer, size_t size)
+{
+    int used = snprintf(buffer, size, "fw=%s", FIRMWARE_VERSION);
+    for (uint8_t i = 0; i < PhaseCount && used > 0 && (size_t)used < size; ++i)
+    {
+        if (s_marks[i])
+            used += snprintf(buffer + used, size - used, " %s=%lu", PHASE_NAMES[i], (unsigned long)took(i));
+    }
+    for (int8_t i = PhaseCount - 1; i >= 0 && used > 0 && (size_t)used < size; --i)
+    {
+        if (s_marks[i])
+        {
+            used += snprintf(buffer + used, size - used, " total=%lu", (unsigned long)s_marks[i]);
+            break;
+        }
+    }
+    if (used < 0)
+        return 0;
+    return min((size_t)used, size - 1);
+}
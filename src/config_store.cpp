@@ -0,0 +1,131 @@
+#include "config_store.h"
+
+#include <FS.h>
+#include <stddef.h>
+
+#include "crc32.h"
+#define LOG_MODULE "config"
+#include "logger.h"
+
+ConfigStore::ConfigStore(void) : m_record()
+{
+    reset();
+}
+
+void ConfigStore::reset()
+{
+    memset(&m_record, 0, sizeof(m_record));
+    m_record.magic = CONFIG_MAGIC;
+    m_record.version = CONFIG_VERSION;
+}
+
+void ConfigStore::setCalibration(const uint16_t calData[5])
+{
+    memcpy(m_record.touchCal, calData, sizeof(m_record.touchCal));
+    m_record.flags |= HasCalibration;
+}
+
+void ConfigStore::setWifi(const char *ssid, const char *password)
+{
+    strncpy(m_record.ssid, ssid, CONFIG_SSID_LEN - 1);
+    m_record.ssid[CONFIG_SSID_LEN - 1] = 0;
+    strncpy(m_record.password, password, CONFIG_PASSWORD_LEN - 1);
+    m_record.password[CONFIG_PASSWORD_LEN - 1] = 0;
+    m_record.flags |= HasWifi;
+}
+
+bool ConfigStore::load(const char *path)
+{
+    File f = SPIFFS.open(path, "r");
+    if (!f)
+        return false;
+    ConfigRecord record;
+    bool ok = f.read((uint8_t *)&record, sizeof(record)) == sizeof(record) &&
+              record.magic == CONFIG_MAGIC && record.version == CONFIG_VERSION &&
+              record.crc == crc32((const uint8_t *)&record, offsetof(ConfigRecord, crc));
+    f.close();
+    if (ok)
+        m_record = record;
+    return ok;
+}
+
+bool ConfigStore::migrate()
+{
+    bool found = false;
+    File f = SPIFFS.open(LEGACY_CALIBRATION_FILE, "r");
+    if (f)
+    {
+        uint16_t calData[5];
+        if (f.readBytes((char *)calData, 14) == 14)
+        {
+            setCalibration(calData);
+            found = true;
+        }
+        f.close();
+    }
+
+    f = SPIFFS.open(LEGACY_WIFI_FILE, "r");
+    if (f)
+    {
+        String ssid = f.readStringUntil('\n');
+        String password = f.readString();
+        f.close();
+        setWifi(ssid.c_str(), password.c_str());
+        found = true;
+    }
+
+    if (found && save())
+    {
+        SPIFFS.remove(LEGACY_CALIBRATION_FILE);
+        SPIFFS.remove(LEGACY_WIFI_FILE);
+    }
+    return found;
+}
+
+bool ConfigStore::begin()
+{
+    if (!SPIFFS.begin())
+    {
+        LOG_WARN("formatting file system");
+        SPIFFS.format();
+        if (!SPIFFS.begin())
+            return false;
+    }
+
+    // a complete temporary record is newer than the main one: the reset came
+    // before its rename, so finish it
+    if (load(CONFIG_TMP_FILE))
+    {
+        SPIFFS.remove(CONFIG_FILE);
+        SPIFFS.rename(CONFIG_TMP_FILE, CONFIG_FILE);
+        return true;
+    }
+    SPIFFS.remove(CONFIG_TMP_FILE);
+    if (load(CONFIG_FILE))
+        return true;
+
+    reset();
+    if (migrate())
+        LOG_INFO("migrated from legacy files");
+    return true;
+}
+
+bool ConfigStore::save()
+{
+    m_record.crc = crc32((const uint8_t *)&m_record, offsetof(ConfigRecord, crc));
+
+    File f = SPIFFS.open(CONFIG_TMP_FILE, "w");
+    if (!f)
+        return false;
+    bool ok = f.write((const uint8_t *)&m_record, sizeof(m_record)) == sizeof(m_record);
+    f.close();
+    if (!ok)
+    {
+        SPIFFS.remove(CONFIG_TMP_FILE);
+        return false;
+    }
+
+    // SPIFFS will not rename over an existing file
+    SPIFFS.remove(CONFIG_FILE);
+    return SPIFFS.rename(CONFIG_TMP_FILE, CONFIG_FILE);
+}
@@ -0,0 +1,109 @@
+#include "hit_index.h"
+
+TFT_Hit_Index::TFT_Hit_Index(void) : m_rowCount(0),
+    m_cellCount(0),
+    m_hits{HIT_NONE, HIT_NONE, HIT_NONE}
+{
+}
+
+void TFT_Hit_Index::clear()
+{
+    m_rowCount = 0;
+    m_cellCount = 0;
+    m_hits[0] = m_hits[1] = m_hits[2] = HIT_NONE;
+}
+
+bool TFT_Hit_Index::add(uint8_t id, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    if (m_cellCount >= HIT_INDEX_MAX_WIDGETS || id == HIT_NONE)
+        return false;
+
+    uint8_t r = 0;
+    while (r < m_rowCount && (m_rows[r].y != y || m_rows[r].h != h))
+        ++r;
+
+    if (r == m_rowCount)
+    {
+        if (m_rowCount >= HIT_INDEX_MAX_ROWS)
+            return false;
+        // keep rows sorted by y, a new row starts at the end of the cells
+        r = 0;
+        while (r < m_rowCount && m_rows[r].y < y)
+            ++r;
+        for (uint8_t i = m_rowCount; i > r; --i)
+            m_rows[i] = m_rows[i - 1];
+        m_rows[r] = {y, h, m_cellCount, 0};
+        ++m_rowCount;
+    }
+
+    // insert the cell into its row, sorted by x, shifting later rows along
+    Row &row = m_rows[r];
+    uint8_t pos = row.first;
+    while (pos < row.first + row.count && m_cells[pos].x < x)
+        ++pos;
+    for (uint8_t i = m_cellCount; i > pos; --i)
+        m_cells[i] = m_cells[i - 1];
+    m_cells[pos] = {x, w, id};
+    ++m_cellCount;
+    ++row.count;
+    for (uint8_t i = 0; i < m_rowCount; ++i)
+    {
+        if (i != r && m_rows[i].first >= pos && m_rows[i].count)
+            ++m_rows[i].first;
+    }
+    return true;
+}
+
+uint8_t TFT_Hit_Index::find(int16_t x, int16_t y) const
+{
+    for (uint8_t r = 0; r < m_rowCount; ++r)
+    {
+        const Row &row = m_rows[r];
+        if (y < row.y)
+            break;
+        if (y >= row.y + row.h)
+            continue;
+
+        // last cell starting at or before x
+        int16_t lo = row.first, hi = row.first + row.count - 1, best = -1;
+        while (lo <= hi)
+        {
+            int16_t mid = (lo + hi) / 2;
+            if (m_cells[mid].x <= x)
+            {
+                best = mid;
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid - 1;
+            }
+        }
+        if (best >= 0 && x < m_cells[best].x + m_cells[best].w)
+            return m_cells[best].id;
+    }
+    return HIT_NONE;
+}
+
+uint8_t TFT_Hit_Index::update(bool touched, int16_t x, int16_t y, uint8_t changed[3])
+{
+    m_hits[2] = m_hits[1];
+    m_hits[1] = m_hits[0];
+    m_hits[0] = touched ? find(x, y) : HIT_NONE;
+
+    // a widget needs press() while it is touched, on the sample it is let go
+    // (justReleased) and on the one after, to clear justReleased again
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        uint8_t id = m_hits[i];
+        if (id == HIT_NONE)
+            continue;
+        bool seen = false;
+        for (uint8_t j = 0; j < count; ++j)
+            seen |= changed[j] == id;
+        if (!seen)
+            changed[count++] = id;
+    }
+    return count;
+}
@@ -0,0 +1,181 @@
+#include "image_decoder.h"
+
+ImageDecoder::ImageDecoder(void) : m_tft(nullptr),
+    m_left(0),
+    m_top(0),
+    m_state(Failed),
+    m_header(),
+    m_got(0),
+    m_palettized(false),
+    m_colours(0),
+    m_width(0),
+    m_height(0),
+    m_x(0),
+    m_y(0),
+    m_count(0),
+    m_half(false),
+    m_low(0),
+    m_palette(),
+    m_line()
+{
+}
+
+void ImageDecoder::begin(TFT_eSPI *gfx, int16_t x, int16_t y)
+{
+    m_tft = gfx;
+    m_left = x;
+    m_top = y;
+    m_state = Header;
+    m_got = 0;
+    m_width = 0;
+    m_height = 0;
+    m_x = 0;
+    m_y = 0;
+    m_half = false;
+}
+
+bool ImageDecoder::readHeader()
+{
+    if (m_header[0] != IMAGE_MAGIC || m_header[1] != IMAGE_VERSION || m_header[2] > IMAGE_PALETTE)
+        return false;
+    m_palettized = m_header[2] == IMAGE_PALETTE;
+    m_colours = m_palettized ? m_header[3] + 1 : 0;
+    m_width = m_header[4] | m_header[5] << 8;
+    m_height = m_header[6] | m_header[7] << 8;
+    return m_width && m_width <= IMAGE_MAX_WIDTH && m_height;
+}
+
+// false until the whole pixel is in
+bool ImageDecoder::pixel(const uint8_t *&data, const uint8_t *end, uint16_t &colour)
+{
+    if (m_palettized)
+    {
+        colour = m_palette[*data++];
+        return true;
+    }
+    if (!m_half)
+    {
+        m_low = *data++;
+        m_half = true;
+        if (data == end)
+            return false;
+    }
+    colour = m_low | *data++ << 8;
+    m_half = false;
+    return true;
+}
+
+void ImageDecoder::endPacket()
+{
+    m_state = Control;
+    if (m_x < m_width)
+        return;
+    pushRow();
+    m_x = 0;
+    if (++m_y == m_height)
+        m_state = Done;
+}
+
+void ImageDecoder::pushRow()
+{
+    int16_t y = m_top + m_y;
+    int16_t w = min((int32_t)m_width, m_tft->width() - m_left);
+    if (y < 0 || y >= m_tft->height() || m_left < 0 || w <= 0)
+        return;
+    m_tft->startWrite();
+    m_tft->setAddrWindow(m_left, y, w, 1);
+    m_tft->pushColors(m_line, w, true);
+    m_tft->endWrite();
+}
+
+size_t ImageDecoder::write(const uint8_t *buffer, size_t size)
+{
+    const uint8_t *data = buffer;
+    const uint8_t *end = buffer + size;
+    while (data < end)
+    {
+        switch (m_state)
+        {
+        case Header:
+            m_header[m_got++] = *data++;
+            if (m_got < IMAGE_HEADER_SIZE)
+                break;
+            if (!readHeader())
+            {
+                m_state = Failed;
+                break;
+            }
+            m_got = 0;
+            m_state = m_colours ? Palette : Control;
+            break;
+
+        case Palette:
+            if (m_got & 1)
+                m_palette[m_got / 2] |= *data++ << 8;
+            else
+                m_palette[m_got / 2] = *data++;
+            if (++m_got == m_colours * 2)
+                m_state = Control;
+            break;
+
+        case Control:
+        {
+            uint8_t c = *data++;
+            m_count = c < 128 ? c + 1 : c - 127;
+            m_state = c < 128 ? Literal : Repeat;
+            if (m_x + m_count > m_width)
+                m_state = Failed;
+            break;
+        }
+
+        case Literal:
+            // a palette row goes straight through the table
+            if (m_palettized)
+            {
+                uint8_t n = min((size_t)m_count, (size_t)(end - data));
+                for (uint8_t i = 0; i < n; ++i)
+                    m_line[m_x++] = m_palette[*data++];
+                m_count -= n;
+            }
+            else
+            {
+                if (m_half)
+                {
+                    m_line[m_x++] = m_low | *data++ << 8;
+                    m_half = false;
+                    --m_count;
+                }
+                uint8_t n = min((size_t)m_count, (size_t)(end - data) / 2);
+                for (uint8_t i = 0; i < n; ++i, data += 2)
+                    m_line[m_x++] = data[0] | data[1] << 8;
+                m_count -= n;
+                // a pixel split between two writes
+                if (m_count && data < end)
+                {
+                    m_low = *data++;
+                    m_half = true;
+                }
+            }
+            if (!m_count)
+                endPacket();
+            break;
+
+        case Repeat:
+        {
+            uint16_t colour;
+            if (!pixel(data, end, colour))
+                break;
+            for (uint16_t *p = m_line + m_x, *last = p + m_count; p < last; ++p)
+                *p = colour;
+            m_x += m_count;
+            endPacket();
+            break;
+        }
+
+        case Done:
+        case Failed:
+            return data - buffer;
+        }
+    }
+    return data - buffer;
+}
@@ -0,0 +1,594 @@
+#include "keyboard.h"
+
+#include <FS.h>
+
+#define KEYBOARD_CACHE_MAGIC 0x3144424B // "KBD1"
+
+struct KeyboardCacheHeader
+{
+    uint32_t magic;
+    uint32_t hash;
+    int16_t x, y;
+    uint16_t w, h;
+};
+
+TFT_Keyboard::TFT_Keyboard(void) : m_shown(),
+    m_drawn(false),
+    m_useCache(true),
+    m_layout(nullptr),
+    m_geometry(),
+    m_drawnGeometry(),
+    m_capsLock(false),
+    m_shiftPressed(false),
+    m_staleKeys(0),
+    m_pressedKeys(0)
+{
+}
+
+void TFT_Keyboard::init(TFT_eSPI *gfx)
+{
+    m_tft = gfx;
+    m_drawn = false;
+    m_staleKeys = 0;
+    m_pressedKeys = 0;
+    int16_t x, y;
+    uint16_t w, h;
+    region(x, y, w, h);
+    setBounds(x, y, w, h);
+}
+
+void TFT_Keyboard::useLayout(const KeyboardLayout *layout)
+{
+    if (layout == m_layout)
+        return;
+    m_layout = layout;
+    KeyboardGeometry next;
+    geometry(layout, next);
+    if (memcmp(&next, &m_geometry, sizeof(next)) == 0)
+        return;
+
+    // the keys move, what was behind the old ones has to be repainted
+    m_geometry = next;
+    int16_t x, y;
+    uint16_t w, h;
+    region(x, y, w, h);
+    setBounds(x, y, w, h);
+}
+
+void TFT_Keyboard::setLayout(const KeyboardLayout *layout, bool capsLock, bool shiftPressed)
+{
+    useLayout(layout);
+    m_capsLock = capsLock;
+    m_shiftPressed = shiftPressed;
+    changed();
+}
+
+void TFT_Keyboard::invalidateKey(uint8_t i)
+{
+    m_pressedKeys |= (uint64_t)1 << i;
+    changed();
+}
+
+bool TFT_Keyboard::hasKey(uint8_t i)
+{
+    if (!m_layout)
+        return false;
+    char label[KEYBOARD_LABEL_LEN];
+    keyLabel(m_layout, i, false, false, label);
+    return label[0] != 0;
+}
+
+void TFT_Keyboard::paint(const TFT_Rect &clip)
+{
+    // the screen has cleared all of it
+    if (clip.covers(m_bounds))
+    {
+        m_drawn = false;
+        m_drawnGeometry = m_geometry;
+        update();
+        return;
+    }
+    for (uint8_t i = 0; i < KEYBOARD_KEYS; ++i)
+    {
+        TFT_Rect key;
+        uint16_t w, h;
+        keyRect(i, key.x, key.y, w, h);
+        key.w = w;
+        key.h = h;
+        if (key.intersects(clip))
+            m_staleKeys |= (uint64_t)1 << i;
+    }
+    update();
+}
+
+void TFT_Keyboard::update()
+{
+    if (m_layout)
+        draw(m_layout, m_capsLock, m_shiftPressed);
+    if (!m_drawn)
+        return;
+
+    // keys the layout left alone only need their press state
+    for (uint64_t keys = m_pressedKeys; keys; keys &= keys - 1)
+    {
+        uint8_t i = __builtin_ctzll(keys);
+        if (m_shown[i][0])
+            m_keys[i].drawButton(m_keys[i].isPressed());
+    }
+    m_pressedKeys = 0;
+}
+
+void TFT_Keyboard::keyLabel(const KeyboardLayout *layout, uint8_t i,
+                            bool capsLock, bool shiftPressed, char label[KEYBOARD_LABEL_LEN])
+{
+    label[0] = 0;
+    if (i >= KEYBOARD_KEYS)
+        return;
+    memcpy_P(label, layout->labels[i], KEYBOARD_LABEL_LEN);
+    label[KEYBOARD_LABEL_LEN - 1] = 0;
+    if (i < FirstCharKey || !(pgm_read_byte(&layout->flags) & KEYBOARD_LETTERS))
+        return;
+
+    char key = label[0];
+    if (capsLock)
+        key = toupper(key);
+
+    if (shiftPressed)
+    {
+        if (isupper(key))
+            key = tolower(key);
+        else
+            key = toupper(key);
+    }
+    label[0] = key;
+}
+
+void TFT_Keyboard::geometry(const KeyboardLayout *layout, KeyboardGeometry &geometry)
+{
+    memcpy_P(&geometry, &layout->geometry, sizeof(geometry));
+}
+
+void TFT_Keyboard::keyRect(const KeyboardGeometry &geometry, uint8_t i, int16_t &x, int16_t &y, uint16_t &w, uint16_t &h)
+{
+    uint8_t row = 0, first = 0;
+    while (row + 1 < geometry.rows && i >= first + geometry.row[row].keys)
+        first += geometry.row[row++].keys;
+
+    const KeyboardRow &r = geometry.row[row];
+    x = r.x + r.pitch * (i - first);
+    y = geometry.y + geometry.rowPitch * row;
+    w = r.w;
+    h = geometry.h;
+}
+
+void TFT_Keyboard::region(const KeyboardGeometry &geometry, int16_t &x, int16_t &y, uint16_t &w, uint16_t &h)
+{
+    uint8_t keys = 0;
+    for (uint8_t r = 0; r < geometry.rows; ++r)
+        keys += geometry.row[r].keys;
+
+    int16_t left = INT16_MAX, top = INT16_MAX, right = 0, bottom = 0;
+    for (uint8_t i = 0; i < keys; ++i)
+    {
+        int16_t kx, ky;
+        uint16_t kw, kh;
+        keyRect(geometry, i, kx, ky, kw, kh);
+        left = min(left, kx);
+        top = min(top, ky);
+        right = max(right, (int16_t)(kx + kw));
+        bottom = max(bottom, (int16_t)(ky + kh));
+    }
+    if (!keys)
+        left = top = 0;
+    x = left;
+    y = top;
+    w = right - left;
+    h = bottom - top;
+}
+
+void TFT_Keyboard::initKey(uint8_t i, TFT_eSPI *gfx, char *label, int16_t dx, int16_t dy)
+{
+    int16_t x, y;
+    uint16_t w, h;
+    keyRect(i, x, y, w, h);
+    if (i < FirstCharKey)
+        m_keys[i].initButtonUL(gfx, x - dx, y - dy, w, h, TFT_WHITE, TFT_BLUE, TFT_WHITE, label, 1);
+    else
+        m_keys[i].initButtonUL(gfx, x - dx, y - dy, w, h, TFT_WHITE, TFT_LIGHTGREY, TFT_BLACK, label, 1);
+}
+
+static uint32_t layoutHash(char labels[KEYBOARD_KEYS][KEYBOARD_LABEL_LEN], const KeyboardGeometry &geometry, uint8_t font)
+{
+    // FNV-1a over where the keys are, every label and the font they are drawn in
+    uint32_t hash = 2166136261u ^ font;
+    for (uint8_t i = 0; i < sizeof(geometry); ++i)
+        hash = (hash ^ ((const uint8_t *)&geometry)[i]) * 16777619u;
+    for (uint8_t i = 0; i < KEYBOARD_KEYS; ++i)
+    {
+        for (const char *c = labels[i];; ++c)
+        {
+            hash = (hash ^ (uint8_t)*c) * 16777619u;
+            if (!*c)
+                break;
+        }
+    }
+    return hash;
+}
+
+// the hash of any bitmap one of layouts can need, with Caps and Shift in
+// every combination for a letters layout
+static bool currentLayout(uint32_t hash, const KeyboardLayout *const layouts[], uint8_t count, uint8_t font)
+{
+    for (uint8_t l = 0; l < count; ++l)
+    {
+        KeyboardGeometry geometry;
+        TFT_Keyboard::geometry(layouts[l], geometry);
+        uint8_t variants = pgm_read_byte(&layouts[l]->flags) & KEYBOARD_LETTERS ? 4 : 1;
+        for (uint8_t v = 0; v < variants; ++v)
+        {
+            char labels[KEYBOARD_KEYS][KEYBOARD_LABEL_LEN];
+            for (uint8_t i = 0; i < KEYBOARD_KEYS; ++i)
+                TFT_Keyboard::keyLabel(layouts[l], i, v & 1, v & 2, labels[i]);
+            if (layoutHash(labels, geometry, font) == hash)
+                return true;
+        }
+    }
+    return false;
+}
+
+void TFT_Keyboard::begin(TFT_eSPI *gfx, const KeyboardLayout *const layouts[], uint8_t count)
+{
+    init(gfx);
+    Dir dir = SPIFFS.openDir("/kb");
+    while (dir.next())
+    {
+        String path = dir.fileName();
+        char *end;
+        uint32_t hash = strtoul(path.c_str() + 3, &end, 16);
+        if (path.length() != 11 || *end || currentLayout(hash, layouts, count, m_tft->textfont))
+            continue;
+        SPIFFS.remove(path);
+    }
+}
+
+bool TFT_Keyboard::renderCache(char labels[KEYBOARD_KEYS][KEYBOARD_LABEL_LEN], const char *path)
+{
+    KeyboardCacheHeader header;
+    header.magic = KEYBOARD_CACHE_MAGIC;
+    header.hash = layoutHash(labels, m_geometry, m_tft->textfont);
+    region(header.x, header.y, header.w, header.h);
+
+    TFT_eSprite strip(m_tft);
+    if (!strip.createSprite(header.w, KEYBOARD_STRIP_ROWS))
+        return false;
+    strip.setTextFont(m_tft->textfont);
+
+    File f = SPIFFS.open(path, "w");
+    if (!f)
+        return false;
+    bool ok = f.write((const uint8_t *)&header, sizeof(header)) == sizeof(header);
+
+    // runs of one colour, allowed to continue from one row into the next
+    uint8_t out[96];
+    uint8_t used = 0;
+    uint16_t colour = 0;
+    uint8_t count = 0;
+    for (uint16_t top = 0; top < header.h && ok; top += KEYBOARD_STRIP_ROWS)
+    {
+        uint16_t rows = min((uint16_t)KEYBOARD_STRIP_ROWS, (uint16_t)(header.h - top));
+        strip.fillSprite(KEYBOARD_BACKGROUND);
+        for (uint8_t i = 0; i < KEYBOARD_KEYS; ++i)
+        {
+            int16_t x, y;
+            uint16_t w, h;
+            keyRect(i, x, y, w, h);
+            if (!labels[i][0] || y + h <= header.y + top || y >= header.y + top + rows)
+                continue;
+            initKey(i, &strip, labels[i], header.x, header.y + top);
+            m_keys[i].drawButton();
+        }
+
+        for (uint16_t j = 0; j < rows && ok; ++j)
+        {
+            for (uint16_t i = 0; i < header.w; ++i)
+            {
+                uint16_t c = strip.readPixel(i, j);
+                if (count && (c != colour || count == 255))
+                {
+                    out[used++] = count;
+                    out[used++] = colour & 0xFF;
+                    out[used++] = colour >> 8;
+                    count = 0;
+                    if (used == sizeof(out))
+                    {
+                        ok = f.write(out, used) == used;
+                        used = 0;
+                    }
+                }
+                colour = c;
+                ++count;
+            }
+        }
+    }
+    if (count)
+    {
+        out[used++] = count;
+        out[used++] = colour & 0xFF;
+        out[used++] = colour >> 8;
+    }
+    ok = ok && f.write(out, used) == used;
+    f.close();
+    if (!ok)
+        SPIFFS.remove(path);
+
+    // the keys drawn into the strip still point at it
+    for (uint8_t i = 0; i < KEYBOARD_KEYS; ++i)
+        initKey(i, m_tft, labels[i], 0, 0);
+    return ok;
+}
+
+bool TFT_Keyboard::openCache(char labels[KEYBOARD_KEYS][KEYBOARD_LABEL_LEN], File &f, KeyboardCacheHeader &header)
+{
+    uint32_t hash = layoutHash(labels, m_geometry, m_tft->textfont);
+    char path[16];
+    snprintf(path, sizeof(path), "/kb%08x", hash);
+
+    if (!SPIFFS.exists(path) && !renderCache(labels, path))
+        return false;
+
+    f = SPIFFS.open(path, "r");
+    if (!f)
+        return false;
+    if (f.read((uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+        header.magic != KEYBOARD_CACHE_MAGIC || header.hash != hash)
+    {
+        f.close();
+        SPIFFS.remove(path);
+        return false;
+    }
+    return true;
+}
+
+// the runs of a cached bitmap, or endless background without a file
+class KeyboardRuns
+{
+    public:
+    KeyboardRuns(File *file) : m_file(file), m_used(0), m_length(0), m_count(0), m_colour(KEYBOARD_BACKGROUND) {}
+
+    // false at the end of the file
+    bool fill()
+    {
+        if (m_count)
+            return true;
+        if (!m_file)
+        {
+            m_count = 255;
+            return true;
+        }
+        if (m_used + 3 > m_length)
+        {
+            int n = m_file->read(m_in, sizeof(m_in));
+            if (n < 3)
+                return false;
+            m_length = n;
+            m_used = 0;
+        }
+        m_count = m_in[m_used];
+        m_colour = m_in[m_used + 1] | (m_in[m_used + 2] << 8);
+        m_used += 3;
+        return true;
+    }
+
+    uint8_t count() { return m_count; }
+    uint16_t colour() { return m_colour; }
+    void skip(uint8_t n) { m_count -= n; }
+
+    private:
+    File *m_file;
+    uint8_t m_in[96];
+    uint8_t m_used, m_length;
+    uint8_t m_count;
+    uint16_t m_colour;
+};
+
+// runs of one row sent as one window, ending at the last that differs
+class KeyboardSpan
+{
+    public:
+    KeyboardSpan(TFT_eSPI *tft) : m_tft(tft), m_segments(0), m_lastDiffers(0), m_windows(0) {}
+
+    void add(int16_t x, int16_t y, uint16_t count, uint16_t colour, bool differs)
+    {
+        if (!differs)
+        {
+            // a short gap costs less sent again than a new window
+            if (!m_segments || count > KEYBOARD_SPAN_PX || m_segments == KEYBOARD_SPAN_SEGMENTS)
+            {
+                flush();
+                return;
+            }
+        }
+        else if (m_segments == KEYBOARD_SPAN_SEGMENTS)
+        {
+            flush();
+        }
+        if (!m_segments)
+        {
+            m_x = x;
+            m_y = y;
+        }
+        m_segment[m_segments].count = count;
+        m_segment[m_segments].colour = colour;
+        ++m_segments;
+        if (differs)
+            m_lastDiffers = m_segments;
+    }
+
+    void flush()
+    {
+        if (m_lastDiffers)
+        {
+            uint16_t w = 0;
+            for (uint8_t i = 0; i < m_lastDiffers; ++i)
+                w += m_segment[i].count;
+            m_tft->setAddrWindow(m_x, m_y, w, 1);
+            for (uint8_t i = 0; i < m_lastDiffers; ++i)
+                m_tft->pushColor(m_segment[i].colour, m_segment[i].count);
+            ++m_windows;
+        }
+        m_segments = 0;
+        m_lastDiffers = 0;
+    }
+
+    uint32_t windows() { return m_windows; }
+
+    private:
+    struct Segment
+    {
+        uint16_t count;
+        uint16_t colour;
+    };
+
+    TFT_eSPI *m_tft;
+    int16_t m_x, m_y;
+    Segment m_segment[KEYBOARD_SPAN_SEGMENTS];
+    uint8_t m_segments, m_lastDiffers;
+    uint32_t m_windows;
+};
+
+bool TFT_Keyboard::blit(char labels[KEYBOARD_KEYS][KEYBOARD_LABEL_LEN], char from[KEYBOARD_KEYS][KEYBOARD_LABEL_LEN])
+{
+    File to, base;
+    KeyboardCacheHeader header, baseHeader;
+    if (!openCache(labels, to, header))
+        return false;
+    if (from && !openCache(from, base, baseHeader))
+    {
+        to.close();
+        return false;
+    }
+
+    // walk both bitmaps together and send only the pixels that differ
+    KeyboardRuns next(&to), shown(from ? &base : nullptr);
+    KeyboardSpan span(m_tft);
+    uint32_t total = (uint32_t)header.w * header.h;
+    uint32_t done = 0;
+    m_tft->startWrite();
+    while (done < total && next.fill() && shown.fill())
+    {
+        uint16_t column = done % header.w;
+        uint16_t n = min((uint16_t)min(next.count(), shown.count()), (uint16_t)(header.w - column));
+        span.add(header.x + column, header.y + done / header.w, n, next.colour(), next.colour() != shown.colour());
+        next.skip(n);
+        shown.skip(n);
+        done += n;
+        if (column + n == header.w)
+            span.flush();
+    }
+    span.flush();
+    m_tft->endWrite();
+    to.close();
+    if (from)
+        base.close();
+    // a short file leaves the region part painted, draw the keys over it
+    return done == total;
+}
+
+uint8_t TFT_Keyboard::draw(const KeyboardLayout *layout, bool capsLock, bool shiftPressed)
+{
+    useLayout(layout);
+    // keys elsewhere on the panel than in this layout go first
+    if (m_drawn && memcmp(&m_drawnGeometry, &m_geometry, sizeof(m_geometry)) != 0)
+    {
+        int16_t x, y;
+        uint16_t w, h;
+        region(m_drawnGeometry, x, y, w, h);
+        m_tft->fillRect(x, y, w, h, KEYBOARD_BACKGROUND);
+        m_drawn = false;
+    }
+    m_drawnGeometry = m_geometry;
+
+    char labels[KEYBOARD_KEYS][KEYBOARD_LABEL_LEN];
+    uint8_t changed = 0;
+    // what each way sends, in pixels, and the keys the bitmap cannot stand
+    // in for: damaged ones, and pressed ones, which it has up
+    uint32_t repaintPx = 0, blitPx = 0;
+    uint64_t redraw = m_pressedKeys | (m_drawn ? m_staleKeys : 0);
+    for (uint8_t i = 0; i < KEYBOARD_KEYS; ++i)
+    {
+        keyLabel(layout, i, capsLock, shiftPressed, labels[i]);
+        if (m_keys[i].isPressed())
+            redraw |= (uint64_t)1 << i;
+        if (m_drawn && !(m_staleKeys >> i & 1) && strcmp(labels[i], m_shown[i]) == 0)
+            continue;
+        ++changed;
+        // a key is drawn, a key that became a gap filled, a gap left alone
+        int16_t x, y;
+        uint16_t w, h;
+        keyRect(i, x, y, w, h);
+        uint32_t keyPx = 0;
+        if (labels[i][0])
+            keyPx = (uint32_t)w * h + KEYBOARD_KEY_OVERHEAD_PX;
+        else if (m_drawn && m_shown[i][0])
+            keyPx = (uint32_t)w * h;
+        repaintPx += keyPx;
+        // at worst every pixel of the key differs, a window a row
+        if (keyPx)
+            blitPx += (redraw >> i & 1) ? keyPx : (uint32_t)w * h + h * KEYBOARD_SPAN_PX;
+    }
+
+    if (m_useCache && blitPx < repaintPx && blit(labels, m_drawn ? m_shown : nullptr))
+    {
+        for (uint8_t i = 0; i < KEYBOARD_KEYS; ++i)
+        {
+            initKey(i, m_tft, labels[i], 0, 0);
+            strcpy(m_shown[i], labels[i]);
+            if (!(redraw >> i & 1))
+                continue;
+            if (labels[i][0])
+            {
+                m_keys[i].drawButton(m_keys[i].isPressed());
+            }
+            else
+            {
+                int16_t x, y;
+                uint16_t w, h;
+                keyRect(i, x, y, w, h);
+                m_tft->fillRect(x, y, w, h, KEYBOARD_BACKGROUND);
+            }
+        }
+        m_drawn = true;
+        m_staleKeys = 0;
+        m_pressedKeys = 0;
+        return changed;
+    }
+
+    uint8_t repainted = 0;
+    for (uint8_t i = 0; i < KEYBOARD_KEYS; ++i)
+    {
+        uint64_t bit = (uint64_t)1 << i;
+        if (m_drawn && !(m_staleKeys & bit) && strcmp(labels[i], m_shown[i]) == 0)
+            continue;
+
+        initKey(i, m_tft, labels[i], 0, 0);
+        if (labels[i][0])
+        {
+            m_keys[i].drawButton(m_keys[i].isPressed());
+            ++repainted;
+        }
+        else if (m_drawn && m_shown[i][0])
+        {
+            // a key that became a gap
+            int16_t x, y;
+            uint16_t w, h;
+            keyRect(i, x, y, w, h);
+            m_tft->fillRect(x, y, w, h, KEYBOARD_BACKGROUND);
+            ++repainted;
+        }
+        strcpy(m_shown[i], labels[i]);
+        m_staleKeys &= ~bit;
+        m_pressedKeys &= ~bit;
+    }
+    m_drawn = true;
+    return repainted;
+}
@@ -0,0 +1,90 @@
+#include "keyboard_layout.h"
+
+// the control keys, then 10 digits and three rows of letters, 35 px keys on
+// a 40 px pitch; the same geometry for every language
+#define KEYBOARD_CONTROL_ROW {6, 0, 45, 40}
+#define KEYBOARD_KEY_ROW(n) {n, 43, 40, 35}
+#define KEYBOARD_TOP 168
+#define KEYBOARD_TEXT_GEOMETRY(a, b, c)                                           \
+    {                                                                             \
+        5, KEYBOARD_TOP, 30, 25,                                                  \
+        {                                                                         \
+            KEYBOARD_CONTROL_ROW, KEYBOARD_KEY_ROW(10), KEYBOARD_KEY_ROW(a),      \
+                KEYBOARD_KEY_ROW(b), KEYBOARD_KEY_ROW(c)                          \
+        }                                                                         \
+    }
+#define KEYBOARD_CONTROL_KEYS(sym) "OK", "Clear", "Del", "Shift", "Caps", sym
+
+constexpr KeyboardLayout keyboardQwerty PROGMEM = {
+    "qwerty", KEYBOARD_LETTERS, KEYBOARD_TEXT_GEOMETRY(10, 9, 7),
+    {KEYBOARD_CONTROL_KEYS("Sym"),
+     "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+     "q", "w", "e", "r", "t", "y", "u", "i", "o", "p",
+     "a", "s", "d", "f", "g", "h", "j", "k", "l",
+     "z", "x", "c", "v", "b", "n", "m"}};
+
+constexpr KeyboardLayout keyboardAzerty PROGMEM = {
+    "azerty", KEYBOARD_LETTERS, KEYBOARD_TEXT_GEOMETRY(10, 10, 6),
+    {KEYBOARD_CONTROL_KEYS("Sym"),
+     "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+     "a", "z", "e", "r", "t", "y", "u", "i", "o", "p",
+     "q", "s", "d", "f", "g", "h", "j", "k", "l", "m",
+     "w", "x", "c", "v", "b", "n"}};
+
+constexpr KeyboardLayout keyboardQwertz PROGMEM = {
+    "qwertz", KEYBOARD_LETTERS, KEYBOARD_TEXT_GEOMETRY(10, 9, 7),
+    {KEYBOARD_CONTROL_KEYS("Sym"),
+     "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+     "q", "w", "e", "r", "t", "z", "u", "i", "o", "p",
+     "a", "s", "d", "f", "g", "h", "j", "k", "l",
+     "y", "x", "c", "v", "b", "n", "m"}};
+
+// the letters' geometry with four gaps, so Sym only repaints labels
+constexpr KeyboardLayout keyboardSymbols PROGMEM = {
+    "symbols", 0, KEYBOARD_TEXT_GEOMETRY(10, 9, 7),
+    {KEYBOARD_CONTROL_KEYS("123"),
+     "`", "!", "\"", "$", "%", "^", "&", "*", "(", ")",
+     "_", "-", "+", "=", "{", "[", "}", "]", ";", ":",
+     "'", "@", "#", "~", ",", "<", ".", ">", "/",
+     "?", "|", "\\", "", "", "", ""}};
+
+// three 60 px keys a row, centred under the control keys, no case keys
+constexpr KeyboardLayout keyboardNumeric PROGMEM = {
+    "numeric", 0,
+    {5, KEYBOARD_TOP, 30, 25, {KEYBOARD_CONTROL_ROW, {3, 145, 65, 60}, {3, 145, 65, 60}, {3, 145, 65, 60}, {3, 145, 65, 60}}},
+    {"OK", "Clear", "Del", "", "", "abc",
+     "7", "8", "9",
+     "4", "5", "6",
+     "1", "2", "3",
+     "-", "0", "."}};
+
+// checked here rather than on the device
+constexpr KeyboardRow controlRow = KEYBOARD_CONTROL_ROW;
+
+constexpr uint8_t layoutKeys(const KeyboardGeometry &g, uint8_t row)
+{
+    return row >= g.rows ? 0 : g.row[row].keys + layoutKeys(g, row + 1);
+}
+
+constexpr bool controlRowMatches(const KeyboardGeometry &g)
+{
+    return g.y == KEYBOARD_TOP && g.row[0].keys == controlRow.keys && g.row[0].x == controlRow.x &&
+           g.row[0].pitch == controlRow.pitch && g.row[0].w == controlRow.w;
+}
+
+constexpr bool gapsFrom(const KeyboardLayout &layout, uint8_t i)
+{
+    return i >= KEYBOARD_KEYS || (layout.labels[i][0] == 0 && gapsFrom(layout, i + 1));
+}
+
+#define KEYBOARD_CHECK(layout)                                                               \
+    static_assert(layout.geometry.rows <= KEYBOARD_MAX_ROWS, #layout " has too many rows");  \
+    static_assert(layoutKeys(layout.geometry, 0) <= KEYBOARD_KEYS, #layout " has too many keys"); \
+    static_assert(gapsFrom(layout, layoutKeys(layout.geometry, 0)), #layout " has labels past its keys"); \
+    static_assert(controlRowMatches(layout.geometry), #layout " moves the control keys")
+
+KEYBOARD_CHECK(keyboardQwerty);
+KEYBOARD_CHECK(keyboardAzerty);
+KEYBOARD_CHECK(keyboardQwertz);
+KEYBOARD_CHECK(keyboardSymbols);
+KEYBOARD_CHECK(keyboardNumeric);
@@ -0,0 +1,52 @@
+#include "label.h"
+
+TFT_Label::TFT_Label(void) : m_text(),
+    m_textcolor(TFT_WHITE),
+    m_fillcolor(TFT_BLACK),
+    m_font(1),
+    m_datum(TL_DATUM)
+{
+    m_opaque = true;
+}
+
+void TFT_Label::init(TFT_eSPI *gfx, int16_t x, int16_t y, int16_t w, int16_t h,
+                     uint16_t textcolor, uint16_t fill, uint8_t font, uint8_t datum)
+{
+    m_tft = gfx;
+    m_textcolor = textcolor;
+    m_fillcolor = fill;
+    m_font = font;
+    m_datum = datum;
+    setBounds(x, y, w, h);
+}
+
+void TFT_Label::setText(const char *text)
+{
+    if (strncmp(text, m_text, LABEL_CAPACITY) == 0)
+        return;
+    strncpy(m_text, text, LABEL_CAPACITY);
+    m_text[LABEL_CAPACITY] = 0;
+    invalidate();
+}
+
+void TFT_Label::paint(const TFT_Rect &clip)
+{
+    m_tft->fillRect(clip.x, clip.y, clip.w, clip.h, m_fillcolor);
+    if (!m_text[0])
+        return;
+
+    m_tft->setTextSize(1);
+    m_tft->setTextColor(m_textcolor, m_fillcolor);
+    uint8_t tempdatum = m_tft->getTextDatum();
+    m_tft->setTextDatum(m_datum);
+    uint16_t tempPadding = m_tft->padX;
+    m_tft->setTextPadding(0);
+
+    // the nine datums step through left/centre/right, then top/middle/bottom
+    int16_t x = m_bounds.x + (m_datum % 3) * m_bounds.w / 2;
+    int16_t y = m_bounds.y + (m_datum / 3) * m_bounds.h / 2;
+    m_tft->drawString(m_text, x, y, m_font);
+
+    m_tft->setTextDatum(tempdatum);
+    m_tft->setTextPadding(tempPadding);
+}
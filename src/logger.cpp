@@ -0,0 +1,266 @@
+#include "logger.h"
+
+Logger logger;
+const char logAnchor[] PROGMEM = "log";
+
+#ifdef LOG_BINARY
+// what a conversion takes from the arguments, and how the record carries it
+static uint8_t *encodeArgument(uint8_t *p, uint8_t *end, char conversion, uint8_t longs, va_list &args)
+{
+    switch (conversion)
+    {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+    {
+        // long is 32 bits on the device, 4 bytes carry it
+        uint64_t value;
+        if (longs > 1)
+            value = va_arg(args, unsigned long long);
+        else if (longs == 1)
+            value = va_arg(args, unsigned long);
+        else
+            value = va_arg(args, unsigned int);
+        uint8_t size = longs > 1 ? 8 : 4;
+        if (p + size > end)
+            return nullptr;
+        memcpy(p, &value, size);
+        return p + size;
+    }
+    case 'f':
+    case 'e':
+    case 'g':
+    {
+        double value = va_arg(args, double);
+        if (p + sizeof(value) > end)
+            return nullptr;
+        memcpy(p, &value, sizeof(value));
+        return p + sizeof(value);
+    }
+    case 'c':
+        if (p + 1 > end)
+            return nullptr;
+        *p = (uint8_t)va_arg(args, int);
+        return p + 1;
+    case 's':
+    {
+        const char *s = va_arg(args, const char *);
+        if (!s)
+            s = "(null)";
+        // cut to what is left of the record, but always terminated
+        if (p + 1 > end)
+            return nullptr;
+        while (*s && p + 1 < end)
+            *p++ = *s++;
+        *p++ = 0;
+        return p;
+    }
+    case 'p':
+    {
+        uint32_t value = (uint32_t)(uintptr_t)va_arg(args, void *);
+        if (p + 4 > end)
+            return nullptr;
+        memcpy(p, &value, 4);
+        return p + 4;
+    }
+    default:
+        return p;
+    }
+}
+#endif
+
+Logger::Logger(void) : m_out(nullptr),
+    m_head(0),
+    m_tail(0),
+    m_missed(0),
+    m_lineLength(0),
+    m_stats()
+{
+}
+
+size_t Logger::encode(uint8_t *record, uint8_t level, PGM_P format, va_list args)
+{
+#ifdef LOG_BINARY
+    uint8_t *p = record;
+    uint8_t *end = record + LOG_RECORD_MAX;
+    uint32_t now = micros();
+    int32_t offset = (int32_t)((uintptr_t)format - (uintptr_t)logAnchor);
+    *p++ = LOG_SYNC;
+    *p++ = 0; // length, below
+    *p++ = level;
+    memcpy(p, &now, 4);
+    p += 4;
+    memcpy(p, &offset, 4);
+    p += 4;
+
+    // va_arg() the arguments as printf would, from the format in flash
+    va_list walk;
+    va_copy(walk, args);
+    PGM_P f = format;
+    uint8_t *next = p;
+    char c;
+    while (next && (c = pgm_read_byte(f++)))
+    {
+        if (c != '%')
+            continue;
+        c = pgm_read_byte(f++);
+        while (c == '-' || c == '+' || c == ' ' || c == '#' || c == '0')
+            c = pgm_read_byte(f++);
+        for (uint8_t part = 0; part < 2 && next; ++part)
+        {
+            // width, then precision
+            if (c == '*')
+            {
+                if ((next = encodeArgument(p, end, 'd', 0, walk)))
+                    p = next;
+                c = pgm_read_byte(f++);
+            }
+            while (c >= '0' && c <= '9')
+                c = pgm_read_byte(f++);
+            if (part == 0 && c == '.')
+                c = pgm_read_byte(f++);
+            else
+                break;
+        }
+        uint8_t longs = 0;
+        while (c == 'l' || c == 'h' || c == 'z' || c == 'j' || c == 't')
+        {
+            // size_t and ptrdiff_t are 32 bits on the device, intmax_t 64
+            longs += c == 'l' ? 1 : c == 'j' ? 2 : 0;
+            c = pgm_read_byte(f++);
+        }
+        if (!c)
+            break;
+        if (next && (next = encodeArgument(p, end, c, longs, walk)))
+            p = next;
+    }
+    va_end(walk);
+    // out of room, the decoder shows the arguments that did not fit as ?
+    size_t length = p - record;
+    record[1] = (uint8_t)length;
+    return length;
+#else
+    static const char LEVELS[] = "-EWID";
+    char *text = (char *)record;
+    uint32_t ms = millis();
+    int prefix = snprintf(text, LOG_RECORD_MAX, "[%5lu.%03lu] %c ", (unsigned long)(ms / 1000),
+                          (unsigned long)(ms % 1000), LEVELS[level < sizeof(LEVELS) - 1 ? level : 0]);
+    // one byte kept for the newline
+    int room = LOG_RECORD_MAX - prefix - 1;
+    int length = vsnprintf_P(text + prefix, room, format, args);
+    if (length < 0)
+        length = 0;
+    length = min(length, room - 1);
+    text[prefix + length] = '\n';
+    return prefix + length + 1;
+#endif
+}
+
+size_t Logger::encodef(uint8_t *record, uint8_t level, PGM_P format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    size_t length = encode(record, level, format, args);
+    va_end(args);
+    return length;
+}
+
+bool Logger::push(const uint8_t *record, size_t length)
+{
+    if (length > (size_t)(LOG_RING_SIZE - 1 - queued()))
+        return false;
+    for (size_t i = 0; i < length; ++i)
+    {
+        m_ring[m_head] = record[i];
+        m_head = (m_head + 1) & (LOG_RING_SIZE - 1);
+    }
+    m_stats.bytes += length;
+    m_stats.maxQueued = max(m_stats.maxQueued, queued());
+    return true;
+}
+
+void Logger::log(uint8_t level, PGM_P format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vlog(level, format, args);
+    va_end(args);
+}
+
+void Logger::vlog(uint8_t level, PGM_P format, va_list args)
+{
+    uint8_t record[LOG_RECORD_MAX];
+    size_t length = encode(record, level, format, args);
+
+    // say how many went missing before the first record that fits again
+    if (m_missed)
+    {
+        uint8_t note[LOG_RECORD_MAX];
+        size_t noteLength = encodef(note, LOG_LEVEL_WARN, PSTR("log: %lu records dropped"), (unsigned long)m_missed);
+        if (noteLength + length > (size_t)(LOG_RING_SIZE - 1 - queued()))
+        {
+            ++m_missed;
+            ++m_stats.dropped;
+            return;
+        }
+        push(note, noteLength);
+        m_missed = 0;
+    }
+    if (!push(record, length))
+    {
+        ++m_missed;
+        ++m_stats.dropped;
+        return;
+    }
+    ++m_stats.records;
+}
+
+bool Logger::drain()
+{
+    if (!m_out)
+        return pending();
+    uint16_t room = (uint16_t)max(m_out->availableForWrite(), 0);
+    while (room && pending())
+    {
+        // contiguous up to the end of the ring, the rest on the next pass
+        uint16_t chunk = m_head >= m_tail ? m_head - m_tail : LOG_RING_SIZE - m_tail;
+        chunk = min(chunk, room);
+        m_out->write(m_ring + m_tail, chunk);
+        m_tail = (m_tail + chunk) & (LOG_RING_SIZE - 1);
+        room -= chunk;
+    }
+    return pending();
+}
+
+void Logger::flush()
+{
+    if (!m_out)
+        return;
+    while (pending())
+    {
+        uint16_t chunk = m_head >= m_tail ? m_head - m_tail : LOG_RING_SIZE - m_tail;
+        m_out->write(m_ring + m_tail, chunk);
+        m_tail = (m_tail + chunk) & (LOG_RING_SIZE - 1);
+    }
+    m_out->flush();
+}
+
+size_t Logger::write(uint8_t c)
+{
+    if (c == '\r')
+        return 1;
+    if (c != '\n' && m_lineLength < LOG_RECORD_MAX - 1)
+    {
+        m_line[m_lineLength++] = c;
+        return 1;
+    }
+    m_line[m_lineLength] = 0;
+    m_lineLength = 0;
+    log(LOG_LEVEL_INFO, PSTR("%s"), m_line);
+    if (c != '\n')
+        m_line[m_lineLength++] = c;
+    return 1;
+}
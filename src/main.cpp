@@ -7,12 +7,26 @@
 
 #include <ESP8266WiFi.h>
 #include <PubSubClient.h>
-#include <Base64.h>
 
-#define SERIAL_DEBUG
-#include "SerialDebug.h"
-
-#include "select_box.h"
+#define LOG_MODULE "main"
+#include "logger.h"
+
+#include "widget.h"
+#include "label.h"
+#include "text_field.h"
+#include "keyboard.h"
+#include "hit_index.h"
+#include "wifi_connection.h"
+#include "mqtt_connection.h"
+#include "topic_router.h"
+#include "outbound_queue.h"
+#include "message_ring.h"
+#include "payload_sink.h"
+#include "tile_canvas.h"
+#include "config_store.h"
+#include "boot_timer.h"
+#include "touch_input.h"
+#include "scheduler.h"
 
 //create a file with the following
 /*
@@ -34,14 +48,32 @@ X509List caCertX509(caCert);
 
 //wifi
 WiFiClientSecure espClient;
-String ssid = "";
-String password = "";
 int wifiStatus;
+WifiConnection wifiConnection;
+bool storeWifiOnConnect = false;
 
 //MQTT
 PubSubClient client(espClient);
+MqttConnection mqttConnection(client);
+// handler and partner for each subscribed topic, see OnMessage()
+TopicRouter topicRouter;
+// messages addressed to this box; registered partners and groups get ids
+// from 1 up
+#define PARTNER_SELF 0
 String MY_UUID = "c2fbca29-ddf3-4e86-bfac-f366bbeb3eb1";
-String displayMessage = "";
+// payloads larger than a chunk are spooled here, then kept in the file of
+// the inbox slot they take
+#define INBOX_SPOOL_FILE "/inbox.part"
+// only topics and outgoing packets go through the client buffer, payloads are
+// streamed into payloadSink
+#define MQTT_BUFFER_SIZE 256
+PayloadSink payloadSink(INBOX_SPOOL_FILE);
+MessageRing inbox;
+// everything published goes through here, spooled while the broker is away
+#define OUTBOX_FILE "/outbox.bin"
+OutboundQueue outbox(mqttConnection, OUTBOX_FILE);
+char displayMessage[MESSAGE_SLOT_SIZE + 1] = "";
+bool displayMessageChanged = false;
 
 //screen
 TFT_eSPI tft = TFT_eSPI();
@@ -64,32 +96,54 @@ ScreenState currentScreen = ScreenState::none;
 #define pw_w 150
 #define pw_h 20
 
-const String text_keyboard[42] = {
-    "OK", "Clear", "Del", "Shift", "Caps", "Sym",
-    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
-    "q", "w", "e", "r", "t", "y", "u", "i", "o", "p",
-    "a", "s", "d", "f", "g", "h", "j", "k", "l",
-    "z", "x", "c", "v", "b", "n", "m"};
-
-const String symbol_keyboard[42] = {
-    "OK", "Clear", "Del", "Shift", "Caps", "txt",
-    "`", "!", "\"", "$", "%", "^", "&", "*", "(", ")",
-    "_", "-", "+", "=", "{", "[", "}", "]", ";", ":",
-    "\'", "@", "#", "~", ",", "<", ".", ">", "/",
-    "?", "|", "\\", "", "", "", ""};
-
-boolean text_keyboard_enabled = true;
+// drawing area, right of the button column
+#define canvas_x 64
+#define canvas_y 0
+#define canvas_w 416
+#define canvas_h 320
+#define pen_width 3
+
+const uint16_t canvas_palette[CANVAS_COLOURS] = {TFT_CYAN, TFT_BLACK, TFT_RED, TFT_BLUE};
+
+TFT_Tile_Canvas canvas;
+uint8_t penColour = 1;
+bool penDown = false;
+int16_t penX, penY;
+
+// the Sym key steps through these, letters first, see keyboard_layout.h
+const KeyboardLayout *const wifiLayouts[] = {&KEYBOARD_LANGUAGE, &keyboardSymbols, &keyboardNumeric};
+uint8_t wifiLayout = 0;
 boolean caps_lock = false;
 boolean shift_pressed = false;
 
-TFT_eSPI_Button keys[42];
+TFT_Keyboard keyboard;
+TFT_Hit_Index wifiHitIndex;
+TouchInput touchInput;
+
+// SSID and password, typed in place
+TFT_Text_Field wifiBoxes[2];
+TFT_Text_Field *selectedWifiBox = nullptr;
+// hit index ids: keys use their index, the boxes follow them
+#define WIFI_BOX_HIT_ID KEYBOARD_KEYS
+
+// panel time a frame may spend drawing, out of FRAME_MS
+#define FRAME_DRAW_BUDGET_US 12000
 
-TFT_Select_Box wifiBoxes[2];
-TFT_Select_Box *selectedWifiBox = nullptr;
+// the Wi-Fi screen: labels, the two fields and the keyboard, see drawWifi()
+TFT_Screen wifiScreen;
+TFT_Label ssidLabel, passwordLabel, wifiProgressLabel, wifiResultLabel;
 
-// This is the file name used to store the calibration data
-#define CALIBRATION_FILE "/TouchCalData"
-#define WIFI_FILE "/WifiData"
+// calibration and Wi-Fi credentials live in one record, see ConfigStore
+ConfigStore config;
+
+// loop() work, see setupTasks()
+#define WIFI_TICK_MS 100
+#define MQTT_SERVICE_MS 10
+#define OUTBOX_SERVICE_MS 50
+#define FRAME_MS 20
+#define SCHEDULER_REPORT_MS 60000
+Scheduler scheduler;
+int8_t inboxTask = -1;
 
 // Set REPEAT_CAL to true instead of false to run calibration
 // again, otherwise it will only be done once.
@@ -100,39 +154,17 @@ TFT_Select_Box *selectedWifiBox = nullptr;
 void touch_calibrate()
 {
     uint16_t calData[5];
-    uint8_t calDataOK = 0;
 
-    // check file system exists
-    if (!SPIFFS.begin())
+    if (REPEAT_CAL)
     {
-        Serial.println("Formating file system");
-        SPIFFS.format();
-        SPIFFS.begin();
+        // forget the stored data if we want to re-calibrate
+        config.clearCalibration();
     }
 
-    // check if calibration file exists and size is correct
-    if (SPIFFS.exists(CALIBRATION_FILE))
-    {
-        if (REPEAT_CAL)
-        {
-            // Delete if we want to re-calibrate
-            SPIFFS.remove(CALIBRATION_FILE);
-        }
-        else
-        {
-            File f = SPIFFS.open(CALIBRATION_FILE, "r");
-            if (f)
-            {
-                if (f.readBytes((char *)calData, 14) == 14)
-                    calDataOK = 1;
-                f.close();
-            }
-        }
-    }
-
-    if (calDataOK && !REPEAT_CAL)
+    if (config.hasCalibration())
     {
         // calibration data valid
+        memcpy(calData, config.calibration(), sizeof(calData));
         tft.setTouch(calData);
     }
     else
@@ -161,43 +193,133 @@ void touch_calibrate()
         tft.println("Calibration complete!");
 
         // store data
-        File f = SPIFFS.open(CALIBRATION_FILE, "w");
-        if (f)
-        {
-            f.write((const unsigned char *)calData, 14);
-            f.close();
-        }
+        config.setCalibration(calData);
+        config.save();
     }
 }
 
 //setup code
 void setupWifi()
 {
-    SerialDebugln("setupWifi");
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid, password);
+    wifiConnection.begin(wifiBoxes[0].text(), wifiBoxes[1].text());
+    LOG_INFO("connecting to %s", wifiBoxes[0].text());
+}
+
+void onWifiProgress(const String &connectingSsid, uint8_t retries)
+{
+    String progress = "Connecting to " + connectingSsid + " retries: " + retries;
+    wifiProgressLabel.setText(progress.c_str());
+    LOG_INFO("%s", progress.c_str());
+}
+
+void storeWifiSettings();
 
-    SerialDebug("Your are connecting to;");
-    SerialDebugln(ssid);
+void onWifiResult(WifiConnection::State state, wl_status_t status)
+{
+    if (state == WifiConnection::Connected)
+    {
+        wifiResultLabel.setText("Connected!");
+        LOG_INFO("boot to connected %lu ms", (unsigned long)wifiConnection.bootToConnectedMs());
+        BootTimer::mark(BootTimer::WifiConnected);
+        if (storeWifiOnConnect)
+            storeWifiSettings();
+    }
+    else if (state == WifiConnection::Cancelled)
+    {
+        wifiResultLabel.setText("Cancelled.");
+    }
+    else
+    {
+        String result = "Failed to connect " + (String)status + ".";
+        wifiResultLabel.setText(result.c_str());
+    }
+    storeWifiOnConnect = false;
 }
 
 void OnMessage(char *topic, byte *payload, int length)
 {
-    SerialDebug("Message Received: [");
-    displayMessage = "";
-    for (int i = 0; i < length; ++i)
+    // payload and length only cover what fitted in the client buffer, the
+    // whole message went through payloadSink
+    if (!BootTimer::reached(BootTimer::FirstMessage))
+    {
+        BootTimer::mark(BootTimer::FirstMessage);
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+        BootTimer::print(logger);
+#endif
+    }
+    if (!topicRouter.dispatch(topic, payload, length))
+    {
+        LOG_WARN("nothing routed to %s", topic);
+        payloadSink.discard();
+    }
+}
+
+void onInboxMessage(uint8_t partner, const char *topic, const uint8_t *payload, uint32_t length)
+{
+    LOG_DEBUG("message from partner %u, %lu bytes", partner, (unsigned long)payloadSink.size());
+
+    bool queued;
+    if (!payloadSink.spilled())
+    {
+        queued = inbox.push(payloadSink.data(), payloadSink.size());
+        payloadSink.discard();
+    }
+    else if (const char *path = inbox.nextFile())
+    {
+        uint32_t size = payloadSink.size();
+        if (!payloadSink.commit(path))
+        {
+            LOG_ERROR("could not store message");
+            return;
+        }
+        queued = inbox.pushFile(path, size);
+    }
+    else
+    {
+        payloadSink.discard();
+        queued = false;
+    }
+    if (!queued)
+    {
+        LOG_WARN("inbox full, message dropped");
+    }
+    scheduler.runIn(inboxTask, 0);
+}
+
+// UI side of the inbox, only the newest message is kept for display
+void consumeMessages()
+{
+    while (const MessageSlot *message = inbox.peek())
     {
-        SerialDebug((char)payload[i]);
-        displayMessage += (char)payload[i];
+        if (message->file)
+        {
+            // spooled payload, show as much of it as the buffer holds
+            File f = SPIFFS.open(message->file, "r");
+            size_t n = f ? f.readBytes(displayMessage, MESSAGE_SLOT_SIZE) : 0;
+            displayMessage[n] = 0;
+            f.close();
+            SPIFFS.remove(message->file);
+        }
+        else
+        {
+            memcpy(displayMessage, message->data, message->length + 1);
+        }
+        displayMessageChanged = true;
+        inbox.pop();
     }
-    SerialDebug("]");
 }
 
 void MQTTSetup()
 {
-    client.setBufferSize(10000);
+    client.setBufferSize(MQTT_BUFFER_SIZE);
+    client.setStream(payloadSink);
     client.setServer("192.168.8.145", 8883);
     client.setCallback(OnMessage);
+    // keep a dead broker from stalling the loop for the 15 s defaults
+    client.setSocketTimeout(5);
+    espClient.setTimeout(5000);
+    topicRouter.add(("MessageBox/" + MY_UUID).c_str(), onInboxMessage, PARTNER_SELF);
+    mqttConnection.begin(MY_UUID.c_str(), topicRouter, "ConnectedClients");
 }
 
 void setupDisplay()
@@ -205,154 +327,115 @@ void setupDisplay()
     // Initialise the TFT screen
     tft.init();
     tft.setRotation(1);
+    BootTimer::mark(BootTimer::DisplayInit);
     touch_calibrate();
+    touchInput.begin(&tft);
+    BootTimer::mark(BootTimer::TouchCalibrate);
+}
+
+// publish the boot timing once, the first time the broker is reachable
+void onMqttOnline()
+{
+    // a message the last session dropped part way through would sit in
+    // front of the first one of this session, its /inbox.part with it
+    payloadSink.discard();
+
+    if (BootTimer::reached(BootTimer::MqttOnline))
+        return;
+    BootTimer::mark(BootTimer::MqttOnline);
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+    BootTimer::print(logger);
+#endif
+
+    char payload[200];
+    int length = snprintf(payload, sizeof(payload), "%s ", MY_UUID.c_str());
+    length += BootTimer::format(payload + length, sizeof(payload) - length);
+    outbox.publish("BootTimes", (const uint8_t *)payload, length);
 }
 
+void setupTasks();
+
 void setup()
 {
-#ifdef SERIAL_DEBUG
+    BootTimer::mark(BootTimer::SetupStart);
+#if LOG_LEVEL_DEFAULT > LOG_LEVEL_NONE
     Serial.begin(921600);
+    logger.begin(Serial);
 #endif
     WiFi.setAutoConnect(false); // do not autoconnect
+    // mounts SPIFFS and loads calibration and Wi-Fi settings in one read
+    if (!config.begin())
+    {
+        LOG_ERROR("file system unavailable, settings will not be kept");
+    }
+    outbox.begin();
+    BootTimer::mark(BootTimer::ConfigLoad);
     setupDisplay();
     delay(200);
+    BootTimer::mark(BootTimer::SetupDelay);
 #ifdef CERTS
     espClient.setTrustAnchors(&caCertX509); //set the certificate
     espClient.setFingerprint(fingerprint);  //only accept connections from certs with this fingerprint
     espClient.allowSelfSignedCerts();       //allow my certs
     //espClient.setInsecure(); //this will allow connections from any server
+    BootTimer::mark(BootTimer::TlsSetup);
 #endif // ifdef CERTS
     MQTTSetup();
-    SerialDebugln("Setup Complete");
+    mqttConnection.onOnline(onMqttOnline);
+    BootTimer::mark(BootTimer::MqttSetup);
+    wifiConnection.onProgress(onWifiProgress);
+    wifiConnection.onResult(onWifiResult);
+    setupTasks();
+    BootTimer::mark(BootTimer::SetupDone);
+    LOG_INFO("setup complete");
 }
 
-void ReconnectMQTT()
+void MQTTLoop()
 {
-    while (!client.connected())
-    {
-        SerialDebug(" . ");
-        if (client.connect(MY_UUID.c_str()))
-        {
-            // Once connected, publish an announcement...
-            client.publish("ConnectedClients", MY_UUID.c_str());
-            // subscribe
-            client.subscribe(("MessageBox/" + MY_UUID).c_str());
-        }
-        else
-        {
-            // Wait 5 seconds before retrying
-            delay(5000);
-        }
-    }
+    mqttConnection.loop();
 }
 
-void MQTTLoop()
+// show whichever layout is active after a Shift/Caps/Sym change
+void redrawKeyboard()
 {
-    if (!client.connected())
-    {
-        SerialDebugln("MQTT not Connected - Reconnecting")
-            ReconnectMQTT();
-    }
-    client.loop();
+    keyboard.setLayout(wifiLayouts[wifiLayout], caps_lock, shift_pressed);
 }
 
-void drawKeyboard(const String keyboardArray[42])
+// layouts put their keys in different places, and some have gaps
+void indexWifiScreen()
 {
-    int x = 20;
-    int y = 180;
-    for (uint i = 0; i < 42; ++i)
+    wifiHitIndex.clear();
+    for (uint8_t i = 0; i < KEYBOARD_KEYS; ++i)
     {
-        //first 6 reserved, then new line
-        if (i <= 5)
-        {
-            keys[i].initButton(&tft, x, y, 40, 25, TFT_WHITE, TFT_BLUE, TFT_WHITE, (char *)(keyboardArray[i].c_str()), 1);
-            x += 45;
-        }
-        else
-        {
-            char key = symbol_keyboard[i].c_str()[0];
-            if (text_keyboard_enabled)
-            {
-                key = (keyboardArray[i].c_str()[0]);
-                if (caps_lock)
-                    key = toupper(key);
-
-                if (shift_pressed)
-                {
-                    if (isupper(key))
-                        key = tolower(key);
-                    else
-                        key = toupper(key);
-                }
-            }
-            keys[i].initButton(&tft, x, y, 35, 25, TFT_WHITE, TFT_LIGHTGREY, TFT_BLACK, &key, 1);
-            x += 40;
-        }
-
-        keys[i].drawButton();
-
-        if (
-            i == 5 ||  //ok,clear,del,shift,caps,txt
-            i == 15 || //0123456789
-            i == 25 || //qwertyuiop
-            i == 34)   //asdfghjkl
-        {
-            x = 60;
-            y += 30;
-        }
+        if (!keyboard.hasKey(i))
+            continue;
+        int16_t x, y;
+        uint16_t w, h;
+        keyboard.keyRect(i, x, y, w, h);
+        wifiHitIndex.add(i, x, y, w, h);
     }
+    wifiHitIndex.add(WIFI_BOX_HIT_ID, ssid_x, ssid_y, ssid_w, ssid_h);
+    wifiHitIndex.add(WIFI_BOX_HIT_ID + 1, pw_x, pw_y, pw_w, pw_h);
 }
 
 bool connectStoredSettings()
 {
-    SerialDebugln("connectStoredSettings");
-    if (!SPIFFS.begin())
-    {
-        Serial.println("Formating file system");
-        SPIFFS.format();
-        SPIFFS.begin();
-    }
-
     if (REPEAT_WIFI)
     {
-        // Delete if we want to re-setup
-        SPIFFS.remove(WIFI_FILE);
+        // forget the stored network if we want to re-setup
+        config.clearWifi();
     }
 
-    if (!SPIFFS.exists(WIFI_FILE))
+    if (!config.hasWifi())
     {
         return false;
     }
 
-    File f = SPIFFS.open(WIFI_FILE, "r");
-    if (f)
-    {
-        ssid = f.readStringUntil('\n');
-        password = f.readString();
-        f.close();
-        SerialDebugln(ssid);
-        SerialDebugln(password);
-        setupWifi();
-        int retries = 0;
-        while (WiFi.status() != WL_CONNECTED && retries < 15)
-        {
-            delay(1000);
-            String connectingMsg = "Connecting to " + ssid + " retries: " + retries;
-            tft.drawCentreString(connectingMsg, 240, 130, 1);
-            SerialDebugln(connectingMsg);
-            ++retries;
-        }
-        if (WiFi.status() == WL_CONNECTED)
-        {
-            tft.drawCentreString("Connected!", 240, 140, 1);
-            return true;
-        }
-        else
-        {
-            tft.drawCentreString("Failed to connect " + (String)WiFi.status() + ".", 240, 140, 1);
-        }
-    }
-    return false;
+    wifiBoxes[0].setText(config.ssid());
+    wifiBoxes[1].setText(config.password());
+    LOG_DEBUG("stored network %s", config.ssid());
+    setupWifi();
+    return true;
 }
 
 void drawWifi()
@@ -360,254 +443,204 @@ void drawWifi()
     if (currentScreen != ScreenState::wifi) // draw screen
     {
         currentScreen = ScreenState::wifi;
-        tft.fillScreen(0x000000); //fill black
+        // painted in full, black, on the first render()
+        wifiScreen.init(&tft, TFT_BLACK);
 
-        //try to connect using stored data
+        //try to connect using stored data, the screen stays usable while it does
         if (connectStoredSettings())
         {
-            SerialDebugln("connectedsuccessfully");
-            return;
+            LOG_INFO("connecting with stored settings");
         }
         else
-            SerialDebugln("notconnectedsuccessfully");
+        {
+            LOG_INFO("no stored settings");
+        }
 
-        tft.setCursor(5, 20, 2);
-        tft.setTextSize(1);
-        tft.print("SSID: ");
+        ssidLabel.init(&tft, 5, ssid_y, ssid_x - 5, tft.fontHeight(2), TFT_WHITE, TFT_BLACK, 2);
+        ssidLabel.setText("SSID: ");
         //draw a box to the right
-        wifiBoxes[0].init(&tft, ssid_x, ssid_y, ssid_w, ssid_h, TFT_WHITE, TFT_TRANSPARENT, TFT_WHITE, TFT_GREEN, &ssid, 1);
-        wifiBoxes[0].m_selected = true;
-        wifiBoxes[0].draw();
+        wifiBoxes[0].init(&tft, ssid_x, ssid_y, ssid_w, ssid_h, TFT_WHITE, TFT_TRANSPARENT, TFT_WHITE, TFT_GREEN, 1);
+        wifiBoxes[0].setSelected(true);
         selectedWifiBox = &wifiBoxes[0];
 
-        tft.setCursor(220, 20, 2);
-        tft.print("Password: ");
+        passwordLabel.init(&tft, 220, pw_y, pw_x - 220, tft.fontHeight(2), TFT_WHITE, TFT_BLACK, 2);
+        passwordLabel.setText("Password: ");
         //draw a box to the right
-        wifiBoxes[1].init(&tft, pw_x, pw_y, pw_w, pw_h, TFT_WHITE, TFT_TRANSPARENT, TFT_WHITE, TFT_GREEN, &password, 1);
-        wifiBoxes[1].draw();
-
-        text_keyboard_enabled = true;
-        drawKeyboard(text_keyboard);
+        wifiBoxes[1].init(&tft, pw_x, pw_y, pw_w, pw_h, TFT_WHITE, TFT_TRANSPARENT, TFT_WHITE, TFT_GREEN, 1);
+        wifiBoxes[1].setMasked(true);
+        wifiBoxes[1].setSelected(false);
+
+        wifiProgressLabel.init(&tft, 0, 130, tft.width(), tft.fontHeight(1), TFT_WHITE, TFT_BLACK, 1, TC_DATUM);
+        wifiResultLabel.init(&tft, 0, 140, tft.width(), tft.fontHeight(1), TFT_WHITE, TFT_BLACK, 1, TC_DATUM);
+
+        wifiLayout = 0;
+        keyboard.begin(&tft, wifiLayouts, sizeof(wifiLayouts) / sizeof(wifiLayouts[0]));
+        redrawKeyboard();
+
+        // only added once, a widget already in the tree stays put
+        wifiScreen.add(&ssidLabel);
+        wifiScreen.add(&wifiBoxes[0]);
+        wifiScreen.add(&passwordLabel);
+        wifiScreen.add(&wifiBoxes[1]);
+        wifiScreen.add(&wifiProgressLabel);
+        wifiScreen.add(&wifiResultLabel);
+        wifiScreen.add(&keyboard);
+
+        indexWifiScreen();
     }
     return;
 }
 
 void storeWifiSettings()
 {
-    if (!SPIFFS.begin())
+    config.setWifi(wifiBoxes[0].text(), wifiBoxes[1].text());
+    if (!config.save())
     {
-        Serial.println("Formating file system");
-        SPIFFS.format();
-        SPIFFS.begin();
+        LOG_ERROR("could not save Wi-Fi settings");
     }
+}
 
-    // check if file exists and remove if it does
-    if (SPIFFS.exists(WIFI_FILE))
+void onWifiBoxPressed(uint8_t i)
+{
+    if (selectedWifiBox == &wifiBoxes[i])
     {
-        SPIFFS.remove(WIFI_FILE);
+        LOG_DEBUG("box %u deselected", i);
+        selectedWifiBox->setSelected(false);
+        selectedWifiBox = nullptr;
     }
-
-    File f = SPIFFS.open(WIFI_FILE, "w");
-    if (f)
+    else
     {
-        String ssidPW = ssid + "\n" + password;
-        f.write(ssidPW.c_str());
-        f.close();
+        LOG_DEBUG("box %u selected", i);
+        if (selectedWifiBox != nullptr)
+        {
+            selectedWifiBox->setSelected(false);
+        }
+        selectedWifiBox = &wifiBoxes[i];
+        selectedWifiBox->setSelected(true);
     }
 }
 
-void wifiSetup()
+void onKeyPressed(uint8_t i)
 {
-
-    //draw screen once
-    drawWifi();
-
-    uint16_t t_x = 0, t_y = 0; // To store the touch coordinates
-    uint8_t touched = tft.getTouch(&t_x, &t_y);
-
-    for (uint8_t i = 0; i < 2; ++i)
+    switch (i)
     {
-        if (touched && wifiBoxes[i].contains(t_x, t_y))
+    case 0: //OK
+        /* connect with what has been entered, pressing OK
+        again while it is connecting cancels */
+        if (wifiConnection.isConnecting())
         {
-            wifiBoxes[i].press(true);
+            wifiConnection.cancel();
         }
         else
         {
-            wifiBoxes[i].press(false);
+            storeWifiOnConnect = true;
+            setupWifi();
         }
-    }
-
-    for (uint8_t i = 0; i < 2; ++i)
-    {
-        if (wifiBoxes[i].justPressed())
+        break;
+    case 1: //Clear
+        if (selectedWifiBox != nullptr)
         {
-            if (selectedWifiBox == &wifiBoxes[i])
-            {
-                SerialDebugln("deselected ");
-                selectedWifiBox->m_selected = false;
-                selectedWifiBox->draw();
-                selectedWifiBox = nullptr;
-            }
-            else
+            selectedWifiBox->clear();
+        }
+        break;
+    case 2: //Del
+        /* clear one char from whatever is selected */
+        if (selectedWifiBox != nullptr)
+        {
+            selectedWifiBox->erase();
+        }
+        break;
+    case 3: //Shift
+        /* capitalise next char */
+        shift_pressed = true;
+        redrawKeyboard();
+        break;
+    case 4: //Caps
+        /* capatalise all chars until toggled */
+        caps_lock = !caps_lock;
+        redrawKeyboard();
+        break;
+    case 5: //Sym
+        /* switch keyboards, the control keys stay where they are so Sym
+        is still held down in the next one */
+        wifiLayout = (wifiLayout + 1) % (sizeof(wifiLayouts) / sizeof(wifiLayouts[0]));
+        redrawKeyboard();
+        indexWifiScreen();
+        break;
+
+    default:
+        if (selectedWifiBox != nullptr)
+        {
+            char label[KEYBOARD_LABEL_LEN];
+            TFT_Keyboard::keyLabel(keyboard.layout(), i, caps_lock, shift_pressed, label);
+            if (shift_pressed && keyboard.hasLetters())
             {
-                SerialDebugln("selected ");
-                if (selectedWifiBox != nullptr)
-                {
-                    selectedWifiBox->m_selected = false;
-                    selectedWifiBox->draw();
-                }
-                selectedWifiBox = &wifiBoxes[i];
-                selectedWifiBox->m_selected = true;
-                selectedWifiBox->draw();
+                shift_pressed = false;
+                redrawKeyboard();
             }
+            selectedWifiBox->append(label);
         }
+        break;
     }
+}
 
-    for (uint8_t i = 0; i < 42; ++i)
+void wifiTouch(bool touched, int16_t t_x, int16_t t_y)
+{
+    // only the widgets under the last few touches can change press state
+    uint8_t changed[3];
+    uint8_t count = wifiHitIndex.update(touched, t_x, t_y, changed);
+    for (uint8_t c = 0; c < count; ++c)
     {
-        if (touched && keys[i].contains(t_x, t_y))
-        {
-            keys[i].press(true);
-        }
-        else
+        uint8_t id = changed[c];
+        bool down = wifiHitIndex.isDown(id);
+
+        if (id >= WIFI_BOX_HIT_ID)
         {
-            keys[i].press(false);
+            uint8_t i = id - WIFI_BOX_HIT_ID;
+            wifiBoxes[i].press(down);
+            if (wifiBoxes[i].justPressed())
+            {
+                onWifiBoxPressed(i);
+            }
+            continue;
         }
-    }
 
-    for (uint8_t i = 0; i < 42; ++i)
-    {
-        if (keys[i].justReleased())
+        TFT_eSPI_Button &key = keyboard.key(id);
+        key.press(down);
+        if (key.justReleased())
         {
-            keys[i].drawButton(false);
+            keyboard.invalidateKey(id);
         }
 
-        if (keys[i].justPressed())
+        if (key.justPressed())
         {
-            keys[i].drawButton(true);
-            int retries = 0;
-            switch (i)
-            {
-            case 0: //OK
-                /* if on ssid move to password,
-                if on password try to connect*/
-                setupWifi();
-                while (WiFi.status() != WL_CONNECTED && retries < 15)
-                {
-                    delay(1000);
-                    String connectingMsg = "Connecting to " + ssid + " retries: " + retries;
-                    tft.drawCentreString(connectingMsg, 240, 130, 1);
-                    SerialDebugln(connectingMsg);
-                    ++retries;
-                }
-                if (WiFi.status() == WL_CONNECTED)
-                {
-                    tft.drawCentreString("Connected!", 240, 140, 1);
-                    storeWifiSettings();
-                }
-                else
-                {
-                    tft.drawCentreString("Failed to connect " + (String)WiFi.status() + ".", 240, 140, 1);
-                }
-                break;
-            case 1: //Clear
-                if (selectedWifiBox != nullptr)
-                {
-                    *selectedWifiBox->m_label = "";
-                    selectedWifiBox->draw();
-                }
-                break;
-            case 2: //Del
-                /* clear one char from whatever is selected */
-                if (selectedWifiBox != nullptr)
-                {
-                    *selectedWifiBox->m_label = selectedWifiBox->m_label->substring(
-                        0, selectedWifiBox->m_label->length() - 1);
-                    selectedWifiBox->draw();
-                }
-                break;
-            case 3: //Shift
-                /* capitalise next char */
-                shift_pressed = true;
-                if (text_keyboard_enabled)
-                {
-                    drawKeyboard(text_keyboard);
-                }
-                else
-                {
-                    drawKeyboard(symbol_keyboard);
-                }
-                break;
-            case 4: //Caps
-                /* capatalise all chars until toggled */
-                caps_lock = !caps_lock;
-                if (text_keyboard_enabled)
-                {
-                    drawKeyboard(text_keyboard);
-                }
-                else
-                {
-                    drawKeyboard(symbol_keyboard);
-                }
-                break;
-            case 5: //Sym
-                /* switch keyboards */
-                if (text_keyboard_enabled)
-                {
-                    text_keyboard_enabled = false;
-                    drawKeyboard(symbol_keyboard);
-                }
-                else
-                {
-                    text_keyboard_enabled = true;
-                    drawKeyboard(text_keyboard);
-                }
-                break;
-
-            default:
-                if (selectedWifiBox != nullptr)
-                {
-                    if (text_keyboard_enabled)
-                    {
-                        char text_key = text_keyboard[i].c_str()[0];
-                        if (caps_lock)
-                            text_key = toupper(text_key);
-
-                        if (shift_pressed)
-                        {
-                            if (isupper(text_key))
-                                text_key = tolower(text_key);
-                            else
-                                text_key = toupper(text_key);
-                            shift_pressed = false;
-                            /*
-                                I would like to put this in a method, but for some dumb
-                                reason it prints a question mark next to the char on the
-                                keyboard if its in a function
-                            */
-                            if (text_keyboard_enabled)
-                            {
-                                drawKeyboard(text_keyboard);
-                            }
-                            else
-                            {
-                                drawKeyboard(symbol_keyboard);
-                            }
-                        }
-
-                        *selectedWifiBox->m_label += text_key;
-                    }
-                    else
-                    {
-                        *selectedWifiBox->m_label += symbol_keyboard[i];
-                    }
-                    selectedWifiBox->draw();
-                }
-                break;
-            }
+            keyboard.invalidateKey(id);
+            onKeyPressed(id);
         }
     }
-    delay(25);
+}
+
+void wifiSetup()
+{
+
+    //draw screen once
+    drawWifi();
+
+    // every queued event is a sample, so a tap that came and went since the
+    // last loop() still presses its key
+    TouchEvent event;
+    bool touchedThisLoop = false;
+    while (touchInput.read(event))
+    {
+        wifiTouch(event.type != TouchEvent::Release, event.x, event.y);
+        touchedThisLoop = true;
+    }
+    if (!touchedThisLoop)
+    {
+        wifiTouch(touchInput.isDown(), touchInput.x(), touchInput.y());
+    }
+
+    wifiScreen.render(FRAME_DRAW_BUDGET_US);
 
     return;
 }
@@ -618,7 +651,10 @@ void drawDrawingScreen()
     {
         currentScreen = ScreenState::drawing;
         //draw buttons on left hand side
-        tft.fillScreen(TFT_CYAN);
+        tft.fillRect(0, 0, canvas_x, 320, TFT_CYAN);
+        // the canvas paints the rest on its first flush
+        canvas.init(canvas_x, canvas_y, canvas_w, canvas_h, canvas_palette);
+        canvas.spillTo(&tft);
     }
 }
 
@@ -626,11 +662,31 @@ void drawingScreen()
 {
     drawDrawingScreen();
     //check touched
+    TouchEvent event;
+    while (touchInput.read(event))
+    {
+        bool touched = event.type != TouchEvent::Release;
 
-    // if within buttons do button actions
+        // if within buttons do button actions
 
-    // if within drawing square - draw
-    
+        // if within drawing square - draw
+        if (touched && canvas.contains(event.x, event.y))
+        {
+            if (!penDown)
+            {
+                penX = event.x;
+                penY = event.y;
+            }
+            bool full = canvas.overflowed();
+            canvas.drawLine(penX, penY, event.x, event.y, penColour, pen_width);
+            if (!full && canvas.overflowed())
+                LOG_WARN("canvas full, new ink is shown but not kept");
+            penX = event.x;
+            penY = event.y;
+        }
+        penDown = touched && canvas.contains(event.x, event.y);
+    }
+    canvas.flush(&tft);
 }
 
 /**
@@ -649,8 +705,8 @@ void loopScreen()
 {
 
     // Pressed will be set true is there is a valid touch on the screen
-    //SerialDebugln(WiFi.status());
-    if (WiFi.status() != WL_CONNECTED)
+    // stay on the Wi-Fi screen until the connect has been reported on it
+    if (WiFi.status() != WL_CONNECTED || wifiConnection.isConnecting())
     {
         wifiSetup();
         return;
@@ -661,9 +717,63 @@ void loopScreen()
     }
 }
 
+void serviceOutbox()
+{
+    outbox.service();
+}
+
+void wifiTick()
+{
+    wifiConnection.tick();
+}
+
+// the log goes out when nothing else wants the loop
+bool drainLog()
+{
+    return logger.drain();
+}
+
+void reportSchedule()
+{
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+    scheduler.printStats(logger);
+    const TFT_Screen::Stats &render = wifiScreen.stats();
+    LOG_DEBUG("render frames %lu, painted %lu, updated %lu, merged %lu, deferred %lu, %lu px, frame max %lu us",
+              (unsigned long)render.frames, (unsigned long)render.painted, (unsigned long)render.updated,
+              (unsigned long)render.merged, (unsigned long)render.deferred, (unsigned long)render.pixels,
+              (unsigned long)render.maxFrameUs);
+    const Logger::Stats &log = logger.stats();
+    LOG_DEBUG("log records %lu, dropped %lu, %lu B, ring max %u of %u B", (unsigned long)log.records,
+              (unsigned long)log.dropped, (unsigned long)log.bytes, log.maxQueued, LOG_RING_SIZE);
+#endif
+    scheduler.resetStats();
+    wifiScreen.resetStats();
+    logger.resetStats();
+}
+
+// getTouch() blocks on delay(), so the controller is read here and not
+// from the pen IRQ or a Ticker
+void sampleTouch()
+{
+    touchInput.sample();
+}
+
+void setupTasks()
+{
+    scheduler.every("touch", TOUCH_SAMPLE_MS, sampleTouch);
+    scheduler.every("wifi", WIFI_TICK_MS, wifiTick);
+    scheduler.every("mqtt", MQTT_SERVICE_MS, MQTTLoop);
+    scheduler.every("outbox", OUTBOX_SERVICE_MS, serviceOutbox);
+    inboxTask = scheduler.deadline("inbox", consumeMessages);
+    scheduler.every("screen", FRAME_MS, loopScreen);
+    scheduler.every("report", SCHEDULER_REPORT_MS, reportSchedule);
+    scheduler.onIdle(drainLog);
+    scheduler.resetStats();
+}
+
 void loop(void)
 {
-    loopScreen();
+    scheduler.run();
     // tft.fillScreen(random(0xFFFF));
     // tft.setCursor(0, 0, 2);
     // // Set the font colour to be white with a black background, set text size multiplier to 1
@@ -671,6 +781,5 @@ void loop(void)
     // tft.setTextSize(1);
     // // We can now plot text on screen using the "print" class
     // tft.println("Hello World!");
-    // SerialDebugln(".");
-    // //MQTTLoop();
+    // LOG_DEBUG(".");
 }
\ No newline at end of file
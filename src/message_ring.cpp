@@ -0,0 +1,78 @@
+#include "message_ring.h"
+
+MessageRing::MessageRing(void) : m_slots(),
+    m_head(0),
+    m_tail(0),
+    m_dropped(0)
+{
+    for (uint8_t i = 0; i < MESSAGE_RING_SLOTS; ++i)
+        snprintf(m_files[i], MESSAGE_FILE_LEN, MESSAGE_FILE_FORMAT, i);
+}
+
+MessageSlot *MessageRing::claim()
+{
+    uint8_t head = m_head.load(std::memory_order_relaxed);
+    if ((head + 1) % MESSAGE_RING_SLOTS == m_tail.load(std::memory_order_acquire))
+    {
+        ++m_dropped;
+        return nullptr;
+    }
+    return &m_slots[head];
+}
+
+void MessageRing::publish()
+{
+    uint8_t head = m_head.load(std::memory_order_relaxed);
+    m_head.store((head + 1) % MESSAGE_RING_SLOTS, std::memory_order_release);
+}
+
+bool MessageRing::push(const uint8_t *payload, uint32_t length)
+{
+    MessageSlot *slot = claim();
+    if (!slot)
+        return false;
+    slot->length = min(length, (uint32_t)MESSAGE_SLOT_SIZE);
+    slot->received = length;
+    slot->file = nullptr;
+    memcpy(slot->data, payload, slot->length);
+    slot->data[slot->length] = 0;
+    publish();
+    return true;
+}
+
+bool MessageRing::pushFile(const char *path, uint32_t length)
+{
+    MessageSlot *slot = claim();
+    if (!slot)
+        return false;
+    slot->length = 0;
+    slot->received = length;
+    slot->file = path;
+    slot->data[0] = 0;
+    publish();
+    return true;
+}
+
+const char *MessageRing::nextFile()
+{
+    uint8_t head = m_head.load(std::memory_order_relaxed);
+    if ((head + 1) % MESSAGE_RING_SLOTS == m_tail.load(std::memory_order_acquire))
+        return nullptr;
+    return m_files[head];
+}
+
+const MessageSlot *MessageRing::peek()
+{
+    uint8_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire))
+        return nullptr;
+    return &m_slots[tail];
+}
+
+void MessageRing::pop()
+{
+    uint8_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire))
+        return;
+    m_tail.store((tail + 1) % MESSAGE_RING_SLOTS, std::memory_order_release);
+}
@@ -0,0 +1,149 @@
+#include "mqtt_connection.h"
+
+#include "topic_router.h"
+#define LOG_MODULE "mqtt"
+#include "logger.h"
+
+MqttConnection::MqttConnection(PubSubClient &client) : m_client(client),
+    m_state(Offline),
+    m_clientId(),
+    m_router(nullptr),
+    m_announceTopic(),
+    m_backoffMs(MQTT_BACKOFF_MIN_MS),
+    m_nextAttemptMs(0),
+    m_disconnectedSinceMs(0),
+    m_stats(),
+    m_onOnline(nullptr)
+{
+}
+
+void MqttConnection::begin(const char *clientId, TopicRouter &router, const char *announceTopic)
+{
+    strncpy(m_clientId, clientId, sizeof(m_clientId) - 1);
+    m_router = &router;
+    strncpy(m_announceTopic, announceTopic, sizeof(m_announceTopic) - 1);
+}
+
+uint32_t MqttConnection::currentOutageMs()
+{
+    return m_state == Online ? 0 : millis() - m_disconnectedSinceMs;
+}
+
+void MqttConnection::setState(State state)
+{
+    m_state = state;
+    LOG_DEBUG("state %d", (int)state);
+}
+
+void MqttConnection::lost()
+{
+    m_disconnectedSinceMs = millis();
+    m_backoffMs = MQTT_BACKOFF_MIN_MS;
+}
+
+void MqttConnection::retryLater()
+{
+    // equal jitter: wait between half and all of the current backoff
+    uint32_t wait = m_backoffMs / 2 + random(m_backoffMs / 2 + 1);
+    m_nextAttemptMs = millis() + wait;
+    m_backoffMs = min((uint32_t)MQTT_BACKOFF_MAX_MS, m_backoffMs * 2);
+    setState(Waiting);
+    LOG_INFO("retry in %lu ms", (unsigned long)wait);
+}
+
+void MqttConnection::connect()
+{
+    ++m_stats.attempts;
+    uint32_t start = micros();
+    bool ok = m_client.connect(m_clientId);
+    uint32_t handshakeUs = micros() - start;
+
+    m_stats.lastHandshakeUs = handshakeUs;
+    m_stats.maxHandshakeUs = max(m_stats.maxHandshakeUs, handshakeUs);
+    m_stats.totalHandshakeUs += handshakeUs;
+
+    if (ok)
+    {
+        setState(Subscribing);
+        return;
+    }
+    ++m_stats.failures;
+    LOG_WARN("connect failed, rc=%d", m_client.state());
+    retryLater();
+}
+
+void MqttConnection::loop()
+{
+    if (WiFi.status() != WL_CONNECTED)
+    {
+        if (m_state == Online)
+            lost();
+        if (m_state != Offline)
+            setState(Offline);
+        return;
+    }
+
+    switch (m_state)
+    {
+    case Offline:
+        // Wi-Fi is back, try straight away whatever the backoff was
+        m_backoffMs = MQTT_BACKOFF_MIN_MS;
+        m_nextAttemptMs = millis();
+        setState(Waiting);
+        break;
+
+    case Waiting:
+        if ((int32_t)(millis() - m_nextAttemptMs) >= 0)
+            setState(Connecting);
+        break;
+
+    case Connecting:
+        connect();
+        break;
+
+    case Subscribing:
+        // the broker starts every session without them
+        if (m_router->subscribeAll(m_client))
+        {
+            setState(Announcing);
+        }
+        else
+        {
+            // connect() would keep the half-subscribed session, start
+            // over with a new one
+            m_client.disconnect();
+            retryLater();
+        }
+        break;
+
+    case Announcing:
+        if (m_client.publish(m_announceTopic, m_clientId))
+        {
+            m_stats.disconnectedMs += millis() - m_disconnectedSinceMs;
+            m_backoffMs = MQTT_BACKOFF_MIN_MS;
+            setState(Online);
+            LOG_INFO("online after %lu attempts, handshake %lu us", (unsigned long)m_stats.attempts,
+                     (unsigned long)m_stats.lastHandshakeUs);
+            if (m_onOnline)
+                m_onOnline();
+        }
+        else
+        {
+            m_client.disconnect();
+            retryLater();
+        }
+        break;
+
+    case Online:
+        if (!m_client.connected())
+        {
+            lost();
+            // the first reconnect after a drop goes out immediately
+            m_nextAttemptMs = millis();
+            setState(Waiting);
+            break;
+        }
+        m_client.loop();
+        break;
+    }
+}
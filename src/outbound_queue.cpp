@@ -0,0 +1,357 @@
+#include "outbound_queue.h"
+
+#include "crc32.h"
+#define LOG_MODULE "outbox"
+#include "logger.h"
+
+OutboundQueue::OutboundQueue(MqttConnection &connection, const char *spoolPath) : m_connection(connection),
+    m_spoolPath(spoolPath),
+    m_cursor(0),
+    m_end(0),
+    m_pending(0),
+    m_batch(0),
+    m_messagesPerSecond(0),
+    m_bytesPerSecond(0),
+    m_messageCredit(0),
+    m_byteCredit(0),
+    m_refilledMs(0),
+    m_stats()
+{
+    setLimits(OUTBOX_BATCH, OUTBOX_MESSAGES_PER_SECOND, OUTBOX_BYTES_PER_SECOND);
+}
+
+void OutboundQueue::setLimits(uint8_t batch, uint16_t messagesPerSecond, uint32_t bytesPerSecond)
+{
+    m_batch = batch;
+    m_messagesPerSecond = messagesPerSecond;
+    m_bytesPerSecond = min(bytesPerSecond, (uint32_t)1000000);
+    // a full second's worth to start with
+    m_messageCredit = (int32_t)m_messagesPerSecond * 1000;
+    m_byteCredit = (int32_t)m_bytesPerSecond * 1000;
+    m_refilledMs = millis();
+}
+
+void OutboundQueue::refill()
+{
+    uint32_t now = millis();
+    uint32_t elapsed = min(now - m_refilledMs, (uint32_t)1000);
+    m_refilledMs = now;
+    m_messageCredit = min(m_messageCredit + (int32_t)(elapsed * m_messagesPerSecond),
+                          (int32_t)m_messagesPerSecond * 1000);
+    m_byteCredit = min(m_byteCredit + (int32_t)(elapsed * m_bytesPerSecond), (int32_t)m_bytesPerSecond * 1000);
+}
+
+// a message goes while there is credit left, a large one can overdraw the
+// bytes and so waits out the debt before the next
+bool OutboundQueue::take(uint32_t bytes)
+{
+    refill();
+    if (m_messagesPerSecond && m_messageCredit < 1000)
+        return false;
+    if (m_bytesPerSecond && m_byteCredit <= 0)
+        return false;
+    if (m_messagesPerSecond)
+        m_messageCredit -= 1000;
+    if (m_bytesPerSecond)
+        m_byteCredit -= (int32_t)min(bytes, (uint32_t)OUTBOX_MAX_BYTES) * 1000;
+    return true;
+}
+
+bool OutboundQueue::readRecord(File &f, OutboxRecord &record, char *topic)
+{
+    if (f.read((uint8_t *)&record, sizeof(record)) != sizeof(record))
+        return false;
+    if (record.type == OUTBOX_SENT)
+        return record.crc == crc32((const uint8_t *)&record.length, sizeof(record.length));
+    if (record.type != OUTBOX_MESSAGE || record.topicLength >= MQTT_TOPIC_LEN || record.length > OUTBOX_MAX_BYTES)
+        return false;
+    if (f.read((uint8_t *)topic, record.topicLength) != record.topicLength)
+        return false;
+    topic[record.topicLength] = 0;
+    return true;
+}
+
+bool OutboundQueue::checkPayload(File &f, const OutboxRecord &record, const char *topic)
+{
+    uint8_t chunk[OUTBOX_CHUNK_SIZE];
+    uint32_t crc = crc32((const uint8_t *)topic, record.topicLength);
+    for (uint32_t left = record.length; left;)
+    {
+        size_t n = f.read(chunk, min(left, (uint32_t)sizeof(chunk)));
+        if (!n)
+            return false;
+        crc = crc32(chunk, n, crc);
+        left -= n;
+    }
+    return crc == record.crc;
+}
+
+bool OutboundQueue::begin()
+{
+    m_cursor = 0;
+    m_end = 0;
+    m_pending = 0;
+    // the spool is only removed once its compacted copy is whole, so a copy
+    // without it is finished, and one beside it was cut short
+    char tmpPath[32];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", m_spoolPath);
+    if (SPIFFS.exists(tmpPath))
+    {
+        if (SPIFFS.exists(m_spoolPath))
+            SPIFFS.remove(tmpPath);
+        else
+            SPIFFS.rename(tmpPath, m_spoolPath);
+    }
+
+    File f = SPIFFS.open(m_spoolPath, "r");
+    if (!f)
+        return true;
+
+    // the last sent mark, and where the whole records end
+    uint32_t size = f.size();
+    OutboxRecord record;
+    char topic[MQTT_TOPIC_LEN];
+    while (m_end < size && readRecord(f, record, topic))
+    {
+        if (record.type == OUTBOX_MESSAGE && !checkPayload(f, record, topic))
+            break;
+        if (record.type == OUTBOX_SENT)
+            m_cursor = record.length;
+        m_end = f.position();
+    }
+    m_cursor = min(m_cursor, m_end);
+
+    f.seek(m_cursor);
+    while (f.position() < m_end && readRecord(f, record, topic))
+    {
+        if (record.type != OUTBOX_MESSAGE)
+            continue;
+        ++m_pending;
+        f.seek(record.length, SeekCur);
+    }
+    f.close();
+
+    if (!m_pending)
+    {
+        SPIFFS.remove(m_spoolPath);
+        m_cursor = 0;
+        m_end = 0;
+        return true;
+    }
+    LOG_INFO("%lu messages left from before the restart", (unsigned long)m_pending);
+    // anything appended after a torn record would be lost with it
+    if (m_end < size)
+    {
+        LOG_WARN("dropping %lu B of a torn record", (unsigned long)(size - m_end));
+        return compact();
+    }
+    return true;
+}
+
+// rewrites the messages still owed into a new spool, sent marks and all
+// that went before them left behind
+bool OutboundQueue::compact()
+{
+    char tmpPath[32];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", m_spoolPath);
+    File in = SPIFFS.open(m_spoolPath, "r");
+    File out = SPIFFS.open(tmpPath, "w");
+    bool ok = in && out && in.seek(m_cursor);
+
+    OutboxRecord record;
+    char topic[MQTT_TOPIC_LEN];
+    uint8_t chunk[OUTBOX_CHUNK_SIZE];
+    uint32_t end = 0;
+    while (ok && in.position() < m_end && readRecord(in, record, topic))
+    {
+        if (record.type != OUTBOX_MESSAGE)
+            continue;
+        ok = out.write((const uint8_t *)&record, sizeof(record)) == sizeof(record) &&
+             out.write((const uint8_t *)topic, record.topicLength) == record.topicLength;
+        for (uint32_t left = record.length; ok && left;)
+        {
+            size_t n = in.read(chunk, min(left, (uint32_t)sizeof(chunk)));
+            ok = n && out.write(chunk, n) == n;
+            left -= n;
+        }
+        end += sizeof(record) + record.topicLength + record.length;
+    }
+    in.close();
+    out.close();
+
+    // the spool stays as it is until there is a whole copy to replace it
+    if (!ok)
+    {
+        LOG_ERROR("could not compact the spool, left as it is");
+        SPIFFS.remove(tmpPath);
+        return false;
+    }
+    SPIFFS.remove(m_spoolPath);
+    if (!SPIFFS.rename(tmpPath, m_spoolPath))
+    {
+        LOG_ERROR("could not rename the compacted spool, %lu messages lost", (unsigned long)m_pending);
+        SPIFFS.remove(tmpPath);
+        m_pending = 0;
+        end = 0;
+        ok = false;
+    }
+    m_cursor = 0;
+    m_end = end;
+    return ok;
+}
+
+bool OutboundQueue::send(const char *topic, const uint8_t *payload, uint32_t length)
+{
+    PubSubClient &client = m_connection.client();
+    // fixed header, topic length and topic
+    if (5 + 2 + strlen(topic) + length <= client.getBufferSize())
+        return client.publish(topic, payload, length);
+    if (!client.beginPublish(topic, length, false))
+        return false;
+    return client.write(payload, length) == length && client.endPublish();
+}
+
+bool OutboundQueue::spool(const char *topic, const uint8_t *payload, uint32_t length)
+{
+    size_t topicLength = strlen(topic);
+    uint32_t size = sizeof(OutboxRecord) + topicLength + length;
+    if (topicLength >= MQTT_TOPIC_LEN)
+    {
+        ++m_stats.dropped;
+        return false;
+    }
+    // make room from what has been sent already
+    if (m_end + size > OUTBOX_MAX_BYTES && m_cursor)
+        compact();
+    if (m_end + size > OUTBOX_MAX_BYTES)
+    {
+        ++m_stats.dropped;
+        LOG_WARN("spool full, %lu B to %s dropped", (unsigned long)length, topic);
+        return false;
+    }
+
+    OutboxRecord record = {OUTBOX_MESSAGE, (uint8_t)topicLength, 0, length,
+                           crc32(payload, length, crc32((const uint8_t *)topic, topicLength))};
+    File f = SPIFFS.open(m_spoolPath, "a");
+    // a torn record a failed compaction left behind would take this one
+    // with it, so try again to drop it
+    if (f && f.size() != m_end)
+    {
+        f.close();
+        compact();
+        f = SPIFFS.open(m_spoolPath, "a");
+    }
+    bool ok = f && f.size() == m_end && f.write((const uint8_t *)&record, sizeof(record)) == sizeof(record) &&
+              f.write((const uint8_t *)topic, topicLength) == topicLength &&
+              f.write(payload, length) == length;
+    f.close();
+    if (!ok)
+    {
+        ++m_stats.dropped;
+        LOG_ERROR("could not spool %lu B to %s", (unsigned long)length, topic);
+        // the next record would go after what was half written
+        if (m_pending)
+        {
+            compact();
+        }
+        else
+        {
+            SPIFFS.remove(m_spoolPath);
+            m_end = 0;
+        }
+        return false;
+    }
+    m_end += size;
+    ++m_pending;
+    ++m_stats.spooled;
+    m_stats.maxSpoolBytes = max(m_stats.maxSpoolBytes, m_end);
+    return true;
+}
+
+bool OutboundQueue::publish(const char *topic, const uint8_t *payload, uint32_t length)
+{
+    // anything spooled goes first, so this one queues behind it
+    if (!m_pending && m_connection.isOnline() && take(length) && send(topic, payload, length))
+    {
+        ++m_stats.sent;
+        return true;
+    }
+    return spool(topic, payload, length);
+}
+
+bool OutboundQueue::markSent()
+{
+    OutboxRecord record = {OUTBOX_SENT, 0, 0, m_cursor, crc32((const uint8_t *)&m_cursor, sizeof(m_cursor))};
+    File f = SPIFFS.open(m_spoolPath, "a");
+    bool ok = f && f.size() == m_end && f.write((const uint8_t *)&record, sizeof(record)) == sizeof(record);
+    f.close();
+    // without the mark a restart sends the batch again, nothing is lost
+    if (ok)
+        m_end += sizeof(record);
+    return ok;
+}
+
+void OutboundQueue::service()
+{
+    if (!m_pending || !m_connection.isOnline())
+        return;
+    File f = SPIFFS.open(m_spoolPath, "r");
+    if (!f || !f.seek(m_cursor))
+    {
+        LOG_ERROR("spool gone, %lu messages lost", (unsigned long)m_pending);
+        m_pending = 0;
+    }
+
+    PubSubClient &client = m_connection.client();
+    OutboxRecord record;
+    char topic[MQTT_TOPIC_LEN];
+    uint8_t chunk[OUTBOX_CHUNK_SIZE];
+    uint8_t sent = 0;
+    while (m_pending && (!m_batch || sent < m_batch))
+    {
+        if (!readRecord(f, record, topic))
+        {
+            LOG_ERROR("spool unreadable at %lu, %lu messages lost", (unsigned long)m_cursor,
+                      (unsigned long)m_pending);
+            m_pending = 0;
+            break;
+        }
+        if (record.type == OUTBOX_SENT)
+        {
+            m_cursor = f.position();
+            continue;
+        }
+        if (!take(record.length))
+        {
+            ++m_stats.limited;
+            break;
+        }
+        bool ok = client.beginPublish(topic, record.length, false);
+        for (uint32_t left = record.length; ok && left;)
+        {
+            size_t n = f.read(chunk, min(left, (uint32_t)sizeof(chunk)));
+            ok = n && client.write(chunk, n) == n;
+            left -= n;
+        }
+        // the link went, the message stays first in line
+        if (!ok || !client.endPublish())
+            break;
+        m_cursor = f.position();
+        --m_pending;
+        ++sent;
+        ++m_stats.replayed;
+    }
+    f.close();
+
+    if (!m_pending)
+    {
+        SPIFFS.remove(m_spoolPath);
+        m_cursor = 0;
+        m_end = 0;
+        LOG_DEBUG("spool sent");
+    }
+    else if (sent)
+    {
+        markSent();
+    }
+}
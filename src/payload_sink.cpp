@@ -0,0 +1,92 @@
+#include "payload_sink.h"
+
+PayloadSink::PayloadSink(const char *spoolPath) : m_spoolPath(spoolPath),
+    m_spool(),
+    m_chunk(),
+    m_used(0),
+    m_size(0),
+    m_spilled(false),
+    m_failed(false)
+{
+}
+
+void PayloadSink::flushChunk()
+{
+    if (!m_spilled)
+    {
+        m_spool = SPIFFS.open(m_spoolPath, "w");
+        m_spilled = true;
+        m_failed = !m_spool;
+    }
+    if (!m_failed && m_spool.write(m_chunk, m_used) != m_used)
+        m_failed = true;
+    m_used = 0;
+}
+
+size_t PayloadSink::write(uint8_t b)
+{
+    if (m_used == PAYLOAD_CHUNK_SIZE)
+        flushChunk();
+    m_chunk[m_used++] = b;
+    ++m_size;
+    return 1;
+}
+
+size_t PayloadSink::write(const uint8_t *buffer, size_t size)
+{
+    size_t left = size;
+    while (left)
+    {
+        if (m_used == PAYLOAD_CHUNK_SIZE)
+            flushChunk();
+        size_t n = min(left, (size_t)(PAYLOAD_CHUNK_SIZE - m_used));
+        memcpy(m_chunk + m_used, buffer, n);
+        m_used += n;
+        buffer += n;
+        left -= n;
+    }
+    m_size += size;
+    return size;
+}
+
+void PayloadSink::reset()
+{
+    m_used = 0;
+    m_size = 0;
+    m_spilled = false;
+    m_failed = false;
+}
+
+bool PayloadSink::commit(const char *path)
+{
+    if (!m_spilled)
+    {
+        File f = SPIFFS.open(path, "w");
+        bool ok = f && f.write(m_chunk, m_used) == m_used;
+        f.close();
+        reset();
+        return ok;
+    }
+
+    flushChunk();
+    m_spool.close();
+    bool ok = !m_failed;
+    // SPIFFS will not rename over an existing file
+    if (SPIFFS.exists(path))
+        SPIFFS.remove(path);
+    ok = ok && SPIFFS.rename(m_spoolPath, path);
+    if (!ok)
+        SPIFFS.remove(m_spoolPath);
+    reset();
+    return ok;
+}
+
+void PayloadSink::discard()
+{
+    if (m_spilled)
+    {
+        m_spool.close();
+        SPIFFS.remove(m_spoolPath);
+    }
+    reset();
+}
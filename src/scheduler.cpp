@@ -0,0 +1,154 @@
+#include "scheduler.h"
+
+Scheduler::Scheduler(void) : m_tasks(),
+    m_count(0),
+    m_idle(nullptr),
+    m_idleUs(0),
+    m_statsSinceMs(0)
+{
+}
+
+int8_t Scheduler::add(const char *name, uint32_t periodUs, TaskFunction task)
+{
+    if (m_count >= SCHEDULER_MAX_TASKS)
+        return -1;
+    Task &t = m_tasks[m_count];
+    t.name = name;
+    t.function = task;
+    t.periodUs = periodUs;
+    // periodic tasks first run one period from now
+    t.dueUs = micros() + periodUs;
+    t.armed = periodUs != 0;
+    t.stats = TaskStats();
+    return m_count++;
+}
+
+int8_t Scheduler::every(const char *name, uint32_t periodMs, TaskFunction task)
+{
+    return add(name, max(periodMs, (uint32_t)1) * 1000, task);
+}
+
+int8_t Scheduler::deadline(const char *name, TaskFunction task)
+{
+    return add(name, 0, task);
+}
+
+void Scheduler::runIn(uint8_t id, uint32_t delayMs)
+{
+    if (id >= m_count)
+        return;
+    uint32_t due = micros() + delayMs * 1000;
+    // an earlier request for the same task stands
+    if (m_tasks[id].armed && (int32_t)(m_tasks[id].dueUs - due) <= 0)
+        return;
+    m_tasks[id].dueUs = due;
+    m_tasks[id].armed = true;
+}
+
+void Scheduler::cancel(uint8_t id)
+{
+    if (id < m_count)
+        m_tasks[id].armed = false;
+}
+
+// earliest due task that has not run in this pass, -1 if none is due
+int8_t Scheduler::nextDue(uint32_t now, uint16_t ranMask)
+{
+    int8_t best = -1;
+    for (uint8_t i = 0; i < m_count; ++i)
+    {
+        const Task &t = m_tasks[i];
+        if (!t.armed || (ranMask & (1 << i)) || (int32_t)(now - t.dueUs) < 0)
+            continue;
+        if (best < 0 || (int32_t)(t.dueUs - m_tasks[best].dueUs) < 0)
+            best = i;
+    }
+    return best;
+}
+
+uint32_t Scheduler::untilNext(uint32_t now)
+{
+    uint32_t wait = SCHEDULER_IDLE;
+    for (uint8_t i = 0; i < m_count; ++i)
+    {
+        const Task &t = m_tasks[i];
+        if (!t.armed)
+            continue;
+        int32_t left = (int32_t)(t.dueUs - now);
+        wait = min(wait, left > 0 ? (uint32_t)left : 0);
+    }
+    return wait;
+}
+
+void Scheduler::run()
+{
+    uint16_t ran = 0;
+    int8_t id;
+    while ((id = nextDue(micros(), ran)) >= 0)
+    {
+        Task &t = m_tasks[id];
+        ran |= 1 << id;
+
+        uint32_t start = micros();
+        uint32_t late = start - t.dueUs;
+        if (t.periodUs)
+        {
+            t.dueUs += t.periodUs;
+            // more than a period behind: drop the missed runs instead of
+            // running back to back to catch up
+            if ((int32_t)(start - t.dueUs) >= 0)
+                t.dueUs = start + t.periodUs;
+        }
+        else
+        {
+            t.armed = false;
+        }
+
+        t.function();
+
+        uint32_t took = micros() - start;
+        ++t.stats.runs;
+        t.stats.maxLateUs = max(t.stats.maxLateUs, late);
+        t.stats.totalLateUs += late;
+        t.stats.maxRunUs = max(t.stats.maxRunUs, took);
+    }
+
+    bool more = m_idle && m_idle();
+
+    uint32_t now = micros();
+    uint32_t wait = untilNext(now);
+    if (more)
+        wait = min(wait, (uint32_t)1000);
+    if (wait >= 1000)
+    {
+        // whole milliseconds only, the remainder is spent on the next pass
+        delay(min(wait, (uint32_t)1000000) / 1000);
+        m_idleUs += micros() - now;
+    }
+    else
+    {
+        yield();
+    }
+}
+
+void Scheduler::printStats(Print &out)
+{
+    uint32_t elapsedMs = millis() - m_statsSinceMs;
+    out.printf("scheduler over %lu ms, idle %lu%%\n", (unsigned long)elapsedMs,
+               elapsedMs ? (unsigned long)(m_idleUs / 10 / elapsedMs) : 0UL);
+    for (uint8_t i = 0; i < m_count; ++i)
+    {
+        const TaskStats &s = m_tasks[i].stats;
+        out.printf("  %-10s runs %6lu  late avg %6lu us max %7lu us  run max %7lu us\n", m_tasks[i].name,
+                   (unsigned long)s.runs, s.runs ? (unsigned long)(s.totalLateUs / s.runs) : 0UL,
+                   (unsigned long)s.maxLateUs, (unsigned long)s.maxRunUs);
+    }
+}
+
+void Scheduler::resetStats()
+{
+    for (uint8_t i = 0; i < m_count; ++i)
+        m_tasks[i].stats = TaskStats();
+    m_idleUs = 0;
+    m_statsSinceMs = millis();
+}
@@ -1,21 +1,15 @@
 #include "select_box.h"
-#define SERIAL_DEBUG
-#include "SerialDebug.h"
+#define LOG_MODULE "select"
+#include "logger.h"
 
 
-TFT_Select_Box::TFT_Select_Box(void) : m_x(),
-    m_y(0),
-    m_w(0),
-    m_h(0),
-    m_outlinecolor(TFT_BLACK),
+TFT_Select_Box::TFT_Select_Box(void) : m_outlinecolor(TFT_BLACK),
     m_fillcolor(TFT_WHITE),
     m_textcolor(TFT_BLACK),
     m_selectcolor(TFT_GREEN),
     m_textsize(1),
     m_textdatum(MC_DATUM),
-    m_tft(nullptr),
-    m_laststate(false),
-    m_currstate(false),
+    m_useSprite(true),
     m_selected(false),
     m_label(nullptr)
 {
@@ -25,10 +19,7 @@ void TFT_Select_Box::init(TFT_eSPI *gfx, int16_t x, int16_t y, int16_t w, int16_
             uint16_t outline, uint16_t fill, uint16_t textcolor, uint16_t selectcolor,
             String *label, uint8_t textsize)
 {
-    m_x = x;
-    m_y = y;
-    m_w = w;
-    m_h = h;
+    setBounds(x, y, w, h);
     m_tft = gfx;
     m_outlinecolor = outline;
     m_fillcolor = fill;
@@ -36,22 +27,51 @@ void TFT_Select_Box::init(TFT_eSPI *gfx, int16_t x, int16_t y, int16_t w, int16_
     m_textcolor = textcolor;
     m_textsize = textsize;
     m_label = label;
+    m_opaque = true;
 }
 
 void TFT_Select_Box::draw()
 {
-    m_tft->fillRect(m_x, m_y, m_w, m_h, m_fillcolor);
-    SerialDebug("selected");
-    SerialDebug(m_selected);
-    SerialDebug("\n");
+    LOG_DEBUG("draw, selected %d", m_selected);
+
+    if (!drawSprite())
+        drawDirect();
+}
+
+bool TFT_Select_Box::drawSprite()
+{
+    if (!m_useSprite || m_bounds.area() * 2 > SELECT_BOX_SPRITE_BUDGET)
+        return false;
+
+    TFT_eSprite sprite(m_tft);
+    if (!sprite.createSprite(m_bounds.w, m_bounds.h))
+        return false;
+
+    sprite.fillSprite(m_fillcolor);
+    sprite.drawRect(0, 0, m_bounds.w, m_bounds.h, m_selected ? m_selectcolor : m_outlinecolor);
+
+    // the sprite has its own text state, the panel's is left alone
+    sprite.setTextFont(m_tft->textfont);
+    sprite.setTextSize(m_textsize);
+    sprite.setTextColor(m_textcolor, m_fillcolor);
+    sprite.setTextDatum(m_textdatum);
+    sprite.drawString(*m_label, m_bounds.w / 2, m_bounds.h / 2);
+
+    sprite.pushSprite(m_bounds.x, m_bounds.y);
+    return true;
+}
+
+void TFT_Select_Box::drawDirect()
+{
+    m_tft->fillRect(m_bounds.x, m_bounds.y, m_bounds.w, m_bounds.h, m_fillcolor);
 
     if (m_selected)
     {
-        m_tft->drawRect(m_x, m_y, m_w, m_h, m_selectcolor);
+        m_tft->drawRect(m_bounds.x, m_bounds.y, m_bounds.w, m_bounds.h, m_selectcolor);
     }
     else
     {
-        m_tft->drawRect(m_x, m_y, m_w, m_h, m_outlinecolor);
+        m_tft->drawRect(m_bounds.x, m_bounds.y, m_bounds.w, m_bounds.h, m_outlinecolor);
     }
 
     m_tft->setTextSize(m_textsize);
@@ -62,7 +82,7 @@ void TFT_Select_Box::draw()
     uint16_t tempPadding = m_tft->padX;
     m_tft->setTextPadding(0);
 
-    m_tft->drawString(*m_label, m_x + (m_w / 2), m_y + (m_h / 2));
+    m_tft->drawString(*m_label, m_bounds.x + (m_bounds.w / 2), m_bounds.y + (m_bounds.h / 2));
 
     m_tft->setTextDatum(tempdatum);
     m_tft->setTextPadding(tempPadding);
@@ -0,0 +1,155 @@
+#include "stroke_codec.h"
+
+static uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+StrokeEncoder::StrokeEncoder(uint8_t *buffer, uint32_t capacity) : m_buffer(buffer),
+    m_capacity(capacity),
+    m_length(0),
+    m_x(0),
+    m_y(0),
+    m_inStroke(false),
+    m_overflow(false)
+{
+    put(STROKE_MAGIC);
+    put(STROKE_VERSION);
+}
+
+void StrokeEncoder::put(uint8_t b)
+{
+    if (m_length >= m_capacity)
+    {
+        m_overflow = true;
+        return;
+    }
+    m_buffer[m_length++] = b;
+}
+
+void StrokeEncoder::putVarint(uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        put((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    put((uint8_t)value);
+}
+
+bool StrokeEncoder::beginStroke(uint16_t colour, uint8_t width, int16_t x, int16_t y)
+{
+    if (m_inStroke)
+        endStroke();
+    put(colour & 0xFF);
+    put(colour >> 8);
+    put(width);
+    putVarint((uint16_t)x);
+    putVarint((uint16_t)y);
+    m_x = x;
+    m_y = y;
+    m_inStroke = true;
+    return !m_overflow;
+}
+
+bool StrokeEncoder::addPoint(int16_t x, int16_t y)
+{
+    if (!m_inStroke)
+        return false;
+    if (x == m_x && y == m_y)
+        return !m_overflow;
+    putVarint(zigzag(x - m_x));
+    putVarint(zigzag(y - m_y));
+    m_x = x;
+    m_y = y;
+    return !m_overflow;
+}
+
+bool StrokeEncoder::endStroke()
+{
+    if (!m_inStroke)
+        return !m_overflow;
+    put(0);
+    put(0);
+    m_inStroke = false;
+    return !m_overflow;
+}
+
+StrokeDecoder::StrokeDecoder(const uint8_t *data, uint32_t length) : m_data(data),
+    m_length(length),
+    m_pos(2),
+    m_x(0),
+    m_y(0),
+    m_inStroke(false),
+    m_error(length < 2 || data[0] != STROKE_MAGIC || data[1] != STROKE_VERSION)
+{
+}
+
+bool StrokeDecoder::get(uint8_t &b)
+{
+    if (m_pos >= m_length)
+    {
+        m_error = true;
+        return false;
+    }
+    b = m_data[m_pos++];
+    return true;
+}
+
+bool StrokeDecoder::getVarint(uint32_t &value)
+{
+    value = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7)
+    {
+        uint8_t b;
+        if (!get(b))
+            return false;
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    m_error = true;
+    return false;
+}
+
+bool StrokeDecoder::nextStroke(uint16_t &colour, uint8_t &width, int16_t &x, int16_t &y)
+{
+    // skip whatever the caller did not read of the previous stroke
+    int16_t px, py;
+    while (m_inStroke && nextPoint(px, py))
+        ;
+    if (m_error || m_pos >= m_length)
+        return false;
+
+    uint8_t lo, hi;
+    uint32_t ux, uy;
+    if (!get(lo) || !get(hi) || !get(width) || !getVarint(ux) || !getVarint(uy))
+        return false;
+    colour = lo | (hi << 8);
+    m_x = x = (int16_t)ux;
+    m_y = y = (int16_t)uy;
+    m_inStroke = true;
+    return true;
+}
+
+bool StrokeDecoder::nextPoint(int16_t &x, int16_t &y)
+{
+    if (!m_inStroke || m_error)
+        return false;
+    uint32_t dx, dy;
+    if (!getVarint(dx) || !getVarint(dy))
+        return false;
+    if (dx == 0 && dy == 0)
+    {
+        m_inStroke = false;
+        return false;
+    }
+    m_x = x = m_x + unzigzag(dx);
+    m_y = y = m_y + unzigzag(dy);
+    return true;
+}
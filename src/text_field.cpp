@@ -0,0 +1,221 @@
+#include "text_field.h"
+
+#define TEXT_FIELD_UNDAMAGED 0xFF
+
+TFT_Text_Field::TFT_Text_Field(void) : m_outlinecolor(TFT_BLACK),
+    m_fillcolor(TFT_WHITE),
+    m_textcolor(TFT_BLACK),
+    m_selectcolor(TFT_GREEN),
+    m_textsize(1),
+    m_font(2),
+    m_masked(false),
+    m_selected(false),
+    m_text(),
+    m_advance(),
+    m_maskAdvance(0),
+    m_length(0),
+    m_first(0),
+    m_drawnFirst(0),
+    m_drawnRight(0),
+    m_drawnSelected(false),
+    m_drawn(false),
+    m_damagedFrom(TEXT_FIELD_UNDAMAGED)
+{
+}
+
+void TFT_Text_Field::init(TFT_eSPI *gfx, int16_t x, int16_t y, int16_t w, int16_t h,
+                          uint16_t outline, uint16_t fill, uint16_t textcolor, uint16_t selectcolor,
+                          uint8_t textsize, uint8_t font)
+{
+    m_tft = gfx;
+    m_opaque = true;
+    setBounds(x, y, w, h);
+    m_outlinecolor = outline;
+    m_fillcolor = fill;
+    m_textcolor = textcolor;
+    m_selectcolor = selectcolor;
+    m_textsize = textsize;
+    m_font = font;
+    m_drawn = false;
+
+    // text set before init() has not been measured yet
+    m_maskAdvance = measure(TEXT_FIELD_MASK);
+    for (uint8_t i = 0; i < m_length; ++i)
+        m_advance[i] = measure(m_text[i]);
+    m_first = 0;
+    scroll();
+}
+
+void TFT_Text_Field::prepareText()
+{
+    m_tft->setTextSize(m_textsize);
+    m_tft->setTextColor(m_textcolor, m_fillcolor);
+}
+
+uint8_t TFT_Text_Field::measure(char c)
+{
+    if (!m_tft)
+        return 0;
+    char glyph[2] = {c, 0};
+    m_tft->setTextSize(m_textsize);
+    return m_tft->textWidth(glyph, m_font);
+}
+
+int16_t TFT_Text_Field::textTop()
+{
+    return m_bounds.y + (m_bounds.h - m_tft->fontHeight(m_font)) / 2;
+}
+
+int16_t TFT_Text_Field::glyphX(uint8_t i)
+{
+    int16_t x = textLeft();
+    for (uint8_t k = m_first; k < i; ++k)
+        x += advance(k);
+    return x;
+}
+
+void TFT_Text_Field::damage(uint8_t from)
+{
+    m_damagedFrom = min(m_damagedFrom, from);
+    changed();
+}
+
+// keeps the end of the text in view, true if the visible part moved
+bool TFT_Text_Field::scroll()
+{
+    if (!m_tft)
+        return false;
+    bool overflow = glyphX(m_length) > textRight();
+    bool hidden = m_first > 0 && m_length <= m_first;
+    if (!overflow && !hidden)
+        return false;
+
+    // leave half the field free so the next keystrokes draw incrementally
+    int16_t room = (textRight() - textLeft()) / 2;
+    uint8_t first = m_length;
+    int16_t width = 0;
+    while (first > 0 && width + advance(first - 1) <= room)
+        width += advance(--first);
+    bool moved = first != m_first;
+    m_first = first;
+    return moved;
+}
+
+bool TFT_Text_Field::append(char c)
+{
+    if (m_length >= TEXT_FIELD_CAPACITY || c == 0)
+        return false;
+    m_advance[m_length] = measure(c);
+    m_text[m_length++] = c;
+    m_text[m_length] = 0;
+    damage(m_length - 1);
+    scroll();
+    return true;
+}
+
+bool TFT_Text_Field::append(const char *text)
+{
+    while (*text)
+    {
+        if (!append(*text++))
+            return false;
+    }
+    return true;
+}
+
+void TFT_Text_Field::erase()
+{
+    if (m_length == 0)
+        return;
+    m_text[--m_length] = 0;
+    damage(m_length);
+    scroll();
+}
+
+void TFT_Text_Field::clear()
+{
+    m_length = 0;
+    m_text[0] = 0;
+    m_first = 0;
+    damage(0);
+}
+
+void TFT_Text_Field::setText(const char *text)
+{
+    clear();
+    append(text);
+}
+
+void TFT_Text_Field::setMasked(bool masked)
+{
+    if (masked == m_masked)
+        return;
+    m_masked = masked;
+    m_drawn = false;
+    changed();
+    m_first = 0;
+    scroll();
+}
+
+void TFT_Text_Field::setSelected(bool selected)
+{
+    if (selected == m_selected)
+        return;
+    m_selected = selected;
+    changed();
+}
+
+void TFT_Text_Field::drawGlyphs(uint8_t from)
+{
+    int16_t x = glyphX(from);
+    int16_t y = textTop();
+    for (uint8_t i = from; i < m_length; ++i)
+    {
+        m_tft->drawChar(m_masked ? TEXT_FIELD_MASK : m_text[i], x, y, m_font);
+        x += advance(i);
+    }
+}
+
+void TFT_Text_Field::draw()
+{
+    m_tft->fillRect(m_bounds.x, m_bounds.y, m_bounds.w, m_bounds.h, m_fillcolor);
+    m_tft->drawRect(m_bounds.x, m_bounds.y, m_bounds.w, m_bounds.h, m_selected ? m_selectcolor : m_outlinecolor);
+    prepareText();
+    drawGlyphs(m_first);
+
+    m_drawn = true;
+    m_drawnSelected = m_selected;
+    m_drawnFirst = m_first;
+    m_drawnRight = glyphX(m_length);
+    m_damagedFrom = TEXT_FIELD_UNDAMAGED;
+}
+
+void TFT_Text_Field::update()
+{
+    if (!m_drawn || m_first != m_drawnFirst)
+    {
+        draw();
+        return;
+    }
+
+    if (m_selected != m_drawnSelected)
+    {
+        m_tft->drawRect(m_bounds.x, m_bounds.y, m_bounds.w, m_bounds.h, m_selected ? m_selectcolor : m_outlinecolor);
+        m_drawnSelected = m_selected;
+    }
+
+    if (m_damagedFrom == TEXT_FIELD_UNDAMAGED)
+        return;
+
+    // glyphs are drawn over their own background, only the cells past the
+    // new end need clearing
+    prepareText();
+    int16_t right = glyphX(m_length);
+    if (right < m_drawnRight)
+        m_tft->fillRect(right, textTop(), m_drawnRight - right, m_tft->fontHeight(m_font), m_fillcolor);
+    if (m_damagedFrom < m_length)
+        drawGlyphs(m_damagedFrom);
+
+    m_drawnRight = right;
+    m_damagedFrom = TEXT_FIELD_UNDAMAGED;
+}
@@ -0,0 +1,94 @@
+#include "text_layout.h"
+
+TextLayout::TextLayout(void) : m_tft(nullptr),
+    m_font(0),
+    m_textsize(0),
+    m_lineHeight(0),
+    m_advance(),
+    m_text(""),
+    m_starts(),
+    m_lines(0),
+    m_truncated(false)
+{
+}
+
+void TextLayout::setFont(TFT_eSPI *gfx, uint8_t font, uint8_t textsize)
+{
+    if (gfx == m_tft && font == m_font && textsize == m_textsize)
+        return;
+    m_tft = gfx;
+    m_font = font;
+    m_textsize = textsize;
+
+    m_tft->setTextSize(textsize);
+    char glyph[2] = {0, 0};
+    for (uint8_t i = 0; i < TEXT_LAYOUT_GLYPHS; ++i)
+    {
+        glyph[0] = TEXT_LAYOUT_FIRST_GLYPH + i;
+        m_advance[i] = m_tft->textWidth(glyph, font);
+    }
+    m_lineHeight = m_tft->fontHeight(font);
+}
+
+uint16_t TextLayout::layout(const char *text, uint16_t length, int16_t width)
+{
+    m_text = text;
+    m_lines = 0;
+    m_truncated = false;
+
+    uint16_t i = 0;
+    while (i < length)
+    {
+        if (m_lines == TEXT_LAYOUT_MAX_LINES)
+        {
+            m_truncated = true;
+            break;
+        }
+        uint16_t start = i;
+        m_starts[m_lines++] = start;
+
+        // just after the last space, where the line can break
+        uint16_t breakAt = start;
+        uint16_t next = length;
+        int32_t x = 0;
+        for (; i < length; ++i)
+        {
+            char c = text[i];
+            if (c == '\n')
+            {
+                next = i + 1;
+                break;
+            }
+            // spaces never push a line over, they hang off its end
+            if (c == ' ' || c == '\t')
+            {
+                x += m_advance[0];
+                breakAt = i + 1;
+                continue;
+            }
+            x += advance(c);
+            // a line holds at least one glyph however narrow
+            if (x > width && i > start)
+            {
+                next = breakAt > start ? breakAt : i;
+                break;
+            }
+        }
+        i = next;
+    }
+    m_starts[m_lines] = i;
+    return m_lines;
+}
+
+uint16_t TextLayout::lineLength(uint16_t i) const
+{
+    uint16_t start = m_starts[i];
+    uint16_t end = m_starts[i + 1];
+    for (; end > start; --end)
+    {
+        char c = m_text[end - 1];
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
+            break;
+    }
+    return end - start;
+}
@@ -0,0 +1,76 @@
+#include "text_view.h"
+
+TFT_Text_View::TFT_Text_View(void) : m_textcolor(TFT_WHITE),
+    m_fillcolor(TFT_BLACK),
+    m_font(1),
+    m_textsize(1),
+    m_first(0)
+{
+    m_opaque = true;
+}
+
+void TFT_Text_View::init(TFT_eSPI *gfx, int16_t x, int16_t y, int16_t w, int16_t h,
+                         uint16_t textcolor, uint16_t fill, uint8_t font, uint8_t textsize)
+{
+    m_tft = gfx;
+    m_textcolor = textcolor;
+    m_fillcolor = fill;
+    m_font = font;
+    m_textsize = textsize;
+    setBounds(x, y, w, h);
+    m_layout.setFont(gfx, font, textsize);
+}
+
+void TFT_Text_View::setText(const char *text, uint16_t length)
+{
+    m_layout.layout(text, length, m_bounds.w);
+    m_first = 0;
+    invalidate();
+}
+
+uint16_t TFT_Text_View::visibleLines() const
+{
+    return m_layout.lineHeight() ? m_bounds.h / m_layout.lineHeight() : 0;
+}
+
+void TFT_Text_View::scrollTo(uint16_t line)
+{
+    uint16_t last = m_layout.lines() > visibleLines() ? m_layout.lines() - visibleLines() : 0;
+    line = min(line, last);
+    if (line == m_first)
+        return;
+    m_first = line;
+    invalidate();
+}
+
+void TFT_Text_View::paint(const TFT_Rect &clip)
+{
+    int16_t lineHeight = m_layout.lineHeight();
+    int16_t right = m_bounds.x + m_bounds.w;
+    int16_t bottom = clip.y + clip.h;
+    m_tft->setTextSize(m_textsize);
+    m_tft->setTextColor(m_textcolor, m_fillcolor);
+
+    // the rows clip reaches, each drawn across the view with its fill
+    uint16_t row = lineHeight ? (clip.y - m_bounds.y) / lineHeight : 0;
+    int16_t y = m_bounds.y + row * lineHeight;
+    for (uint16_t rows = visibleLines(); row < rows && y < bottom; ++row, y += lineHeight)
+    {
+        uint16_t line = m_first + row;
+        int16_t x = m_bounds.x;
+        if (line < m_layout.lines())
+        {
+            const char *p = m_layout.line(line);
+            for (uint16_t n = m_layout.lineLength(line); n--; ++p)
+            {
+                char c = *p == '\t' ? ' ' : *p;
+                if (m_layout.advance(c))
+                    x += m_tft->drawChar(c, x, y, m_font);
+            }
+        }
+        if (x < right)
+            m_tft->fillRect(x, y, right - x, lineHeight, m_fillcolor);
+    }
+    if (y < bottom)
+        m_tft->fillRect(clip.x, y, clip.w, bottom - y, m_fillcolor);
+}
@@ -0,0 +1,190 @@
+#include "tile_canvas.h"
+
+#define PIXELS_PER_BYTE (8 / CANVAS_BPP)
+#define PIXEL_MASK (CANVAS_COLOURS - 1)
+
+TFT_Tile_Canvas::TFT_Tile_Canvas(void) : m_x(0),
+    m_y(0),
+    m_cols(0),
+    m_rows(0),
+    m_palette(),
+    m_map(),
+    m_dirty(),
+    m_used(0),
+    m_overflow(false),
+    m_spill(nullptr)
+{
+}
+
+void TFT_Tile_Canvas::init(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t palette[CANVAS_COLOURS])
+{
+    m_x = x;
+    m_y = y;
+    m_cols = w / CANVAS_TILE_SIZE;
+    m_rows = h / CANVAS_TILE_SIZE;
+    memcpy(m_palette, palette, sizeof(m_palette));
+    clear();
+}
+
+void TFT_Tile_Canvas::clear()
+{
+    for (uint16_t i = 0; i < CANVAS_MAX_TILES; ++i)
+        m_map[i] = CANVAS_NO_TILE;
+    m_used = 0;
+    m_overflow = false;
+    invalidate();
+}
+
+void TFT_Tile_Canvas::invalidate()
+{
+    memset(m_dirty, 0xFF, sizeof(m_dirty));
+}
+
+bool TFT_Tile_Canvas::contains(int16_t x, int16_t y)
+{
+    return x >= m_x && y >= m_y && x < m_x + m_cols * CANVAS_TILE_SIZE && y < m_y + m_rows * CANVAS_TILE_SIZE;
+}
+
+uint8_t TFT_Tile_Canvas::getPixel(int16_t x, int16_t y)
+{
+    if (!contains(x, y))
+        return 0;
+    x -= m_x;
+    y -= m_y;
+    uint16_t slot = m_map[(y / CANVAS_TILE_SIZE) * m_cols + x / CANVAS_TILE_SIZE];
+    if (slot == CANVAS_NO_TILE)
+        return 0;
+    uint16_t p = (y % CANVAS_TILE_SIZE) * CANVAS_TILE_SIZE + x % CANVAS_TILE_SIZE;
+    return (m_pool[slot][p / PIXELS_PER_BYTE] >> ((p % PIXELS_PER_BYTE) * CANVAS_BPP)) & PIXEL_MASK;
+}
+
+void TFT_Tile_Canvas::setPixel(int16_t x, int16_t y, uint8_t index)
+{
+    if (!contains(x, y))
+        return;
+    x -= m_x;
+    y -= m_y;
+    uint16_t tile = (y / CANVAS_TILE_SIZE) * m_cols + x / CANVAS_TILE_SIZE;
+    uint16_t slot = m_map[tile];
+    if (slot == CANVAS_NO_TILE)
+    {
+        // background on an empty tile changes nothing
+        if (index == 0)
+            return;
+        if (m_used == CANVAS_POOL_TILES)
+        {
+            m_overflow = true;
+            // the tile is never marked dirty, so flush() leaves this alone
+            if (m_spill)
+                m_spill->drawPixel(m_x + x, m_y + y, m_palette[index]);
+            return;
+        }
+        slot = m_map[tile] = m_used++;
+        memset(m_pool[slot], 0, CANVAS_TILE_BYTES);
+    }
+
+    uint16_t p = (y % CANVAS_TILE_SIZE) * CANVAS_TILE_SIZE + x % CANVAS_TILE_SIZE;
+    uint8_t shift = (p % PIXELS_PER_BYTE) * CANVAS_BPP;
+    uint8_t &b = m_pool[slot][p / PIXELS_PER_BYTE];
+    uint8_t updated = (b & ~(PIXEL_MASK << shift)) | ((index & PIXEL_MASK) << shift);
+    if (updated == b)
+        return;
+    b = updated;
+    markDirty(tile);
+}
+
+void TFT_Tile_Canvas::stamp(int16_t x, int16_t y, uint8_t index, uint8_t width)
+{
+    if (width <= 1)
+    {
+        setPixel(x, y, index);
+        return;
+    }
+    // round brush of the given diameter
+    int16_t r = width / 2;
+    int16_t r2 = r * r + r;
+    for (int16_t dy = -r; dy <= r; ++dy)
+    {
+        for (int16_t dx = -r; dx <= r; ++dx)
+        {
+            if (dx * dx + dy * dy <= r2)
+                setPixel(x + dx, y + dy, index);
+        }
+    }
+}
+
+void TFT_Tile_Canvas::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t index, uint8_t width)
+{
+    int16_t dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int16_t dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int16_t err = dx + dy;
+    while (true)
+    {
+        stamp(x0, y0, index, width);
+        if (x0 == x1 && y0 == y1)
+            break;
+        int16_t e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+uint16_t TFT_Tile_Canvas::flush(TFT_eSPI *tft, uint16_t maxTiles)
+{
+    uint16_t pixels[CANVAS_TILE_SIZE * CANVAS_TILE_SIZE];
+    uint16_t tiles = m_cols * m_rows;
+    uint16_t sent = 0;
+
+    tft->startWrite();
+    for (uint16_t tile = 0; tile < tiles && sent < maxTiles; ++tile)
+    {
+        if (!(m_dirty[tile >> 3] & (1 << (tile & 7))))
+        {
+            // skip clean bytes whole
+            if ((tile & 7) == 0 && !m_dirty[tile >> 3])
+                tile += 7;
+            continue;
+        }
+        m_dirty[tile >> 3] &= ~(1 << (tile & 7));
+        ++sent;
+
+        int16_t x = m_x + (tile % m_cols) * CANVAS_TILE_SIZE;
+        int16_t y = m_y + (tile / m_cols) * CANVAS_TILE_SIZE;
+        uint16_t slot = m_map[tile];
+        if (slot == CANVAS_NO_TILE)
+        {
+            // background only, merge with the dirty empty tiles after it on the row
+            uint16_t run = 1;
+            while ((tile + run) % m_cols && m_map[tile + run] == CANVAS_NO_TILE &&
+                   (m_dirty[(tile + run) >> 3] & (1 << ((tile + run) & 7))))
+            {
+                m_dirty[(tile + run) >> 3] &= ~(1 << ((tile + run) & 7));
+                ++run;
+            }
+            tft->fillRect(x, y, run * CANVAS_TILE_SIZE, CANVAS_TILE_SIZE, m_palette[0]);
+            sent += run - 1;
+            tile += run - 1;
+            continue;
+        }
+
+        const uint8_t *src = m_pool[slot];
+        for (uint16_t p = 0; p < CANVAS_TILE_SIZE * CANVAS_TILE_SIZE; p += PIXELS_PER_BYTE)
+        {
+            uint8_t b = *src++;
+            for (uint8_t i = 0; i < PIXELS_PER_BYTE; ++i, b >>= CANVAS_BPP)
+                pixels[p + i] = m_palette[b & PIXEL_MASK];
+        }
+        tft->setAddrWindow(x, y, CANVAS_TILE_SIZE, CANVAS_TILE_SIZE);
+        tft->pushColors(pixels, CANVAS_TILE_SIZE * CANVAS_TILE_SIZE);
+    }
+    tft->endWrite();
+    return sent;
+}
@@ -0,0 +1,131 @@
+#include "topic_router.h"
+
+#define LOG_MODULE "router"
+#include "logger.h"
+
+TopicRouter::TopicRouter(void) : m_routes(),
+    m_count(0),
+    m_slots(),
+    m_stats()
+{
+    memset(m_slots, TOPIC_ROUTER_EMPTY, sizeof(m_slots));
+}
+
+// 32-bit FNV-1a, measuring the topic on the way
+uint32_t TopicRouter::hash(const char *topic, size_t &length)
+{
+    uint32_t h = 2166136261u;
+    const char *p = topic;
+    for (; *p; ++p)
+    {
+        h ^= (uint8_t)*p;
+        h *= 16777619u;
+    }
+    length = p - topic;
+    return h;
+}
+
+uint8_t TopicRouter::find(const char *topic, uint32_t hash, size_t length, uint8_t *probes)
+{
+    for (uint8_t i = 0; i < TOPIC_ROUTER_SLOTS; ++i)
+    {
+        uint8_t route = m_slots[(hash + i) & (TOPIC_ROUTER_SLOTS - 1)];
+        if (route == TOPIC_ROUTER_EMPTY)
+            break;
+        const Route &r = m_routes[route];
+        if (r.hash == hash && r.length == length && memcmp(r.topic, topic, length) == 0)
+        {
+            if (probes)
+                *probes = i;
+            return route;
+        }
+    }
+    return TOPIC_ROUTER_EMPTY;
+}
+
+bool TopicRouter::add(const char *topic, TopicHandler handler, uint8_t partner, uint8_t qos)
+{
+    size_t length;
+    uint32_t h = hash(topic, length);
+    if (m_count == TOPIC_ROUTER_MAX_ROUTES || length >= MQTT_TOPIC_LEN || strpbrk(topic, "+#") ||
+        find(topic, h, length, nullptr) != TOPIC_ROUTER_EMPTY)
+    {
+        LOG_WARN("cannot route %s", topic);
+        return false;
+    }
+
+    Route &r = m_routes[m_count];
+    r.hash = h;
+    r.handler = handler;
+    r.length = length;
+    r.partner = partner;
+    r.qos = qos;
+    memcpy(r.topic, topic, length + 1);
+
+    uint32_t slot = h;
+    while (m_slots[slot & (TOPIC_ROUTER_SLOTS - 1)] != TOPIC_ROUTER_EMPTY)
+        ++slot;
+    m_slots[slot & (TOPIC_ROUTER_SLOTS - 1)] = m_count++;
+    return true;
+}
+
+// open addressing cannot simply empty a slot, a probe run would end there
+void TopicRouter::rebuild()
+{
+    memset(m_slots, TOPIC_ROUTER_EMPTY, sizeof(m_slots));
+    for (uint8_t route = 0; route < m_count; ++route)
+    {
+        uint32_t slot = m_routes[route].hash;
+        while (m_slots[slot & (TOPIC_ROUTER_SLOTS - 1)] != TOPIC_ROUTER_EMPTY)
+            ++slot;
+        m_slots[slot & (TOPIC_ROUTER_SLOTS - 1)] = route;
+    }
+}
+
+bool TopicRouter::remove(const char *topic)
+{
+    size_t length;
+    uint32_t h = hash(topic, length);
+    uint8_t route = find(topic, h, length, nullptr);
+    if (route == TOPIC_ROUTER_EMPTY)
+        return false;
+    // the last route moves into the gap
+    if (route != --m_count)
+        m_routes[route] = m_routes[m_count];
+    rebuild();
+    return true;
+}
+
+bool TopicRouter::subscribeAll(PubSubClient &client)
+{
+    for (uint8_t route = 0; route < m_count; ++route)
+    {
+        if (!client.subscribe(m_routes[route].topic, m_routes[route].qos))
+        {
+            LOG_WARN("subscribe %s failed", m_routes[route].topic);
+            return false;
+        }
+    }
+    LOG_DEBUG("%u topics subscribed", m_count);
+    return true;
+}
+
+bool TopicRouter::dispatch(const char *topic, const uint8_t *payload, uint32_t length)
+{
+    size_t topicLength;
+    uint32_t h = hash(topic, topicLength);
+    uint8_t probes = 0;
+    uint8_t route = find(topic, h, topicLength, &probes);
+    if (route == TOPIC_ROUTER_EMPTY)
+    {
+        ++m_stats.unrouted;
+        return false;
+    }
+    ++m_stats.routed;
+    m_stats.probes += probes;
+    m_stats.maxProbes = max(m_stats.maxProbes, probes);
+
+    const Route &r = m_routes[route];
+    r.handler(r.partner, r.topic, payload, length);
+    return true;
+}
@@ -0,0 +1,134 @@
+#include "touch_input.h"
+
+TouchInput *TouchInput::s_instance = nullptr;
+
+TouchInput::TouchInput(void) : m_tft(nullptr),
+    m_irqPin(-1),
+    m_penIrq(false),
+    m_penIrqUs(0),
+    m_sampling(0),
+    m_reads(0),
+    m_ring(),
+    m_head(0),
+    m_tail(0),
+    m_dropped(0),
+    m_down(false),
+    m_x(0),
+    m_y(0),
+    m_misses(0),
+    m_liftUs(0)
+{
+}
+
+void IRAM_ATTR TouchInput::onPenIrq()
+{
+    // no SPI in here, the next sample() does the read
+    if (s_instance)
+    {
+        s_instance->m_penIrqUs = micros();
+        s_instance->m_penIrq = true;
+    }
+}
+
+void TouchInput::begin(TFT_eSPI *tft, int8_t irqPin)
+{
+    m_tft = tft;
+    m_irqPin = irqPin;
+    if (m_irqPin >= 0)
+    {
+        s_instance = this;
+        pinMode(m_irqPin, INPUT_PULLUP);
+        attachInterrupt(digitalPinToInterrupt(m_irqPin), onPenIrq, FALLING);
+    }
+}
+
+void TouchInput::end()
+{
+    if (m_irqPin >= 0)
+        detachInterrupt(digitalPinToInterrupt(m_irqPin));
+    s_instance = nullptr;
+}
+
+void TouchInput::sample()
+{
+    // with the pen up the controller is left alone until the IRQ fires
+    bool pen = m_irqPin < 0 || m_penIrq || digitalRead(m_irqPin) == LOW;
+    if (!pen && m_sampling == 0)
+        return;
+    bool irq = m_penIrq;
+    uint32_t irqUs = m_penIrqUs;
+    m_penIrq = false;
+
+    uint32_t us = micros();
+    uint16_t x = 0, y = 0;
+    bool down = m_tft->getTouch(&x, &y);
+    ++m_reads;
+    // a glitch on the IRQ line, or polling with nobody there
+    if (!down && m_sampling == 0)
+        return;
+    // a press is dated from the IRQ, not from whenever the loop got to it
+    if (down && irq && m_sampling == 0)
+        us = irqUs;
+
+    bool queued = feed({us, (int16_t)x, (int16_t)y, down});
+    // with the ring full a lost move does no harm, but a lost miss would
+    // leave the pen down, so misses are taken again until they fit
+    if (down)
+        m_sampling = TOUCH_RELEASE_SAMPLES;
+    else if (queued)
+        --m_sampling;
+}
+
+bool TouchInput::feed(const TouchSample &sample)
+{
+    uint8_t head = m_head.load(std::memory_order_relaxed);
+    uint8_t next = (head + 1) % TOUCH_RING_SLOTS;
+    if (next == m_tail.load(std::memory_order_acquire))
+    {
+        ++m_dropped;
+        return false;
+    }
+    m_ring[head] = sample;
+    m_head.store(next, std::memory_order_release);
+    return true;
+}
+
+bool TouchInput::pop(TouchSample &sample)
+{
+    uint8_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire))
+        return false;
+    sample = m_ring[tail];
+    m_tail.store((tail + 1) % TOUCH_RING_SLOTS, std::memory_order_release);
+    return true;
+}
+
+bool TouchInput::read(TouchEvent &event)
+{
+    TouchSample sample;
+    while (pop(sample))
+    {
+        if (!sample.down)
+        {
+            if (!m_down)
+                continue;
+            if (m_misses++ == 0)
+                m_liftUs = sample.us;
+            if (m_misses < TOUCH_RELEASE_SAMPLES)
+                continue;
+            m_down = false;
+            event = {TouchEvent::Release, m_x, m_y, m_liftUs};
+            return true;
+        }
+
+        m_misses = 0;
+        if (m_down && abs(sample.x - m_x) < TOUCH_MOVE_MIN && abs(sample.y - m_y) < TOUCH_MOVE_MIN)
+            continue;
+        event = {m_down ? TouchEvent::Move : TouchEvent::Press, sample.x, sample.y, sample.us};
+        m_down = true;
+        m_x = sample.x;
+        m_y = sample.y;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,269 @@
+#include "widget.h"
+
+TFT_Rect TFT_Rect::intersect(const TFT_Rect &r) const
+{
+    int16_t left = max(x, r.x);
+    int16_t top = max(y, r.y);
+    int16_t right = min(x + w, r.x + r.w);
+    int16_t bottom = min(y + h, r.y + r.h);
+    if (right <= left || bottom <= top)
+        return TFT_Rect();
+    return TFT_Rect{left, top, (int16_t)(right - left), (int16_t)(bottom - top)};
+}
+
+TFT_Rect TFT_Rect::unite(const TFT_Rect &r) const
+{
+    if (r.empty())
+        return *this;
+    if (empty())
+        return r;
+    int16_t left = min(x, r.x);
+    int16_t top = min(y, r.y);
+    int16_t right = max(x + w, r.x + r.w);
+    int16_t bottom = max(y + h, r.y + r.h);
+    return TFT_Rect{left, top, (int16_t)(right - left), (int16_t)(bottom - top)};
+}
+
+TFT_Widget::TFT_Widget(void) : m_tft(nullptr),
+    m_bounds(),
+    m_opaque(false),
+    m_parent(nullptr),
+    m_firstChild(nullptr),
+    m_next(nullptr),
+    m_visible(true),
+    m_dirty(true),
+    m_changed(false),
+    m_laststate(false),
+    m_currstate(false),
+    m_exposed()
+{
+}
+
+void TFT_Widget::add(TFT_Widget *child)
+{
+    if (child->m_parent || child == this)
+        return;
+    child->m_parent = this;
+    TFT_Widget **link = &m_firstChild;
+    while (*link)
+        link = &(*link)->m_next;
+    *link = child;
+    child->invalidate();
+}
+
+void TFT_Widget::setBounds(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    TFT_Rect bounds = {x, y, w, h};
+    if (bounds.x != m_bounds.x || bounds.y != m_bounds.y || bounds.w != m_bounds.w || bounds.h != m_bounds.h)
+    {
+        if (m_visible)
+            m_exposed = m_exposed.unite(m_bounds);
+        m_bounds = bounds;
+    }
+    invalidate();
+}
+
+void TFT_Widget::setVisible(bool visible)
+{
+    if (visible == m_visible)
+        return;
+    m_visible = visible;
+    if (visible)
+        invalidate();
+    else
+        m_exposed = m_exposed.unite(m_bounds);
+}
+
+TFT_Screen::TFT_Screen(void) : m_background(TFT_BLACK),
+    m_damage(),
+    m_damageCount(0),
+    m_coverReached(false),
+    m_stats()
+{
+    m_opaque = true;
+}
+
+void TFT_Screen::init(TFT_eSPI *gfx, uint16_t background)
+{
+    m_tft = gfx;
+    m_background = background;
+    m_damageCount = 0;
+    setBounds(0, 0, gfx->width(), gfx->height());
+}
+
+void TFT_Screen::paint(const TFT_Rect &clip)
+{
+    m_tft->fillRect(clip.x, clip.y, clip.w, clip.h, m_background);
+}
+
+void TFT_Screen::collect(TFT_Widget *widget)
+{
+    if (!widget->m_exposed.empty())
+    {
+        addDamage(widget->m_exposed, nullptr);
+        widget->m_exposed = TFT_Rect();
+    }
+    // a hidden widget is invalidated again when it is shown
+    if (!widget->m_visible)
+        return;
+    if (widget->m_dirty)
+    {
+        addDamage(widget->m_bounds, widget->m_opaque ? widget : nullptr);
+        widget->m_dirty = false;
+    }
+    for (TFT_Widget *child = widget->m_firstChild; child; child = child->m_next)
+        collect(child);
+}
+
+void TFT_Screen::removeDamage(uint8_t i)
+{
+    for (--m_damageCount; i < m_damageCount; ++i)
+        m_damage[i] = m_damage[i + 1];
+}
+
+void TFT_Screen::addDamage(TFT_Rect rect, TFT_Widget *cover)
+{
+    rect = rect.intersect(m_bounds);
+    if (rect.empty())
+        return;
+
+    // rectangles are kept apart so nothing is painted twice in a frame
+    int8_t merge = -1;
+    for (uint8_t i = 0; i < m_damageCount; ++i)
+    {
+        Damage &d = m_damage[i];
+        if (d.rect.covers(rect) && (!d.cover || d.cover == cover))
+            return;
+        if (d.rect.intersects(rect))
+        {
+            merge = i;
+            break;
+        }
+    }
+
+    // out of room, grow whichever rectangle grows least
+    if (merge < 0 && m_damageCount == WIDGET_MAX_DAMAGE)
+    {
+        uint32_t best = 0xFFFFFFFF;
+        for (uint8_t i = 0; i < m_damageCount; ++i)
+        {
+            uint32_t growth = m_damage[i].rect.unite(rect).area() - m_damage[i].rect.area();
+            if (growth < best)
+            {
+                best = growth;
+                merge = i;
+            }
+        }
+    }
+
+    if (merge < 0)
+    {
+        m_damage[m_damageCount++] = Damage{rect, cover};
+        return;
+    }
+
+    // the union is more than any one widget covers, and may now reach other
+    // rectangles, add it again
+    TFT_Rect united = m_damage[merge].rect.unite(rect);
+    removeDamage(merge);
+    ++m_stats.merged;
+    addDamage(united, nullptr);
+}
+
+uint8_t TFT_Screen::paintTree(TFT_Widget *widget, const Damage &damage)
+{
+    if (!widget->m_visible || !widget->m_bounds.intersects(damage.rect))
+        return 0;
+
+    uint8_t drawn = 0;
+    // widgets before the cover, its parents and the siblings under it, are
+    // hidden by it
+    if (!damage.cover || damage.cover == widget || m_coverReached)
+    {
+        m_coverReached = true;
+        widget->paint(widget->m_bounds.intersect(damage.rect));
+        // a paint cut short by the clip leaves the rest of a change to update()
+        if (damage.rect.covers(widget->m_bounds))
+            widget->m_changed = false;
+        ++m_stats.painted;
+        ++drawn;
+    }
+    for (TFT_Widget *child = widget->m_firstChild; child; child = child->m_next)
+        drawn += paintTree(child, damage);
+    return drawn;
+}
+
+void TFT_Screen::updateTree(TFT_Widget *widget, uint32_t start, uint32_t budgetUs, uint8_t &drawn)
+{
+    if (!widget->m_visible)
+        return;
+    if (widget->m_changed)
+    {
+        if (drawn && micros() - start >= budgetUs)
+        {
+            ++m_stats.deferred;
+        }
+        else
+        {
+            widget->m_changed = false;
+            widget->update();
+            ++m_stats.updated;
+            ++drawn;
+        }
+    }
+    for (TFT_Widget *child = widget->m_firstChild; child; child = child->m_next)
+        updateTree(child, start, budgetUs, drawn);
+}
+
+bool TFT_Screen::pendingIn(TFT_Widget *widget)
+{
+    if (!widget->m_exposed.empty())
+        return true;
+    if (!widget->m_visible)
+        return false;
+    if (widget->isDirty())
+        return true;
+    for (TFT_Widget *child = widget->m_firstChild; child; child = child->m_next)
+    {
+        if (pendingIn(child))
+            return true;
+    }
+    return false;
+}
+
+bool TFT_Screen::pending()
+{
+    return m_damageCount || pendingIn(this);
+}
+
+uint8_t TFT_Screen::render(uint32_t budgetUs)
+{
+    if (!m_tft)
+        return 0;
+
+    collect(this);
+    uint32_t start = micros();
+    uint8_t drawn = 0;
+    while (m_damageCount)
+    {
+        if (drawn && micros() - start >= budgetUs)
+        {
+            m_stats.deferred += m_damageCount;
+            break;
+        }
+        Damage damage = m_damage[0];
+        removeDamage(0);
+        m_coverReached = false;
+        drawn += paintTree(this, damage);
+        m_stats.pixels += damage.rect.area();
+    }
+    updateTree(this, start, budgetUs, drawn);
+
+    if (!drawn)
+        return 0;
+    uint32_t took = micros() - start;
+    ++m_stats.frames;
+    m_stats.lastFrameUs = took;
+    m_stats.maxFrameUs = max(m_stats.maxFrameUs, took);
+    return drawn;
+}
@@ -0,0 +1,78 @@
+#include "wifi_connection.h"
+
+WifiConnection::WifiConnection(void) : m_state(Idle),
+    m_ssid(),
+    m_retries(0),
+    m_beginMs(0),
+    m_lastRetryMs(0),
+    m_bootToConnectedMs(0),
+    m_lastConnectMs(0),
+    m_onProgress(nullptr),
+    m_onResult(nullptr)
+{
+}
+
+void WifiConnection::begin(const String &ssid, const String &password)
+{
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(ssid, password);
+
+    m_ssid = ssid;
+    m_state = Connecting;
+    m_retries = 0;
+    m_beginMs = millis();
+    m_lastRetryMs = m_beginMs;
+}
+
+void WifiConnection::cancel()
+{
+    if (m_state != Connecting)
+        return;
+    WiFi.disconnect();
+    finish(Cancelled, WiFi.status());
+}
+
+void WifiConnection::finish(State state, wl_status_t status)
+{
+    m_state = state;
+    if (m_onResult)
+        m_onResult(state, status);
+}
+
+void WifiConnection::tick()
+{
+    wl_status_t status = WiFi.status();
+
+    if (m_state == Connected)
+    {
+        // link lost, whoever drives the UI decides whether to reconnect
+        if (status != WL_CONNECTED)
+            m_state = Idle;
+        return;
+    }
+
+    if (m_state != Connecting)
+        return;
+
+    uint32_t now = millis();
+    if (status == WL_CONNECTED)
+    {
+        m_lastConnectMs = now - m_beginMs;
+        if (m_bootToConnectedMs == 0)
+            m_bootToConnectedMs = now;
+        finish(Connected, status);
+        return;
+    }
+
+    if (now - m_lastRetryMs < WIFI_RETRY_INTERVAL_MS)
+        return;
+    m_lastRetryMs = now;
+
+    if (m_onProgress)
+        m_onProgress(m_ssid, m_retries);
+    if (++m_retries >= WIFI_CONNECT_RETRIES)
+    {
+        WiFi.disconnect();
+        finish(Failed, status);
+    }
+}
@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""Turns the records of a -D LOG_BINARY build back into the text a default
+build would have printed.
+
+    pio device monitor --raw | tools/log_decode.py .pio/build/nodemcuv2/firmware.elf
+    tools/log_decode.py firmware.elf capture.bin
+
+Records carry no text, only where their format string sits relative to the
+logAnchor symbol, so the ELF has to be the one the device runs. Anything
+between records (boot ROM output, a crash dump) is passed through as it is.
+"""
+
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+HEADER = 11  # sync, length, level, micros, format offset
+LEVELS = "-EWID"
+SHT_NOBITS = 8
+SHF_ALLOC = 2
+
+CONVERSION = re.compile(rb"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|z|j|t)?([diuxXocsfegp%])")
+
+
+class Elf:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError(path + " is not an ELF file")
+        self.wide = self.data[4] == 2
+        if self.wide:
+            shoff, = struct.unpack_from("<Q", self.data, 0x28)
+            shentsize, shnum = struct.unpack_from("<HH", self.data, 0x3A)
+        else:
+            shoff, = struct.unpack_from("<I", self.data, 0x20)
+            shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            at = shoff + i * shentsize
+            if self.wide:
+                _, kind, flags, addr, offset, size, link = struct.unpack_from("<IIQQQQI", self.data, at)
+            else:
+                _, kind, flags, addr, offset, size, link = struct.unpack_from("<IIIIIII", self.data, at)
+            self.sections.append((kind, flags, addr, offset, size, link))
+        self.anchor = self.symbol(b"logAnchor")
+
+    def symbol(self, name):
+        for kind, _, _, offset, size, link in self.sections:
+            if kind != 2:  # SHT_SYMTAB
+                continue
+            strtab = self.sections[link][3]
+            entry = 24 if self.wide else 16
+            for at in range(offset, offset + size, entry):
+                if self.wide:
+                    index, _, _, _, value = struct.unpack_from("<IBBHQ", self.data, at)
+                else:
+                    index, value = struct.unpack_from("<II", self.data, at)
+                end = self.data.index(b"\0", strtab + index)
+                if self.data[strtab + index:end] == name:
+                    return value
+        raise ValueError("no logAnchor symbol, was the firmware built with -D LOG_BINARY?")
+
+    def string(self, addr):
+        for kind, flags, start, offset, size, _ in self.sections:
+            if kind != SHT_NOBITS and flags & SHF_ALLOC and start <= addr < start + size:
+                at = offset + addr - start
+                end = self.data.find(b"\0", at, offset + size)
+                if end >= 0:
+                    return self.data[at:end]
+        return None
+
+
+def format_record(fmt, args):
+    out = []
+    last = 0
+    at = 0
+
+    def take(size, kind):
+        nonlocal at
+        if at + size > len(args):
+            at = len(args)
+            return None
+        value, = struct.unpack_from(kind, args, at)
+        at += size
+        return value
+
+    for m in CONVERSION.finditer(fmt):
+        out.append(fmt[last:m.start()].decode("latin-1"))
+        last = m.end()
+        flags, width, precision, length, conversion = m.groups()
+        conversion = conversion.decode()
+        if conversion == "%":
+            out.append("%")
+            continue
+        if width == b"*":
+            width = take(4, "<i")
+            width = b"" if width is None else str(width).encode()
+        if precision == b"*":
+            precision = take(4, "<i")
+            precision = b"" if precision is None else str(precision).encode()
+        spec = "%" + (flags + (width or b"")).decode()
+        if precision is not None:
+            spec += "." + precision.decode()
+        wide = length in (b"ll", b"j")
+        if conversion in "di":
+            value = take(8, "<q") if wide else take(4, "<i")
+            spec += "d"
+        elif conversion in "uxXo":
+            value = take(8, "<Q") if wide else take(4, "<I")
+            spec += "d" if conversion == "u" else conversion
+        elif conversion in "feg":
+            value = take(8, "<d")
+            spec += conversion
+        elif conversion == "c":
+            value = take(1, "<B")
+            value = None if value is None else chr(value)
+            spec += "c"
+        elif conversion == "p":
+            value = take(4, "<I")
+            spec = "0x%x"
+        else:  # s
+            end = args.find(b"\0", at)
+            if end < 0:
+                value = None
+                at = len(args)
+            else:
+                value = args[at:end].decode("latin-1")
+                at = end + 1
+            spec += "s"
+        out.append("?" if value is None else spec % value)
+    out.append(fmt[last:].decode("latin-1"))
+    return "".join(out)
+
+
+def decode(elf, stream, out):
+    pending = b""
+    while True:
+        chunk = stream.read1(4096) if hasattr(stream, "read1") else stream.read(4096)
+        if not chunk:
+            break
+        pending += chunk
+        while pending:
+            sync = pending.find(bytes([SYNC]))
+            if sync < 0:
+                out.write(pending)
+                pending = b""
+                break
+            out.write(pending[:sync])
+            pending = pending[sync:]
+            if len(pending) < 2:
+                break
+            length = pending[1]
+            if length < HEADER:
+                out.write(pending[:1])
+                pending = pending[1:]
+                continue
+            if len(pending) < length:
+                break
+            level, micros, offset = struct.unpack_from("<BIi", pending, 2)
+            fmt = elf.string(elf.anchor + offset) if level < len(LEVELS) else None
+            if fmt is None:
+                # not a record after all
+                out.write(pending[:1])
+                pending = pending[1:]
+                continue
+            ms = micros // 1000
+            line = "[%5d.%03d] %s %s\n" % (ms // 1000, ms % 1000, LEVELS[level],
+                                           format_record(fmt, pending[HEADER:length]))
+            out.write(line.encode("latin-1"))
+            pending = pending[length:]
+        out.flush()
+    out.write(pending)
+    out.flush()
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit(__doc__)
+    elf = Elf(sys.argv[1])
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], "rb") as stream:
+            decode(elf, stream, sys.stdout.buffer)
+    else:
+        decode(elf, sys.stdin.buffer, sys.stdout.buffer)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""Converts a PNG into a picture message the device draws as it arrives,
+the format described in include/image_decoder.h.
+
+    tools/png2mbi.py photo.png photo.mbi
+    tools/png2mbi.py --rgb565 --background ffffff logo.png logo.mbi
+
+Colours are reduced to RGB565. An image with 256 colours or fewer after
+that is sent as a palette with a byte per pixel, anything else as RGB565.
+Transparent pixels are blended onto the background colour. Only the
+standard library is needed.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+MAGIC = 0x49
+VERSION = 1
+RGB565 = 0
+PALETTE = 1
+MAX_WIDTH = 480
+MAX_PACKET = 128
+
+
+def read_png(path):
+    """Returns width, height and rows of (r, g, b, a) tuples."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError(path + " is not a PNG")
+    pos = 8
+    idat = b""
+    plte = []
+    trns = b""
+    while pos < len(data):
+        length, kind = struct.unpack_from(">I4s", data, pos)
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            width, height, depth, colour, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif kind == b"PLTE":
+            plte = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif kind == b"tRNS":
+            trns = body
+        elif kind == b"IDAT":
+            idat += body
+        elif kind == b"IEND":
+            break
+    if interlace:
+        raise ValueError("interlaced PNGs are not supported")
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[colour]
+    bits = channels * depth
+    stride = (width * bits + 7) // 8
+    step = max(1, bits // 8)
+    raw = zlib.decompress(idat)
+    rows = []
+    prior = bytearray(stride)
+    for y in range(height):
+        base = y * (stride + 1)
+        kind = raw[base]
+        line = bytearray(raw[base + 1:base + 1 + stride])
+        for i in range(stride):
+            a = line[i - step] if i >= step else 0
+            b = prior[i]
+            c = prior[i - step] if i >= step else 0
+            if kind == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif kind == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif kind == 3:
+                line[i] = (line[i] + (a + b) // 2) & 0xFF
+            elif kind == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                line[i] = (line[i] + (a if pa <= pb and pa <= pc else b if pb <= pc else c)) & 0xFF
+        prior = line
+        rows.append([pixel(line, x, depth, colour, plte, trns) for x in range(width)])
+    return width, height, rows
+
+
+def sample(line, index, depth):
+    if depth == 8:
+        return line[index]
+    if depth == 16:
+        return line[index * 2]
+    per = 8 // depth
+    shift = 8 - depth * (index % per + 1)
+    value = (line[index // per] >> shift) & ((1 << depth) - 1)
+    return value * 255 // ((1 << depth) - 1)
+
+
+def pixel(line, x, depth, colour, plte, trns):
+    if colour == 3:
+        per = 8 // depth
+        index = (line[x // per] >> (8 - depth * (x % per + 1))) & ((1 << depth) - 1) if depth < 8 else line[x]
+        alpha = trns[index] if index < len(trns) else 255
+        return plte[index] + (alpha,)
+    channels = {0: 1, 2: 3, 4: 2, 6: 4}[colour]
+    values = [sample(line, x * channels + i, depth) for i in range(channels)]
+    if colour == 0:
+        return (values[0], values[0], values[0], 255)
+    if colour == 4:
+        return (values[0], values[0], values[0], values[1])
+    if colour == 2:
+        return tuple(values) + (255,)
+    return tuple(values)
+
+
+def rgb565(rgba, background):
+    r, g, b, a = rgba
+    r, g, b = ((c * a + bg * (255 - a) + 127) // 255 for c, bg in zip((r, g, b), background))
+    return (r * 31 + 127) // 255 << 11 | (g * 63 + 127) // 255 << 5 | (b * 31 + 127) // 255
+
+
+def encode_row(row, put, min_run):
+    """Packets for one row: repeats for runs of min_run or more, literals
+    between them."""
+    out = bytearray()
+    i = 0
+    while i < len(row):
+        run = 1
+        while i + run < len(row) and run < MAX_PACKET and row[i + run] == row[i]:
+            run += 1
+        if run >= min_run:
+            out.append(127 + run)
+            put(out, row[i])
+            i += run
+            continue
+        start = i
+        while i < len(row) and i - start < MAX_PACKET:
+            run = 1
+            while i + run < len(row) and run < min_run and row[i + run] == row[i]:
+                run += 1
+            if run >= min_run:
+                break
+            i += 1
+        out.append(i - start - 1)
+        for p in row[start:i]:
+            put(out, p)
+    return out
+
+
+def encode(width, height, pixels, force_rgb565):
+    colours = sorted(set(p for row in pixels for p in row))
+    palettized = len(colours) <= 256 and not force_rgb565
+    header = struct.pack("<BBBBHH", MAGIC, VERSION, PALETTE if palettized else RGB565,
+                         len(colours) - 1 if palettized else 0, width, height)
+    out = bytearray(header)
+    if palettized:
+        index = {c: i for i, c in enumerate(colours)}
+        for c in colours:
+            out += struct.pack("<H", c)
+        rows = [[index[p] for p in row] for row in pixels]
+        # a repeat of two is no shorter than two literal bytes
+        for row in rows:
+            out += encode_row(row, lambda o, p: o.append(p), 3)
+    else:
+        for row in pixels:
+            out += encode_row(row, lambda o, p: o.extend(struct.pack("<H", p)), 2)
+    return bytes(out), palettized, len(colours)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("png")
+    parser.add_argument("mbi")
+    parser.add_argument("--rgb565", action="store_true", help="never use a palette")
+    parser.add_argument("--background", default="000000", help="RRGGBB under transparent pixels")
+    args = parser.parse_args()
+
+    width, height, rows = read_png(args.png)
+    if width > MAX_WIDTH or height > 0xFFFF:
+        sys.exit("%s is %dx%d, the device takes images up to %d wide" % (args.png, width, height, MAX_WIDTH))
+    background = bytes.fromhex(args.background)
+    pixels = [[rgb565(p, background) for p in row] for row in rows]
+    data, palettized, colours = encode(width, height, pixels, args.rgb565)
+    with open(args.mbi, "wb") as f:
+        f.write(data)
+    sys.stderr.write("%dx%d, %d colours, %s: %d B, %.1f%% of raw RGB565\n" % (
+        width, height, colours, "palette" if palettized else "RGB565", len(data),
+        100.0 * len(data) / (width * height * 2)))
+
+
+if __name__ == "__main__":
+    main()
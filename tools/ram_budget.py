@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""Fails the firmware build when its static RAM passes the budget.
+
+    extra_scripts = post:tools/ram_budget.py    (platformio.ini)
+    tools/ram_budget.py .pio/build/nodemcuv2/firmware.elf 51200
+
+On the ESP8266 .data, .rodata and .bss all live in the 80 KB of DRAM, and
+whatever they take is not heap. The TLS handshake alone wants about 20 KB
+of heap on top of Wi-Fi, so the budget (custom_ram_budget, bytes) is what
+can be given to statics before connecting starts to fail at run time.
+"""
+
+import struct
+import sys
+
+DRAM_SECTIONS = (".data", ".rodata", ".bss")
+
+
+def dram_sections(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF" or data[4] != 1:
+        raise ValueError("%s is not a 32-bit ELF" % path)
+    shoff, = struct.unpack_from("<I", data, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+
+    def header(i):
+        return struct.unpack_from("<IIIIIIIIII", data, shoff + i * shentsize)
+
+    names = header(shstrndx)[4]
+    sizes = {}
+    for i in range(shnum):
+        name_offset, _, _, _, _, size = header(i)[:6]
+        end = data.index(b"\0", names + name_offset)
+        name = data[names + name_offset:end].decode()
+        if name in DRAM_SECTIONS:
+            sizes[name] = size
+    return sizes
+
+
+def check(path, budget):
+    sizes = dram_sections(path)
+    used = sum(sizes.values())
+    detail = ", ".join("%s %d" % (name, sizes.get(name, 0)) for name in DRAM_SECTIONS)
+    print("static RAM %d of %d B budget (%s)" % (used, budget, detail))
+    if used > budget:
+        print("static RAM is %d B over budget, the heap left will not hold a TLS handshake" % (used - budget))
+        return False
+    return True
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    sys.exit(0 if check(sys.argv[1], int(sys.argv[2])) else 1)
+else:
+    Import("env")  # noqa: F821, only defined when PlatformIO runs this
+
+    def after_link(source, target, env):
+        budget = int(env.GetProjectOption("custom_ram_budget"))
+        if not check(str(target[0]), budget):
+            env.Exit(1)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", after_link)  # noqa: F821